@@ -0,0 +1,183 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+#include "knitrocpp/spsc_queue.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace knitrocpp
+{
+
+using LogSink = std::function<void(const std::string&)>;
+
+/**
+ * Class for writing log messages to a sink from a background thread.
+ *
+ * Messages may be written concurrently (Knitro calls the puts callback from
+ * several threads): the producers are serialized by a mutex and copy their
+ * message into a bounded lock-free queue. The background thread sleeps
+ * while the queue is empty and producers only notify it when it sleeps.
+ * When the queue is full, the message is either dropped, or the producer
+ * waits for the background thread to make room.
+ */
+class AsyncLog
+{
+
+public:
+
+    /** Constructor. */
+    AsyncLog(
+            LogSink sink,
+            std::size_t capacity = 1024,
+            bool drop_on_backpressure = false):
+        sink_(sink),
+        drop_on_backpressure_(drop_on_backpressure),
+        queue_(capacity),
+        thread_(&AsyncLog::run, this) { }
+
+    /** Destructor; write all pending messages to the sink. */
+    ~AsyncLog()
+    {
+        stop_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            condition_variable_.notify_one();
+        }
+        thread_.join();
+    }
+
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+    /** Write a message; it may be called concurrently. */
+    void write(const char* const message)
+    {
+        std::lock_guard<std::mutex> producer_lock(producer_mutex_);
+        std::string* slot = queue_.producer_slot();
+        if (slot == nullptr) {
+            if (drop_on_backpressure_) {
+                number_of_dropped_messages_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            producer_waiting_.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            space_condition_variable_.wait(
+                    lock,
+                    [this, &slot]()
+                    {
+                        slot = queue_.producer_slot();
+                        return slot != nullptr;
+                    });
+            producer_waiting_.store(false);
+        }
+        slot->assign(message);
+        queue_.push();
+        // Pairs with the fence of the background thread before it checks
+        // the queue a last time and sleeps.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumer_sleeping_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            condition_variable_.notify_one();
+        }
+    }
+
+    /** Get the number of messages dropped because the queue was full. */
+    std::size_t number_of_dropped_messages() const
+    {
+        return number_of_dropped_messages_.load();
+    }
+
+private:
+
+    /** Sink. */
+    LogSink sink_;
+
+    /** Drop messages when the queue is full instead of waiting. */
+    bool drop_on_backpressure_;
+
+    /** Mutex serializing the producers. */
+    std::mutex producer_mutex_;
+
+    /** Pending messages. */
+    detail::SpscQueue<std::string> queue_;
+
+    /** Number of messages dropped. */
+    std::atomic<std::size_t> number_of_dropped_messages_ {0};
+
+    /** Boolean set when the log is destroyed. */
+    std::atomic<bool> stop_ {false};
+
+    /** Boolean set while the background thread sleeps. */
+    std::atomic<bool> consumer_sleeping_ {false};
+
+    /** Boolean set while a producer waits for room in the queue. */
+    std::atomic<bool> producer_waiting_ {false};
+
+    /**
+     * Mutex and condition variables used to wake up the background thread
+     * and a producer waiting for room.
+     */
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+    std::condition_variable space_condition_variable_;
+
+    /** Background thread. */
+    std::thread thread_;
+
+    void run()
+    {
+        for (;;) {
+            bool stop = stop_.load();
+            std::string* message = nullptr;
+            while ((message = queue_.consumer_slot()) != nullptr) {
+                sink_(*message);
+                queue_.pop();
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (producer_waiting_.load(std::memory_order_relaxed)) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    space_condition_variable_.notify_one();
+                }
+            }
+            if (stop)
+                return;
+            std::unique_lock<std::mutex> lock(mutex_);
+            consumer_sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // Check the queue again, so that a message pushed before the
+            // producer could see consumer_sleeping_ is not missed.
+            if (queue_.consumer_slot() == nullptr && !stop_.load())
+                condition_variable_.wait(lock);
+            consumer_sleeping_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+};
+
+/**
+ * Send the output of Knitro to an asynchronous log instead of stdout.
+ *
+ * The solver thread only copies each message into the queue of the log.
+ * This replaces the callback set with Context::set_puts_callback. The log
+ * must outlive the solve.
+ */
+inline void set_log_sink(
+        Context& knitro_context,
+        AsyncLog& log)
+{
+    AsyncLog* log_pointer = &log;
+    knitro_context.set_puts_callback(
+            [log_pointer](const char* const message)
+            {
+                log_pointer->write(message);
+                return (int)std::char_traits<char>::length(message);
+            });
+}
+
+}
@@ -0,0 +1,567 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace knitrocpp
+{
+
+/**
+ * Structure for the parameters of a bound tightening.
+ */
+struct BoundTighteningParameters
+{
+    /** Maximum number of times each constraint is propagated on average. */
+    double maximum_number_of_passes = 16;
+
+    /**
+     * Minimum improvement of a bound of a continuous variable, relative to
+     * max(1, |bound|), for it to be changed.
+     */
+    double minimum_relative_improvement = 1e-3;
+
+    /** Implied bounds larger than this value in magnitude are discarded. */
+    double maximum_bound = 1e15;
+
+    /** Tolerance used for integer rounding and infeasibility detection. */
+    double tolerance = 1e-9;
+};
+
+/**
+ * Structure for the output of a bound tightening.
+ */
+struct BoundTighteningOutput
+{
+    /** Tightened bounds. */
+    std::vector<double> variable_lower_bounds;
+    std::vector<double> variable_upper_bounds;
+
+    /** Number of lower bounds changed. */
+    VariableId number_of_tightened_lower_bounds = 0;
+
+    /** Number of upper bounds changed. */
+    VariableId number_of_tightened_upper_bounds = 0;
+
+    /** Number of constraint propagations. */
+    std::size_t number_of_propagations = 0;
+
+    /** Boolean indicating if the propagation proved the model infeasible. */
+    bool infeasible = false;
+};
+
+/**
+ * Class for a feasibility-based bound tightening.
+ *
+ * Each constraint is written as a sum of terms (a x_i or q x_i x_j) plus a
+ * constant. The interval of each term implied by the constraint bounds and
+ * the intervals of the other terms is used to tighten the bounds of its
+ * variables. Constraints whose variable bounds changed are queued again,
+ * so the cost is proportional to the number of nonzeros times the number
+ * of passes.
+ */
+class BoundTightener
+{
+
+public:
+
+    /**
+     * Constructor.
+     *
+     * Constraints for which skipped_constraints is non-zero are not
+     * propagated; skipped_constraints may be left empty.
+     */
+    BoundTightener(
+            const Model& model,
+            const std::vector<char>& skipped_constraints = {}):
+        model_(model),
+        skipped_constraints_(skipped_constraints)
+    {
+        build_rows();
+    }
+
+    /** Run the propagation. */
+    BoundTighteningOutput run(
+            const BoundTighteningParameters& parameters = BoundTighteningParameters())
+    {
+        parameters_ = parameters;
+        VariableId number_of_variables = model_.number_of_variables();
+        ConstraintId number_of_constraints = model_.number_of_constraints();
+        lower_bounds_.resize(number_of_variables);
+        upper_bounds_.resize(number_of_variables);
+        for (VariableId variable_id = 0;
+                variable_id < number_of_variables;
+                ++variable_id) {
+            lower_bounds_[variable_id] = from_knitro(model_.variable_lower_bounds[variable_id]);
+            upper_bounds_[variable_id] = from_knitro(model_.variable_upper_bounds[variable_id]);
+        }
+        infeasible_ = false;
+
+        queue_.clear();
+        queued_.assign(number_of_constraints, 0);
+        for (ConstraintId constraint_id = number_of_constraints - 1;
+                constraint_id >= 0;
+                --constraint_id) {
+            if (!is_skipped(constraint_id)) {
+                queue_.push_back(constraint_id);
+                queued_[constraint_id] = 1;
+            }
+        }
+        std::size_t maximum_number_of_propagations
+            = (std::size_t)(parameters_.maximum_number_of_passes * queue_.size());
+        BoundTighteningOutput output;
+        std::size_t queue_position = 0;
+        while (queue_position < queue_.size()
+                && output.number_of_propagations < maximum_number_of_propagations
+                && !infeasible_) {
+            ConstraintId constraint_id = queue_[queue_position++];
+            queued_[constraint_id] = 0;
+            propagate(constraint_id);
+            output.number_of_propagations++;
+            // Compact the queue once half of it has been processed.
+            if (queue_position > 1024 && 2 * queue_position > queue_.size()) {
+                queue_.erase(queue_.begin(), queue_.begin() + queue_position);
+                queue_position = 0;
+            }
+        }
+
+        output.infeasible = infeasible_;
+        output.variable_lower_bounds.resize(number_of_variables);
+        output.variable_upper_bounds.resize(number_of_variables);
+        for (VariableId variable_id = 0;
+                variable_id < number_of_variables;
+                ++variable_id) {
+            double lower_bound = to_knitro(lower_bounds_[variable_id]);
+            double upper_bound = to_knitro(upper_bounds_[variable_id]);
+            output.variable_lower_bounds[variable_id] = lower_bound;
+            output.variable_upper_bounds[variable_id] = upper_bound;
+            if (lower_bound > model_.variable_lower_bounds[variable_id])
+                output.number_of_tightened_lower_bounds++;
+            if (upper_bound < model_.variable_upper_bounds[variable_id])
+                output.number_of_tightened_upper_bounds++;
+        }
+        return output;
+    }
+
+private:
+
+    /** Structure for a term a x_i (variable_id_2 == -1) or q x_i x_j. */
+    struct Term
+    {
+        VariableId variable_id_1;
+        VariableId variable_id_2;
+        double coefficient;
+    };
+
+    /** Model. */
+    const Model& model_;
+
+    /** Skipped constraints. */
+    std::vector<char> skipped_constraints_;
+
+    /** Parameters. */
+    BoundTighteningParameters parameters_;
+
+    /** Terms of each constraint. */
+    std::vector<std::size_t> row_starts_;
+    std::vector<Term> row_terms_;
+
+    /** Constraints of each variable. */
+    std::vector<std::size_t> column_starts_;
+    std::vector<ConstraintId> column_constraint_ids_;
+
+    /** Current bounds, with infinite values as infinities. */
+    std::vector<double> lower_bounds_;
+    std::vector<double> upper_bounds_;
+
+    /** Queue of constraints to propagate. */
+    std::vector<ConstraintId> queue_;
+    std::vector<char> queued_;
+
+    /** Intervals of the terms of the current constraint. */
+    std::vector<double> term_lower_bounds_;
+    std::vector<double> term_upper_bounds_;
+
+    /** Boolean set when a variable gets an empty domain. */
+    bool infeasible_ = false;
+
+    static constexpr double infinity = std::numeric_limits<double>::infinity();
+
+    static double from_knitro(double bound)
+    {
+        if (bound <= -KN_INFINITY)
+            return -infinity;
+        if (bound >= KN_INFINITY)
+            return infinity;
+        return bound;
+    }
+
+    static double to_knitro(double bound)
+    {
+        return std::max(-KN_INFINITY, std::min(KN_INFINITY, bound));
+    }
+
+    bool is_skipped(ConstraintId constraint_id) const
+    {
+        return !skipped_constraints_.empty() && skipped_constraints_[constraint_id];
+    }
+
+    void build_rows()
+    {
+        VariableId number_of_variables = model_.number_of_variables();
+        ConstraintId number_of_constraints = model_.number_of_constraints();
+        std::size_t number_of_linear_terms = model_.constraint_linear_constraint_ids.size();
+        std::size_t number_of_quadratic_terms = model_.constraint_quadratic_constraint_ids.size();
+
+        row_starts_.assign(number_of_constraints + 1, 0);
+        for (ConstraintId constraint_id: model_.constraint_linear_constraint_ids)
+            row_starts_[constraint_id + 1]++;
+        for (ConstraintId constraint_id: model_.constraint_quadratic_constraint_ids)
+            row_starts_[constraint_id + 1]++;
+        for (ConstraintId constraint_id = 0;
+                constraint_id < number_of_constraints;
+                ++constraint_id) {
+            row_starts_[constraint_id + 1] += row_starts_[constraint_id];
+        }
+        row_terms_.resize(number_of_linear_terms + number_of_quadratic_terms);
+        std::vector<std::size_t> next(row_starts_.begin(), row_starts_.end() - 1);
+        for (std::size_t pos = 0; pos < number_of_linear_terms; ++pos) {
+            row_terms_[next[model_.constraint_linear_constraint_ids[pos]]++] = {
+                model_.constraint_linear_variable_ids[pos],
+                -1,
+                model_.constraint_linear_coefficients[pos]};
+        }
+        for (std::size_t pos = 0; pos < number_of_quadratic_terms; ++pos) {
+            row_terms_[next[model_.constraint_quadratic_constraint_ids[pos]]++] = {
+                model_.constraint_quadratic_variable_ids_1[pos],
+                model_.constraint_quadratic_variable_ids_2[pos],
+                model_.constraint_quadratic_coefficients[pos]};
+        }
+
+        column_starts_.assign(number_of_variables + 1, 0);
+        auto for_each_entry = [this, number_of_constraints](
+                const std::function<void(VariableId, ConstraintId)>& function)
+        {
+            for (ConstraintId constraint_id = 0;
+                    constraint_id < number_of_constraints;
+                    ++constraint_id) {
+                for (std::size_t pos = row_starts_[constraint_id];
+                        pos < row_starts_[constraint_id + 1];
+                        ++pos) {
+                    const Term& term = row_terms_[pos];
+                    function(term.variable_id_1, constraint_id);
+                    if (term.variable_id_2 != -1 && term.variable_id_2 != term.variable_id_1)
+                        function(term.variable_id_2, constraint_id);
+                }
+            }
+        };
+        for_each_entry([this](VariableId variable_id, ConstraintId)
+                {
+                    column_starts_[variable_id + 1]++;
+                });
+        for (VariableId variable_id = 0;
+                variable_id < number_of_variables;
+                ++variable_id) {
+            column_starts_[variable_id + 1] += column_starts_[variable_id];
+        }
+        column_constraint_ids_.resize(column_starts_.back());
+        next.assign(column_starts_.begin(), column_starts_.end() - 1);
+        for_each_entry([this, &next](VariableId variable_id, ConstraintId constraint_id)
+                {
+                    column_constraint_ids_[next[variable_id]++] = constraint_id;
+                });
+    }
+
+    /** Product of two bounds, with 0 * infinity = 0. */
+    static double multiply(double value_1, double value_2)
+    {
+        if (value_1 == 0.0 || value_2 == 0.0)
+            return 0.0;
+        return value_1 * value_2;
+    }
+
+    /** Interval of value * [lower_bound, upper_bound]. */
+    static std::pair<double, double> scale(
+            double value,
+            double lower_bound,
+            double upper_bound)
+    {
+        if (value >= 0)
+            return {multiply(value, lower_bound), multiply(value, upper_bound)};
+        return {multiply(value, upper_bound), multiply(value, lower_bound)};
+    }
+
+    /** Interval product. */
+    static std::pair<double, double> product(
+            double lower_bound_1,
+            double upper_bound_1,
+            double lower_bound_2,
+            double upper_bound_2)
+    {
+        double values[4] = {
+            multiply(lower_bound_1, lower_bound_2),
+            multiply(lower_bound_1, upper_bound_2),
+            multiply(upper_bound_1, lower_bound_2),
+            multiply(upper_bound_1, upper_bound_2)};
+        return {
+            *std::min_element(values, values + 4),
+            *std::max_element(values, values + 4)};
+    }
+
+    /** Compute the interval of a term from the current bounds. */
+    std::pair<double, double> term_interval(const Term& term) const
+    {
+        double lower_bound_1 = lower_bounds_[term.variable_id_1];
+        double upper_bound_1 = upper_bounds_[term.variable_id_1];
+        if (term.variable_id_2 == -1)
+            return scale(term.coefficient, lower_bound_1, upper_bound_1);
+        if (term.variable_id_2 == term.variable_id_1) {
+            double square_lower_bound = 0.0;
+            if (lower_bound_1 > 0)
+                square_lower_bound = lower_bound_1 * lower_bound_1;
+            if (upper_bound_1 < 0)
+                square_lower_bound = upper_bound_1 * upper_bound_1;
+            double square_upper_bound = std::max(
+                    multiply(lower_bound_1, lower_bound_1),
+                    multiply(upper_bound_1, upper_bound_1));
+            return scale(term.coefficient, square_lower_bound, square_upper_bound);
+        }
+        std::pair<double, double> interval = product(
+                lower_bound_1,
+                upper_bound_1,
+                lower_bounds_[term.variable_id_2],
+                upper_bounds_[term.variable_id_2]);
+        return scale(term.coefficient, interval.first, interval.second);
+    }
+
+    void propagate(ConstraintId constraint_id)
+    {
+        double constant = model_.constraint_constants[constraint_id];
+        double lower_bound = from_knitro(model_.constraint_lower_bounds[constraint_id]) - constant;
+        double upper_bound = from_knitro(model_.constraint_upper_bounds[constraint_id]) - constant;
+        if (lower_bound == -infinity && upper_bound == infinity)
+            return;
+
+        // Compute the activity bounds, counting infinite contributions apart.
+        std::size_t row_start = row_starts_[constraint_id];
+        std::size_t row_end = row_starts_[constraint_id + 1];
+        term_lower_bounds_.resize(row_end - row_start);
+        term_upper_bounds_.resize(row_end - row_start);
+        double minimum_activity = 0.0;
+        double maximum_activity = 0.0;
+        std::size_t number_of_infinite_minimums = 0;
+        std::size_t number_of_infinite_maximums = 0;
+        for (std::size_t pos = row_start; pos < row_end; ++pos) {
+            std::pair<double, double> interval = term_interval(row_terms_[pos]);
+            term_lower_bounds_[pos - row_start] = interval.first;
+            term_upper_bounds_[pos - row_start] = interval.second;
+            if (interval.first == -infinity) {
+                number_of_infinite_minimums++;
+            } else {
+                minimum_activity += interval.first;
+            }
+            if (interval.second == infinity) {
+                number_of_infinite_maximums++;
+            } else {
+                maximum_activity += interval.second;
+            }
+        }
+        if (number_of_infinite_minimums > 1 && number_of_infinite_maximums > 1)
+            return;
+        if ((number_of_infinite_minimums == 0 && minimum_activity > upper_bound + parameters_.tolerance * std::max(1.0, std::abs(upper_bound)))
+                || (number_of_infinite_maximums == 0 && maximum_activity < lower_bound - parameters_.tolerance * std::max(1.0, std::abs(lower_bound)))) {
+            infeasible_ = true;
+            return;
+        }
+
+        for (std::size_t pos = row_start; pos < row_end; ++pos) {
+            double term_lower_bound = term_lower_bounds_[pos - row_start];
+            double term_upper_bound = term_upper_bounds_[pos - row_start];
+
+            // Activity of the other terms.
+            double residual_minimum = -infinity;
+            if (term_lower_bound == -infinity) {
+                if (number_of_infinite_minimums == 1)
+                    residual_minimum = minimum_activity;
+            } else if (number_of_infinite_minimums == 0) {
+                residual_minimum = minimum_activity - term_lower_bound;
+            }
+            double residual_maximum = infinity;
+            if (term_upper_bound == infinity) {
+                if (number_of_infinite_maximums == 1)
+                    residual_maximum = maximum_activity;
+            } else if (number_of_infinite_maximums == 0) {
+                residual_maximum = maximum_activity - term_upper_bound;
+            }
+
+            // Interval of the term implied by the constraint.
+            double implied_lower_bound = (lower_bound == -infinity || residual_maximum == infinity)?
+                -infinity: lower_bound - residual_maximum;
+            double implied_upper_bound = (upper_bound == infinity || residual_minimum == -infinity)?
+                infinity: upper_bound - residual_minimum;
+            if (implied_lower_bound <= term_lower_bound && implied_upper_bound >= term_upper_bound)
+                continue;
+            tighten_term(row_terms_[pos], implied_lower_bound, implied_upper_bound);
+            if (infeasible_)
+                return;
+        }
+    }
+
+    /** Tighten the variables of a term from the interval of the term. */
+    void tighten_term(
+            const Term& term,
+            double lower_bound,
+            double upper_bound)
+    {
+        // Interval of the product of the variables.
+        double product_lower_bound = (term.coefficient > 0)?
+            lower_bound / term.coefficient: upper_bound / term.coefficient;
+        double product_upper_bound = (term.coefficient > 0)?
+            upper_bound / term.coefficient: lower_bound / term.coefficient;
+
+        VariableId variable_id_1 = term.variable_id_1;
+        VariableId variable_id_2 = term.variable_id_2;
+        if (variable_id_2 == -1) {
+            update_bounds(variable_id_1, product_lower_bound, product_upper_bound);
+            return;
+        }
+
+        if (variable_id_2 == variable_id_1) {
+            if (product_upper_bound < -parameters_.tolerance * std::max(1.0, std::abs(product_upper_bound))) {
+                infeasible_ = true;
+                return;
+            }
+            // A slightly negative bound comes from rounding errors.
+            product_upper_bound = std::max(0.0, product_upper_bound);
+            double root_upper_bound = std::sqrt(product_upper_bound);
+            update_bounds(variable_id_1, -root_upper_bound, root_upper_bound);
+            if (product_lower_bound > 0) {
+                double root_lower_bound = std::sqrt(product_lower_bound);
+                // x^2 >= r^2 excludes ]-r, r[; it tightens a bound only if
+                // the domain is on one side of it.
+                if (lower_bounds_[variable_id_1] > -root_lower_bound)
+                    update_bounds(variable_id_1, root_lower_bound, infinity);
+                if (upper_bounds_[variable_id_1] < root_lower_bound)
+                    update_bounds(variable_id_1, -infinity, -root_lower_bound);
+            }
+            return;
+        }
+
+        // x_1 in [p] / [x_2] if the domain of x_2 does not contain 0.
+        for (int side = 0; side < 2; ++side) {
+            VariableId variable_id = (side == 0)? variable_id_1: variable_id_2;
+            VariableId other_variable_id = (side == 0)? variable_id_2: variable_id_1;
+            double other_lower_bound = lower_bounds_[other_variable_id];
+            double other_upper_bound = upper_bounds_[other_variable_id];
+            if (other_lower_bound <= 0 && other_upper_bound >= 0)
+                continue;
+            std::pair<double, double> interval = product(
+                    product_lower_bound,
+                    product_upper_bound,
+                    1.0 / other_upper_bound,
+                    1.0 / other_lower_bound);
+            update_bounds(variable_id, interval.first, interval.second);
+            if (infeasible_)
+                return;
+        }
+    }
+
+    /** Update the bounds of a variable and queue its constraints if they changed. */
+    void update_bounds(
+            VariableId variable_id,
+            double lower_bound,
+            double upper_bound)
+    {
+        bool integer = (model_.variable_types[variable_id] != KN_VARTYPE_CONTINUOUS);
+        double& current_lower_bound = lower_bounds_[variable_id];
+        double& current_upper_bound = upper_bounds_[variable_id];
+        bool changed = false;
+        if (lower_bound > -parameters_.maximum_bound) {
+            if (integer)
+                lower_bound = std::ceil(lower_bound - parameters_.tolerance);
+            double threshold = (integer)? 0.5:
+                parameters_.minimum_relative_improvement
+                * std::max(1.0, std::abs(current_lower_bound));
+            if (current_lower_bound == -infinity || lower_bound > current_lower_bound + threshold) {
+                current_lower_bound = lower_bound;
+                changed = true;
+            }
+        }
+        if (upper_bound < parameters_.maximum_bound) {
+            if (integer)
+                upper_bound = std::floor(upper_bound + parameters_.tolerance);
+            double threshold = (integer)? 0.5:
+                parameters_.minimum_relative_improvement
+                * std::max(1.0, std::abs(current_upper_bound));
+            if (current_upper_bound == infinity || upper_bound < current_upper_bound - threshold) {
+                current_upper_bound = upper_bound;
+                changed = true;
+            }
+        }
+        if (!changed)
+            return;
+        if (current_lower_bound > current_upper_bound + parameters_.tolerance * std::max(1.0, std::abs(current_lower_bound))) {
+            infeasible_ = true;
+            return;
+        }
+        for (std::size_t pos = column_starts_[variable_id];
+                pos < column_starts_[variable_id + 1];
+                ++pos) {
+            ConstraintId constraint_id = column_constraint_ids_[pos];
+            if (!queued_[constraint_id] && !is_skipped(constraint_id)) {
+                queued_[constraint_id] = 1;
+                queue_.push_back(constraint_id);
+            }
+        }
+    }
+
+};
+
+/**
+ * Tighten the bounds of the variables of a context from its structure
+ * mirror (see Context::enable_structure_mirror), before solve().
+ *
+ * Constraints with an evaluation callback or L2 norm structure are not
+ * propagated. The tightened bounds are set with set_var_lobnds and
+ * set_var_upbnds, unless the propagation proved the model infeasible.
+ */
+inline BoundTighteningOutput tighten_bounds(
+        Context& knitro_context,
+        const BoundTighteningParameters& parameters = BoundTighteningParameters())
+{
+    const Model& model = knitro_context.structure_mirror();
+    std::vector<char> skipped_constraints(model.number_of_constraints(), 0);
+    for (ConstraintId constraint_id = 0;
+            constraint_id < model.number_of_constraints();
+            ++constraint_id) {
+        skipped_constraints[constraint_id] = knitro_context.is_con_mirror_nonlinear(constraint_id);
+    }
+    BoundTighteningOutput output = BoundTightener(model, skipped_constraints).run(parameters);
+    if (output.infeasible)
+        return output;
+
+    std::vector<VariableId> lower_bound_variable_ids;
+    std::vector<double> lower_bounds;
+    std::vector<VariableId> upper_bound_variable_ids;
+    std::vector<double> upper_bounds;
+    for (VariableId variable_id = 0;
+            variable_id < model.number_of_variables();
+            ++variable_id) {
+        if (output.variable_lower_bounds[variable_id] > model.variable_lower_bounds[variable_id]) {
+            lower_bound_variable_ids.push_back(variable_id);
+            lower_bounds.push_back(output.variable_lower_bounds[variable_id]);
+        }
+        if (output.variable_upper_bounds[variable_id] < model.variable_upper_bounds[variable_id]) {
+            upper_bound_variable_ids.push_back(variable_id);
+            upper_bounds.push_back(output.variable_upper_bounds[variable_id]);
+        }
+    }
+    if (!lower_bound_variable_ids.empty())
+        knitro_context.set_var_lobnds(lower_bound_variable_ids, lower_bounds);
+    if (!upper_bound_variable_ids.empty())
+        knitro_context.set_var_upbnds(upper_bound_variable_ids, upper_bounds);
+    return output;
+}
+
+}
@@ -0,0 +1,277 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace knitrocpp
+{
+
+/**
+ * Structure for a primal-dual iterate stored in a checkpoint.
+ */
+struct Checkpoint
+{
+    /** Number of iterates received before this one. */
+    std::uint64_t iteration = 0;
+
+    /** Primal values. */
+    std::vector<double> x;
+
+    /**
+     * Dual values, constraints first (m values), then variables (n
+     * values).
+     */
+    std::vector<double> lambda;
+};
+
+/**
+ * Class for periodically writing the current iterate of a solve to a file.
+ *
+ * The solver thread copies each new iterate into a buffer and publishes it
+ * with an atomic exchange (triple buffering), so it never waits for the
+ * background thread. The background thread writes the latest iterate every
+ * period to a temporary file which is then renamed, so the checkpoint file
+ * is always complete.
+ *
+ * File format: the characters "KNCP", then the number of variables n and the
+ * number of constraints m (int64), the iteration (uint64), x (n doubles)
+ * and lambda (m + n doubles).
+ */
+class Checkpointer
+{
+
+public:
+
+    /** Constructor. */
+    Checkpointer(
+            const std::string& filename,
+            double period,
+            VariableId number_of_variables,
+            ConstraintId number_of_constraints):
+        filename_(filename),
+        period_(period),
+        number_of_variables_(number_of_variables),
+        number_of_constraints_(number_of_constraints)
+    {
+        for (Checkpoint& buffer: buffers_) {
+            buffer.x.resize(number_of_variables);
+            buffer.lambda.resize(number_of_constraints + number_of_variables);
+        }
+        thread_ = std::thread(&Checkpointer::run, this);
+    }
+
+    /** Destructor; write the latest iterate. */
+    ~Checkpointer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        condition_variable_.notify_one();
+        thread_.join();
+    }
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    /** Publish a new iterate; called from the solver thread. */
+    void update(
+            const double* const x,
+            const double* const lambda)
+    {
+        Checkpoint& buffer = buffers_[back_];
+        buffer.iteration = number_of_updates_++;
+        std::copy(x, x + number_of_variables_, buffer.x.begin());
+        std::copy(
+                lambda,
+                lambda + number_of_constraints_ + number_of_variables_,
+                buffer.lambda.begin());
+        back_ = middle_.exchange(back_ | dirty_bit) & index_mask;
+    }
+
+    /** Get the number of checkpoints written. */
+    std::size_t number_of_writes() const { return number_of_writes_.load(); }
+
+private:
+
+    static const int dirty_bit = 4;
+    static const int index_mask = 3;
+
+    /** Path of the checkpoint file. */
+    std::string filename_;
+
+    /** Time between two writes, in seconds. */
+    double period_;
+
+    /** Number of variables. */
+    VariableId number_of_variables_;
+
+    /** Number of constraints. */
+    ConstraintId number_of_constraints_;
+
+    /** Buffers. */
+    Checkpoint buffers_[3];
+
+    /** Buffer written by the solver thread. */
+    int back_ = 0;
+
+    /** Buffer exchanged between the threads, with the dirty bit if it is new. */
+    std::atomic<int> middle_ {1};
+
+    /** Buffer read by the background thread. */
+    int front_ = 2;
+
+    /** Number of iterates received. */
+    std::uint64_t number_of_updates_ = 0;
+
+    /** Number of checkpoints written. */
+    std::atomic<std::size_t> number_of_writes_ {0};
+
+    /** Boolean set when the checkpointer is destroyed. */
+    bool stop_ = false;
+
+    /** Mutex and condition variable used to wake up the background thread. */
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+
+    /** Background thread. */
+    std::thread thread_;
+
+    void run()
+    {
+        for (;;) {
+            bool stop = false;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_variable_.wait_for(
+                        lock,
+                        std::chrono::duration<double>(period_),
+                        [this]() { return stop_; });
+                stop = stop_;
+            }
+            if (middle_.load() & dirty_bit) {
+                front_ = middle_.exchange(front_) & index_mask;
+                write(buffers_[front_]);
+            }
+            if (stop)
+                return;
+        }
+    }
+
+    void write(const Checkpoint& checkpoint)
+    {
+        std::string temporary_filename = filename_ + ".tmp";
+        {
+            std::ofstream file(temporary_filename, std::ios::binary);
+            std::int64_t number_of_variables = number_of_variables_;
+            std::int64_t number_of_constraints = number_of_constraints_;
+            file.write("KNCP", 4);
+            file.write((const char*)&number_of_variables, sizeof(number_of_variables));
+            file.write((const char*)&number_of_constraints, sizeof(number_of_constraints));
+            file.write((const char*)&checkpoint.iteration, sizeof(checkpoint.iteration));
+            file.write((const char*)checkpoint.x.data(), checkpoint.x.size() * sizeof(double));
+            file.write((const char*)checkpoint.lambda.data(), checkpoint.lambda.size() * sizeof(double));
+            if (!file)
+                return;
+        }
+        if (std::rename(temporary_filename.c_str(), filename_.c_str()) == 0)
+            number_of_writes_++;
+    }
+
+};
+
+/** Read a checkpoint file written by a Checkpointer. */
+inline Checkpoint read_checkpoint(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("KnitroCpp error: unable to open checkpoint file '" + filename + "'.");
+    char magic[4];
+    std::int64_t number_of_variables = 0;
+    std::int64_t number_of_constraints = 0;
+    Checkpoint checkpoint;
+    file.read(magic, 4);
+    file.read((char*)&number_of_variables, sizeof(number_of_variables));
+    file.read((char*)&number_of_constraints, sizeof(number_of_constraints));
+    file.read((char*)&checkpoint.iteration, sizeof(checkpoint.iteration));
+    if (!file
+            || std::string(magic, 4) != "KNCP"
+            || number_of_variables < 0
+            || number_of_constraints < 0) {
+        throw std::runtime_error("KnitroCpp error: invalid checkpoint file '" + filename + "'.");
+    }
+    checkpoint.x.resize(number_of_variables);
+    checkpoint.lambda.resize(number_of_constraints + number_of_variables);
+    file.read((char*)checkpoint.x.data(), checkpoint.x.size() * sizeof(double));
+    file.read((char*)checkpoint.lambda.data(), checkpoint.lambda.size() * sizeof(double));
+    if (!file)
+        throw std::runtime_error("KnitroCpp error: truncated checkpoint file '" + filename + "'.");
+    return checkpoint;
+}
+
+
+/**
+ * Write the iterates of a solve to a checkpointer.
+ *
+ * The iterates are received through the new point callback, which also
+ * calls newpt_callback if it is set; this replaces the callback set with
+ * Context::set_newpt_callback. The checkpointer must outlive the solve.
+ */
+inline void set_checkpoint(
+        Context& knitro_context,
+        Checkpointer& checkpointer,
+        Context::UserCallback newpt_callback = nullptr)
+{
+    Checkpointer* checkpointer_pointer = &checkpointer;
+    knitro_context.set_newpt_callback(
+            [checkpointer_pointer, newpt_callback](
+                const Context& iterate_context,
+                const double* const x,
+                const double* const lambda)
+            {
+                checkpointer_pointer->update(x, lambda);
+                if (!newpt_callback)
+                    return 0;
+                return newpt_callback(iterate_context, x, lambda);
+            });
+}
+
+/**
+ * Set the initial primal and dual values of a context from a checkpoint
+ * file written by a Checkpointer.
+ */
+inline void load_checkpoint(
+        Context& knitro_context,
+        const std::string& filename)
+{
+    Checkpoint checkpoint = read_checkpoint(filename);
+    VariableId number_of_variables = knitro_context.get_number_vars();
+    ConstraintId number_of_constraints = knitro_context.get_number_cons();
+    if ((VariableId)checkpoint.x.size() != number_of_variables
+            || (ConstraintId)checkpoint.lambda.size() != number_of_constraints + number_of_variables) {
+        throw std::runtime_error(
+                "KnitroCpp error: checkpoint file '" + filename
+                + "' does not match the dimensions of the model.");
+    }
+    knitro_context.set_var_primal_init_values(checkpoint.x);
+    knitro_context.set_con_dual_init_values(std::vector<double>(
+                checkpoint.lambda.begin(),
+                checkpoint.lambda.begin() + number_of_constraints));
+    knitro_context.set_var_dual_init_values(std::vector<double>(
+                checkpoint.lambda.begin() + number_of_constraints,
+                checkpoint.lambda.end()));
+}
+
+}
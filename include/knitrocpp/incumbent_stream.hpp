@@ -0,0 +1,299 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+#include "knitrocpp/spsc_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace knitrocpp
+{
+
+/**
+ * Structure for a MIP incumbent solution.
+ */
+struct Incumbent
+{
+    /** Objective value. */
+    double objective = 0.0;
+
+    /** Values of the variables. */
+    std::vector<double> x;
+};
+
+using IncumbentCallback = std::function<void(const Incumbent&)>;
+
+/**
+ * Class for publishing improving MIP incumbents to a consumer thread.
+ *
+ * Incumbents are copied into the preallocated slots of a bounded pool and
+ * handed to the consumer through a lock-free queue. If all slots are still
+ * held by the consumer, the incumbent is kept in a single pending slot,
+ * which is published as soon as a slot is free (at the next offer or when
+ * the consumer releases a slot, at the latest when the stream is
+ * destroyed). A pending incumbent overwritten by a better one before being
+ * published is dropped.
+ *
+ * Producers may run concurrently (parallel MIP node callbacks): offer()
+ * rejects non-improving incumbents with a lock-free check of the best
+ * objective value seen, and the publication itself is serialized by a
+ * producer mutex, so the consumer receives strictly improving incumbents.
+ */
+class IncumbentStream
+{
+
+public:
+
+    /** Constructor. */
+    IncumbentStream(
+            IncumbentCallback consumer,
+            int objective_goal,
+            VariableId number_of_variables,
+            std::size_t capacity = 16):
+        consumer_(consumer),
+        objective_goal_(objective_goal),
+        best_objective_((objective_goal == KN_OBJGOAL_MAXIMIZE)?
+                -std::numeric_limits<double>::infinity():
+                std::numeric_limits<double>::infinity()),
+        pool_(capacity, empty_incumbent(number_of_variables)),
+        pending_(empty_incumbent(number_of_variables)),
+        spare_(empty_incumbent(number_of_variables)),
+        thread_(&IncumbentStream::run, this) { }
+
+    /** Destructor; hand all pending incumbents to the consumer. */
+    ~IncumbentStream()
+    {
+        stop_.store(true);
+        condition_variable_.notify_one();
+        thread_.join();
+    }
+
+    IncumbentStream(const IncumbentStream&) = delete;
+    IncumbentStream& operator=(const IncumbentStream&) = delete;
+
+    /**
+     * Return true iff an objective value improves on the best one seen; it
+     * does not lock and may be called concurrently.
+     */
+    bool improves(double objective) const
+    {
+        return improves(objective, best_objective_.load(std::memory_order_acquire));
+    }
+
+    /**
+     * Publish an incumbent if it improves on the best one seen; it may be
+     * called concurrently.
+     *
+     * read_objective(double&) and read_x(double*) read the objective value
+     * and the values of the variables of the incumbent and return false on
+     * failure. They are called while holding the producer mutex, so that
+     * the objective value and the values of the variables are read
+     * together. The best objective value seen is only updated once the
+     * incumbent has been read. Return true iff the incumbent has been
+     * published or kept as pending incumbent.
+     */
+    template <typename ReadObjective, typename ReadX>
+    bool offer(
+            const ReadObjective& read_objective,
+            const ReadX& read_x)
+    {
+        std::lock_guard<std::mutex> lock(producer_mutex_);
+        publish_pending();
+        double objective = 0.0;
+        if (!read_objective(objective) || !improves(objective))
+            return false;
+        Incumbent* incumbent = pool_.producer_slot();
+        if (incumbent == nullptr) {
+            // The pool is full: read into the spare incumbent, so that a
+            // failed read does not overwrite the pending incumbent.
+            if (!read_x(spare_.x.data()))
+                return false;
+            spare_.objective = objective;
+            std::swap(pending_, spare_);
+            best_objective_.store(objective, std::memory_order_release);
+            if (has_pending_.load(std::memory_order_relaxed))
+                number_of_dropped_incumbents_.fetch_add(1, std::memory_order_relaxed);
+            has_pending_.store(true, std::memory_order_release);
+            return true;
+        }
+        if (!read_x(incumbent->x.data()))
+            return false;
+        incumbent->objective = objective;
+        best_objective_.store(objective, std::memory_order_release);
+        if (has_pending_.load(std::memory_order_relaxed)) {
+            // The pending incumbent is worse than this one and no slot was
+            // free for it.
+            has_pending_.store(false, std::memory_order_relaxed);
+            number_of_dropped_incumbents_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pool_.push();
+        condition_variable_.notify_one();
+        return true;
+    }
+
+    /**
+     * Get the number of improving incumbents dropped because they were
+     * superseded by a better one while the pool was full.
+     */
+    std::size_t number_of_dropped_incumbents() const
+    {
+        return number_of_dropped_incumbents_.load();
+    }
+
+private:
+
+    /** Consumer. */
+    IncumbentCallback consumer_;
+
+    /** Objective goal (KN_OBJGOAL_MINIMIZE or KN_OBJGOAL_MAXIMIZE). */
+    int objective_goal_;
+
+    /** Best objective value seen (infinite before the first incumbent). */
+    std::atomic<double> best_objective_;
+
+    /** Mutex serializing the producers. */
+    std::mutex producer_mutex_;
+
+    /** Pool of incumbents. */
+    detail::SpscQueue<Incumbent> pool_;
+
+    /** Latest incumbent received while the pool was full. */
+    Incumbent pending_;
+
+    /** Buffer the incumbents are read into while the pool is full. */
+    Incumbent spare_;
+
+    /** Boolean indicating if pending_ holds an unpublished incumbent. */
+    std::atomic<bool> has_pending_ {false};
+
+    /** Number of incumbents dropped. */
+    std::atomic<std::size_t> number_of_dropped_incumbents_ {0};
+
+    /** Boolean set when the stream is destroyed. */
+    std::atomic<bool> stop_ {false};
+
+    /** Mutex and condition variable used to wake up the consumer thread. */
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+
+    /** Consumer thread. */
+    std::thread thread_;
+
+    bool improves(
+            double objective,
+            double best_objective) const
+    {
+        return (objective_goal_ == KN_OBJGOAL_MAXIMIZE)?
+            objective > best_objective:
+            objective < best_objective;
+    }
+
+    /**
+     * Move the pending incumbent into a free slot of the pool, if any; the
+     * producer mutex must be held.
+     */
+    void publish_pending()
+    {
+        if (!has_pending_.load(std::memory_order_relaxed))
+            return;
+        Incumbent* incumbent = pool_.producer_slot();
+        if (incumbent == nullptr)
+            return;
+        std::swap(*incumbent, pending_);
+        has_pending_.store(false, std::memory_order_relaxed);
+        pool_.push();
+        condition_variable_.notify_one();
+    }
+
+    static Incumbent empty_incumbent(VariableId number_of_variables)
+    {
+        Incumbent incumbent;
+        incumbent.x.resize(number_of_variables, 0.0);
+        return incumbent;
+    }
+
+    void run()
+    {
+        for (;;) {
+            bool stop = stop_.load();
+            Incumbent* incumbent = nullptr;
+            while ((incumbent = pool_.consumer_slot()) != nullptr) {
+                consumer_(*incumbent);
+                pool_.pop();
+            }
+            if (has_pending_.load(std::memory_order_acquire)) {
+                // A slot has been released; publish the pending incumbent.
+                std::lock_guard<std::mutex> lock(producer_mutex_);
+                publish_pending();
+                continue;
+            }
+            if (stop)
+                return;
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_variable_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+};
+
+
+/**
+ * Send the improving MIP incumbents of a solve to an incumbent stream.
+ *
+ * Improvements are detected in the MIP node callback, which also calls
+ * mip_node_callback if it is set; this replaces the callback set with
+ * Context::set_mip_node_callback. The stream must outlive the solve.
+ */
+inline void set_mip_incumbent_stream(
+        Context& knitro_context,
+        IncumbentStream& incumbent_stream,
+        Context::UserCallback mip_node_callback = nullptr)
+{
+    IncumbentStream* stream = &incumbent_stream;
+    knitro_context.set_mip_node_callback(
+            [stream, mip_node_callback](
+                const Context& node_context,
+                const double* const x,
+                const double* const lambda)
+            {
+                auto read_objective = [&node_context](double& objective)
+                {
+                    try {
+                        if (!node_context.has_mip_incumbent())
+                            return false;
+                        objective = node_context.get_mip_incumbent_obj();
+                        return true;
+                    } catch (const KnitroException&) {
+                        return false;
+                    }
+                };
+                double incumbent_objective = 0.0;
+                if (read_objective(incumbent_objective)
+                        && stream->improves(incumbent_objective)) {
+                    stream->offer(
+                            read_objective,
+                            [&node_context](double* const incumbent_x)
+                            {
+                                try {
+                                    node_context.get_mip_incumbent_x(incumbent_x);
+                                    return true;
+                                } catch (const KnitroException&) {
+                                    return false;
+                                }
+                            });
+                }
+                if (!mip_node_callback)
+                    return 0;
+                return mip_node_callback(node_context, x, lambda);
+            });
+}
+
+}
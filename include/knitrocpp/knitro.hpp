@@ -1,20 +1,163 @@
+#pragma once
+
 #include <string>
+#include <cstdint>
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <mutex>
+#include <cstddef>
+#include <chrono>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <cstdio>
 
 extern "C"
 {
 #include "knitro.h"
 }
 
+#include "knitrocpp/model.hpp"
+
+#ifdef KNITROCPP_DYNAMIC_LOADING
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+#include <cstdlib>
+#endif
+
+/*
+ * Calls to the Knitro C API go through KNITROCPP_KN. By default, it expands
+ * to the function itself, which is resolved at link time. When
+ * KNITROCPP_DYNAMIC_LOADING is defined, the Knitro shared library is not
+ * linked; it is opened on the first call and each function is resolved on
+ * its first use.
+ */
+#ifdef KNITROCPP_DYNAMIC_LOADING
+#define KNITROCPP_KN(function) \
+    ([]() { \
+        static decltype(&::function) const function_pointer \
+            = ::knitrocpp::detail::load_knitro_function<decltype(&::function)>(#function); \
+        return function_pointer; \
+    }())
+#else
+#define KNITROCPP_KN(function) ::function
+#endif
+
 namespace knitrocpp
 {
 
+#ifdef KNITROCPP_DYNAMIC_LOADING
+
+namespace detail
+{
+
+/** Path of the Knitro shared library set by the user. */
+inline std::string& knitro_library_path()
+{
+    static std::string path;
+    return path;
+}
+
+/**
+ * Get the path of the Knitro shared library.
+ *
+ * It is, by order of priority, the path set with set_knitro_library_path,
+ * the KNITROCPP_KNITRO_LIBRARY environment variable, or the library in
+ * the 'lib' directory of the KNITRODIR environment variable.
+ */
+inline std::string find_knitro_library()
+{
+    if (!knitro_library_path().empty())
+        return knitro_library_path();
+    const char* library = std::getenv("KNITROCPP_KNITRO_LIBRARY");
+    if (library != nullptr)
+        return library;
+    const char* knitro_directory = std::getenv("KNITRODIR");
+    if (knitro_directory == nullptr) {
+        throw std::runtime_error(
+                "KnitroCpp error: cannot locate the Knitro library; "
+                "set KNITRODIR or KNITROCPP_KNITRO_LIBRARY.");
+    }
+#if defined(_WIN32)
+    throw std::runtime_error(
+            "KnitroCpp error: cannot locate the Knitro library; "
+            "set KNITROCPP_KNITRO_LIBRARY to the path of the Knitro DLL.");
+#elif defined(__APPLE__)
+    return std::string(knitro_directory) + "/lib/libknitro.dylib";
+#else
+    return std::string(knitro_directory) + "/lib/libknitro.so";
+#endif
+}
+
+/** Open the Knitro shared library; throw if it is not available. */
+inline void* open_knitro_library()
+{
+    std::string path = find_knitro_library();
+#if defined(_WIN32)
+    void* handle = (void*)LoadLibraryA(path.c_str());
+#else
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+    if (handle == nullptr) {
+        throw std::runtime_error(
+                "KnitroCpp error: failed to load the Knitro library '"
+                + path + "'.");
+    }
+    return handle;
+}
+
+/** Get the handle of the Knitro shared library, opening it if needed. */
+inline void* knitro_library()
+{
+    static void* const handle = open_knitro_library();
+    return handle;
+}
+
+/** Resolve a function of the Knitro shared library. */
+template <typename FunctionPointer>
+FunctionPointer load_knitro_function(const char* function_name)
+{
+#if defined(_WIN32)
+    void* symbol = (void*)GetProcAddress((HMODULE)knitro_library(), function_name);
+#else
+    void* symbol = dlsym(knitro_library(), function_name);
+#endif
+    if (symbol == nullptr) {
+        throw std::runtime_error(
+                std::string("KnitroCpp error: function '") + function_name
+                + "' not found in the Knitro library.");
+    }
+    return reinterpret_cast<FunctionPointer>(symbol);
+}
+
+}
+
+/**
+ * Set the path of the Knitro shared library.
+ *
+ * It must be called before the first Knitro function is called.
+ */
+inline void set_knitro_library_path(const std::string& path)
+{
+    detail::knitro_library_path() = path;
+}
+
+#endif
+
 using VariableId = KNINT;
 using ConstraintId = KNINT;
+using ResidualId = KNINT;
 
 /**
  * Class for handling Knitro exceptions.
@@ -45,6 +188,700 @@ private:
 
 };
 
+/**
+ * Structure describing a Knitro parameter.
+ */
+template <typename T>
+struct ParamDescriptor
+{
+    /** Integer identifier. */
+    int id;
+
+    /** Name. */
+    const char* name;
+
+    /** Default value. */
+    T default_value;
+
+    /** Smallest valid value. */
+    T minimum_value;
+
+    /** Largest valid value. */
+    T maximum_value;
+};
+
+using IntParamDescriptor = ParamDescriptor<int>;
+using DoubleParamDescriptor = ParamDescriptor<double>;
+
+/**
+ * Descriptors of the most commonly used Knitro parameters.
+ *
+ * See the Knitro documentation for the meaning of the values.
+ */
+namespace param
+{
+
+constexpr int int_max = std::numeric_limits<int>::max();
+
+constexpr IntParamDescriptor newpoint {KN_PARAM_NEWPOINT, "newpoint", 0, 0, 2};
+constexpr IntParamDescriptor algorithm {KN_PARAM_ALGORITHM, "algorithm", 0, 0, 6};
+constexpr IntParamDescriptor bar_murule {KN_PARAM_BAR_MURULE, "bar_murule", 0, 0, 6};
+constexpr IntParamDescriptor bar_feasible {KN_PARAM_BAR_FEASIBLE, "bar_feasible", 0, 0, 3};
+constexpr IntParamDescriptor bar_initpt {KN_PARAM_BAR_INITPT, "bar_initpt", 0, 0, 3};
+constexpr IntParamDescriptor gradopt {KN_PARAM_GRADOPT, "gradopt", 1, 1, 5};
+constexpr IntParamDescriptor hessopt {KN_PARAM_HESSOPT, "hessopt", 0, 0, 7};
+constexpr IntParamDescriptor lmsize {KN_PARAM_LMSIZE, "lmsize", 10, 1, 100};
+constexpr IntParamDescriptor maxit {KN_PARAM_MAXIT, "maxit", 0, 0, int_max};
+constexpr IntParamDescriptor outlev {KN_PARAM_OUTLEV, "outlev", 2, 0, 6};
+constexpr IntParamDescriptor scale {KN_PARAM_SCALE, "scale", 1, 0, 3};
+constexpr IntParamDescriptor presolve {KN_PARAM_PRESOLVE, "presolve", 1, 0, 1};
+constexpr IntParamDescriptor derivcheck {KN_PARAM_DERIVCHECK, "derivcheck", 0, 0, 3};
+constexpr IntParamDescriptor ms_enable {KN_PARAM_MS_ENABLE, "ms_enable", 0, 0, 1};
+constexpr IntParamDescriptor ms_maxsolves {KN_PARAM_MS_MAXSOLVES, "ms_maxsolves", 0, 0, int_max};
+constexpr IntParamDescriptor ms_numthreads {KN_PARAM_MS_NUMTHREADS, "ms_numthreads", 0, 0, int_max};
+constexpr IntParamDescriptor par_numthreads {KN_PARAM_PAR_NUMTHREADS, "par_numthreads", 0, 0, int_max};
+constexpr IntParamDescriptor par_concurrent_evals {KN_PARAM_PAR_CONCURRENT_EVALS, "par_concurrent_evals", 1, 0, 1};
+constexpr IntParamDescriptor par_blasnumthreads {KN_PARAM_PAR_BLASNUMTHREADS, "par_blasnumthreads", 1, 0, int_max};
+constexpr IntParamDescriptor par_lsnumthreads {KN_PARAM_PAR_LSNUMTHREADS, "par_lsnumthreads", 1, 0, int_max};
+constexpr IntParamDescriptor mip_method {KN_PARAM_MIP_METHOD, "mip_method", 0, 0, 3};
+constexpr IntParamDescriptor mip_maxnodes {KN_PARAM_MIP_MAXNODES, "mip_maxnodes", 100000, 0, int_max};
+constexpr IntParamDescriptor mip_numthreads {KN_PARAM_MIP_NUMTHREADS, "mip_numthreads", 0, 0, int_max};
+
+constexpr DoubleParamDescriptor feastol {KN_PARAM_FEASTOL, "feastol", 1.0e-6, 0.0, KN_INFINITY};
+constexpr DoubleParamDescriptor opttol {KN_PARAM_OPTTOL, "opttol", 1.0e-6, 0.0, KN_INFINITY};
+constexpr DoubleParamDescriptor xtol {KN_PARAM_XTOL, "xtol", 1.0e-12, 0.0, KN_INFINITY};
+constexpr DoubleParamDescriptor maxtime_cpu {KN_PARAM_MAXTIMECPU, "maxtime_cpu", 1.0e8, 0.0, KN_INFINITY};
+constexpr DoubleParamDescriptor maxtime_real {KN_PARAM_MAXTIMEREAL, "maxtime_real", 1.0e8, 0.0, KN_INFINITY};
+constexpr DoubleParamDescriptor ms_maxbndrange {KN_PARAM_MS_MAXBNDRANGE, "ms_maxbndrange", 1000.0, 0.0, KN_INFINITY};
+constexpr DoubleParamDescriptor mip_optgapabs {KN_PARAM_MIP_OPTGAPABS, "mip_optgapabs", 1.0e-6, 0.0, KN_INFINITY};
+constexpr DoubleParamDescriptor mip_optgaprel {KN_PARAM_MIP_OPTGAPREL, "mip_optgaprel", 1.0e-4, 0.0, KN_INFINITY};
+
+}
+
+/** Throw if a value is outside the valid range of a parameter. */
+template <typename T>
+void check_param_value(
+        const ParamDescriptor<T>& param,
+        T value)
+{
+    if (value < param.minimum_value || value > param.maximum_value) {
+        throw std::out_of_range(
+                "KnitroCpp error: value " + std::to_string(value)
+                + " is out of range for parameter '" + param.name + "'.");
+    }
+}
+
+class Context;
+
+/**
+ * Class for a Knitro license checked out once and shared by several
+ * contexts.
+ */
+class License
+{
+
+public:
+
+    /** Constructor; check out a license. */
+    License()
+    {
+        auto start = std::chrono::steady_clock::now();
+        int knitro_return_code = KNITROCPP_KN(KN_checkout_license)(&lm_context_);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_checkout_license", knitro_return_code);
+        if (lm_context_ == NULL)
+            throw std::runtime_error("Failed to find a valid license.");
+        checkout_time_ = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+    }
+
+    /** Destructor; release the license. */
+    ~License()
+    {
+        KNITROCPP_KN(KN_release_license)(&lm_context_);
+    }
+
+    License(const License&) = delete;
+    License& operator=(const License&) = delete;
+
+    /** Get the time spent checking out the license, in seconds. */
+    double checkout_time() const { return checkout_time_; }
+
+private:
+
+    /** Knitro license manager context. */
+    LM_context* lm_context_ = nullptr;
+
+    /** Time spent checking out the license. */
+    double checkout_time_ = 0.0;
+
+    friend class Context;
+
+};
+
+/**
+ * Class for building the sparsity pattern of a Hessian.
+ *
+ * Entries are symmetrized (only the upper triangular part is kept) and
+ * deduplicated. Each entry is given a fixed position in eval_result->hess,
+ * which can be stored when building the model and used directly inside the
+ * Hessian callback.
+ *
+ * Entries are indexed by a flat open-addressing hash table (multiplicative
+ * hashing, linear probing), kept at most half full and updated by add(),
+ * so a lookup takes constant expected time, without allocating or
+ * locking. Entries must not be added while the pattern is used by a
+ * callback.
+ */
+class HessianPattern
+{
+
+private:
+
+    /** Slot of the hash table. */
+    struct Slot
+    {
+        /** Key of the entry; empty_key if the slot is free. */
+        std::uint64_t key;
+
+        /** Position of the entry. */
+        KNLONG position;
+    };
+
+    /** Key of the free slots. */
+    static constexpr std::uint64_t empty_key = ~(std::uint64_t)0;
+
+public:
+
+    /**
+     * Class for accumulating values into the Hessian array of an evaluation
+     * result.
+     */
+    class Accumulator
+    {
+
+    public:
+
+        /** Constructor; reset all entries of hess to 0. */
+        Accumulator(
+                const HessianPattern& hessian_pattern,
+                double* const hess):
+            hessian_pattern_(hessian_pattern),
+            hess_(hess)
+        {
+            std::fill(hess_, hess_ + hessian_pattern.number_of_entries(), 0.0);
+        }
+
+        /** Add a value to the entry at a given position. */
+        void add(
+                KNLONG position,
+                double value)
+        {
+            hess_[position] += value;
+        }
+
+        /**
+         * Add a value to entry (variable_id_1, variable_id_2).
+         *
+         * The entry is found in the hash table of the pattern; the position
+         * overload is faster. Throw if the entry is not in the pattern.
+         */
+        void add(
+                VariableId variable_id_1,
+                VariableId variable_id_2,
+                double value)
+        {
+            KNLONG position = hessian_pattern_.position(variable_id_1, variable_id_2);
+            if (position < 0) {
+                throw std::runtime_error(
+                        "KnitroCpp error: entry (" + std::to_string(variable_id_1)
+                        + ", " + std::to_string(variable_id_2)
+                        + ") is not in the Hessian pattern.");
+            }
+            hess_[position] += value;
+        }
+
+    private:
+
+        /** Pattern. */
+        const HessianPattern& hessian_pattern_;
+
+        /** Hessian array. */
+        double* const hess_;
+
+    };
+
+    /**
+     * Add entry (variable_id_1, variable_id_2) if it is not already in the
+     * pattern, and return its position.
+     */
+    KNLONG add(
+            VariableId variable_id_1,
+            VariableId variable_id_2)
+    {
+        if (2 * (variable_ids_1_.size() + 1) > slots_.size())
+            rehash((std::max)((std::size_t)16, 2 * slots_.size()));
+        std::uint64_t entry_key = key(variable_id_1, variable_id_2);
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t pos = hash(entry_key);; pos = (pos + 1) & mask) {
+            Slot& slot = slots_[pos];
+            if (slot.key == entry_key)
+                return slot.position;
+            if (slot.key == empty_key) {
+                slot.key = entry_key;
+                slot.position = variable_ids_1_.size();
+                variable_ids_1_.push_back(std::min(variable_id_1, variable_id_2));
+                variable_ids_2_.push_back(std::max(variable_id_1, variable_id_2));
+                return slot.position;
+            }
+        }
+    }
+
+    /**
+     * Get the position of entry (variable_id_1, variable_id_2); return -1 if
+     * it is not in the pattern.
+     */
+    KNLONG position(
+            VariableId variable_id_1,
+            VariableId variable_id_2) const
+    {
+        if (slots_.empty())
+            return -1;
+        std::uint64_t entry_key = key(variable_id_1, variable_id_2);
+        std::size_t mask = slots_.size() - 1;
+        for (std::size_t pos = hash(entry_key);; pos = (pos + 1) & mask) {
+            const Slot& slot = slots_[pos];
+            if (slot.key == entry_key)
+                return slot.position;
+            if (slot.key == empty_key)
+                return -1;
+        }
+    }
+
+    /** Get the number of entries of the pattern. */
+    KNLONG number_of_entries() const { return variable_ids_1_.size(); }
+
+    /** Get the first variable of each entry. */
+    const std::vector<VariableId>& variable_ids_1() const { return variable_ids_1_; }
+
+    /** Get the second variable of each entry. */
+    const std::vector<VariableId>& variable_ids_2() const { return variable_ids_2_; }
+
+    /** Get an accumulator writing into the Hessian array of an evaluation result. */
+    Accumulator accumulator(double* const hess) const
+    {
+        return Accumulator(*this, hess);
+    }
+
+private:
+
+    /** First variable of each entry. */
+    std::vector<VariableId> variable_ids_1_;
+
+    /** Second variable of each entry. */
+    std::vector<VariableId> variable_ids_2_;
+
+    /** Hash table; its size is 0 or a power of 2. */
+    std::vector<Slot> slots_;
+
+    /** Shift of the hash function, 64 - log2(slots_.size()). */
+    int hash_shift_ = 64;
+
+    /** Get the first slot probed for a key (Fibonacci hashing). */
+    std::size_t hash(std::uint64_t entry_key) const
+    {
+        return (std::size_t)((entry_key * 0x9E3779B97F4A7C15ull) >> hash_shift_);
+    }
+
+    /** Resize the hash table and reinsert all entries. */
+    void rehash(std::size_t number_of_slots)
+    {
+        Slot empty_slot = {empty_key, -1};
+        slots_.assign(number_of_slots, empty_slot);
+        hash_shift_ = 64;
+        for (std::size_t size = number_of_slots; size > 1; size /= 2)
+            hash_shift_--;
+        std::size_t mask = number_of_slots - 1;
+        for (KNLONG position = 0; position < number_of_entries(); ++position) {
+            std::uint64_t entry_key = key(variable_ids_1_[position], variable_ids_2_[position]);
+            std::size_t pos = hash(entry_key);
+            while (slots_[pos].key != empty_key)
+                pos = (pos + 1) & mask;
+            slots_[pos].key = entry_key;
+            slots_[pos].position = position;
+        }
+    }
+
+    /** Get the key of entry (variable_id_1, variable_id_2). */
+    static std::uint64_t key(
+            VariableId variable_id_1,
+            VariableId variable_id_2)
+    {
+        if (variable_id_1 > variable_id_2)
+            std::swap(variable_id_1, variable_id_2);
+        return ((std::uint64_t)(std::uint32_t)variable_id_1 << 32)
+            | (std::uint64_t)(std::uint32_t)variable_id_2;
+    }
+
+};
+
+/**
+ * Class mapping unscaled objective and constraint Hessian values to the
+ * Hessian of the Lagrangian.
+ *
+ * The map is made of blocks. Each block belongs to one function (the
+ * objective or a constraint) and lists the entries it contributes to.
+ * Inside a Hessian callback, the unscaled values of all blocks are written
+ * contiguously into a compact buffer, in the order the blocks were added.
+ * The assembly then weights each block by sigma or by the multiplier of its
+ * constraint and adds it into eval_result->hess.
+ */
+class LagrangianHessianMap
+{
+
+public:
+
+    /**
+     * Add a block of objective Hessian entries; return the offset of the
+     * block in the value buffer.
+     */
+    KNLONG add_obj_block(
+            const std::vector<VariableId>& variable_ids_1,
+            const std::vector<VariableId>& variable_ids_2)
+    {
+        return add_block(-1, variable_ids_1, variable_ids_2);
+    }
+
+    /**
+     * Add a block of Hessian entries of a constraint; return the offset of
+     * the block in the value buffer.
+     */
+    KNLONG add_con_block(
+            ConstraintId constraint_id,
+            const std::vector<VariableId>& variable_ids_1,
+            const std::vector<VariableId>& variable_ids_2)
+    {
+        return add_block(constraint_id, variable_ids_1, variable_ids_2);
+    }
+
+    /** Get the number of values of the value buffer. */
+    KNLONG number_of_values() const { return positions_.size(); }
+
+    /** Get the Hessian pattern of the Lagrangian. */
+    const HessianPattern& hessian_pattern() const { return hessian_pattern_; }
+
+    /**
+     * Assemble the Hessian of the Lagrangian from the unscaled values of
+     * the blocks.
+     */
+    void assemble(
+            KN_eval_request_ptr const eval_request,
+            const double* const values,
+            double* const hess) const
+    {
+        std::fill(hess, hess + hessian_pattern_.number_of_entries(), 0.0);
+        double sigma = (eval_request->type == KN_RC_EVALH_NO_F)?
+            0.0: *(eval_request->sigma);
+        const KNLONG* positions = positions_.data();
+        for (std::size_t block_id = 0;
+                block_id < block_function_ids_.size();
+                ++block_id) {
+            ConstraintId function_id = block_function_ids_[block_id];
+            double weight = (function_id == -1)?
+                sigma: eval_request->lambda[function_id];
+            if (weight == 0.0)
+                continue;
+            KNLONG start = block_starts_[block_id];
+            KNLONG end = block_starts_[block_id + 1];
+            for (KNLONG value_id = start; value_id < end; ++value_id)
+                hess[positions[value_id]] += weight * values[value_id];
+        }
+    }
+
+private:
+
+    /** Hessian pattern of the Lagrangian. */
+    HessianPattern hessian_pattern_;
+
+    /** Function of each block (-1 for the objective). */
+    std::vector<ConstraintId> block_function_ids_;
+
+    /** Offset of each block in the value buffer. */
+    std::vector<KNLONG> block_starts_ = {0};
+
+    /** Position in the Hessian array of each value. */
+    std::vector<KNLONG> positions_;
+
+    KNLONG add_block(
+            ConstraintId function_id,
+            const std::vector<VariableId>& variable_ids_1,
+            const std::vector<VariableId>& variable_ids_2)
+    {
+        KNLONG start = positions_.size();
+        for (std::size_t pos = 0; pos < variable_ids_1.size(); ++pos) {
+            positions_.push_back(hessian_pattern_.add(
+                        variable_ids_1[pos],
+                        variable_ids_2[pos]));
+        }
+        block_function_ids_.push_back(function_id);
+        block_starts_.push_back(positions_.size());
+        return start;
+    }
+
+};
+
+/**
+ * Class for recording the evaluations of the callbacks of a context in a
+ * trace file (see Context::start_trace), which can be replayed without
+ * Knitro with TraceReplay (replay.hpp).
+ *
+ * File format: the characters "KNTR", then the number of variables n and
+ * the number of constraints m (int64). Then, for each evaluation: the
+ * callback type (uint8: function, gradient, Hessian, Hessian-vector), the
+ * index of the callback (uint32), the request type and the return code of
+ * the callback (int32), sigma (double) and five arrays, each stored as its
+ * size (uint64) followed by its values (doubles): x, lambda, vec and the
+ * two outputs of the callback (obj and c, objGrad and jac, hess, or
+ * hessVec).
+ */
+class TraceRecorder
+{
+
+public:
+
+    /** Constructor. */
+    TraceRecorder(
+            const std::string& filename,
+            VariableId number_of_variables,
+            ConstraintId number_of_constraints):
+        file_(filename, std::ios::binary),
+        number_of_variables_(number_of_variables),
+        number_of_constraints_(number_of_constraints)
+    {
+        if (!file_)
+            throw std::runtime_error("KnitroCpp error: unable to open trace file '" + filename + "'.");
+        std::int64_t header[2] = {number_of_variables, number_of_constraints};
+        file_.write("KNTR", 4);
+        file_.write((const char*)header, sizeof(header));
+    }
+
+    /** Get the number of variables. */
+    VariableId number_of_variables() const { return number_of_variables_; }
+
+    /** Get the number of constraints. */
+    ConstraintId number_of_constraints() const { return number_of_constraints_; }
+
+    /** Structure for an array of a record. */
+    struct Array
+    {
+        const double* values;
+        std::size_t size;
+    };
+
+    /** Write a record; it may be called concurrently. */
+    void record(
+            std::uint8_t callback_type,
+            std::uint32_t callback_index,
+            std::int32_t request_type,
+            std::int32_t return_code,
+            double sigma,
+            const Array (&arrays)[5])
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        file_.write((const char*)&callback_type, sizeof(callback_type));
+        file_.write((const char*)&callback_index, sizeof(callback_index));
+        file_.write((const char*)&request_type, sizeof(request_type));
+        file_.write((const char*)&return_code, sizeof(return_code));
+        file_.write((const char*)&sigma, sizeof(sigma));
+        for (const Array& array: arrays) {
+            std::uint64_t size = (array.values == nullptr)? 0: array.size;
+            file_.write((const char*)&size, sizeof(size));
+            file_.write((const char*)array.values, size * sizeof(double));
+        }
+        number_of_records_++;
+    }
+
+    /** Get the number of records written. */
+    std::size_t number_of_records() const { return number_of_records_; }
+
+private:
+
+    /** Mutex protecting the file. */
+    std::mutex mutex_;
+
+    /** Trace file. */
+    std::ofstream file_;
+
+    /** Number of variables. */
+    VariableId number_of_variables_;
+
+    /** Number of constraints. */
+    ConstraintId number_of_constraints_;
+
+    /** Number of records written. */
+    std::size_t number_of_records_ = 0;
+
+};
+
+/**
+ * Structure for a sparse matrix retrieved from Knitro (see
+ * Context::get_jacobian, Context::get_rsd_jacobian and
+ * Context::get_hessian).
+ *
+ * The nonzeros are stored in the order returned by Knitro in coordinate
+ * format, and by row in compressed sparse row (CSR) format. The buffers are
+ * reused from one call to the next, so a matrix retrieved repeatedly is
+ * only allocated once.
+ */
+struct SparseMatrix
+{
+    /** Number of rows. */
+    KNINT number_of_rows = 0;
+
+    /** Number of columns. */
+    KNINT number_of_columns = 0;
+
+    /** Coordinate format, in the order of Knitro. */
+    std::vector<KNINT> row_ids;
+    std::vector<KNINT> column_ids;
+    std::vector<double> values;
+
+    /**
+     * CSR format: the nonzeros of row i are at positions row_starts[i] to
+     * row_starts[i + 1] - 1 of csr_column_ids and csr_values; they keep the
+     * order of Knitro within a row.
+     */
+    std::vector<KNLONG> row_starts;
+    std::vector<KNINT> csr_column_ids;
+    std::vector<double> csr_values;
+
+    /** Get the number of nonzeros. */
+    KNLONG number_of_nonzeros() const { return values.size(); }
+
+    /** Fill the CSR format from the coordinate format. */
+    void update_csr()
+    {
+        KNLONG number_of_nonzeros = values.size();
+        row_starts.assign(number_of_rows + 1, 0);
+        for (KNLONG pos = 0; pos < number_of_nonzeros; ++pos)
+            row_starts[row_ids[pos] + 1]++;
+        for (KNINT row_id = 0; row_id < number_of_rows; ++row_id)
+            row_starts[row_id + 1] += row_starts[row_id];
+        csr_column_ids.resize(number_of_nonzeros);
+        csr_values.resize(number_of_nonzeros);
+        // row_starts[i] is used as the insertion position of row i, then
+        // shifted back.
+        for (KNLONG pos = 0; pos < number_of_nonzeros; ++pos) {
+            KNLONG csr_pos = row_starts[row_ids[pos]]++;
+            csr_column_ids[csr_pos] = column_ids[pos];
+            csr_values[csr_pos] = values[pos];
+        }
+        for (KNINT row_id = number_of_rows; row_id > 0; --row_id)
+            row_starts[row_id] = row_starts[row_id - 1];
+        row_starts[0] = 0;
+    }
+};
+
+/**
+ * Structure for the number of evaluations and the time spent in a type of
+ * callback.
+ */
+struct CallbackTiming
+{
+    /** Number of evaluations. */
+    std::uint64_t number_of_evaluations = 0;
+
+    /** Total time, in seconds. */
+    double time = 0.0;
+
+    /** Get the average time of an evaluation, in seconds. */
+    double average_time() const
+    {
+        return (number_of_evaluations == 0)? 0.0: time / number_of_evaluations;
+    }
+};
+
+/**
+ * Structure for the timings of the evaluation callbacks of a context.
+ */
+struct CallbackTimings
+{
+    CallbackTiming function;
+    CallbackTiming gradient;
+    CallbackTiming hessian;
+    CallbackTiming hessian_vector;
+};
+
+/**
+ * Structure for the parameters of the Hessian strategy selection.
+ *
+ * The number of iterations of each option is estimated relative to the
+ * number of iterations with exact Hessians.
+ */
+struct HessianStrategyParameters
+{
+    /**
+     * Number of timed evaluations of each callback required before
+     * deciding; missing ones are obtained by calling the callbacks at the
+     * point given to choose_hessian_strategy.
+     */
+    std::uint64_t number_of_samples = 3;
+
+    /** Relative number of iterations with BFGS. */
+    double bfgs_relative_iterations = 2.0;
+
+    /** Relative number of iterations with L-BFGS. */
+    double lbfgs_relative_iterations = 3.0;
+
+    /** Number of Hessian-vector products per iteration with KN_HESSOPT_PRODUCT. */
+    double number_of_hessian_vector_products = 10.0;
+
+    /** Maximum number of variables for dense BFGS. */
+    VariableId maximum_number_of_bfgs_variables = 1000;
+
+    /** Time of a floating point operation, in seconds. */
+    double flop_time = 1e-9;
+
+    /**
+     * Maximum cost of the L-BFGS update relative to the evaluations; it
+     * bounds the L-BFGS memory.
+     */
+    double lbfgs_overhead_ratio = 0.1;
+
+    /** Minimum L-BFGS memory. */
+    int minimum_lmsize = 5;
+};
+
+/**
+ * Structure for the report of the Hessian strategy selection.
+ */
+struct HessianStrategyReport
+{
+    /** Selected value of the 'hessopt' parameter. */
+    int hessopt = KN_HESSOPT_EXACT;
+
+    /** Selected L-BFGS memory (if hessopt is KN_HESSOPT_LBFGS). */
+    int lmsize = 0;
+
+    /** Boolean indicating if the callbacks were called to get timings. */
+    bool probed = false;
+
+    /** Average time per iteration of each callback type, in seconds. */
+    double function_time = 0.0;
+    double gradient_time = 0.0;
+    double hessian_time = 0.0;
+    double hessian_vector_time = 0.0;
+
+    /**
+     * Estimated relative cost of each option; infinity if the option is
+     * not available.
+     */
+    double exact_cost = std::numeric_limits<double>::infinity();
+    double product_cost = std::numeric_limits<double>::infinity();
+    double bfgs_cost = std::numeric_limits<double>::infinity();
+    double lbfgs_cost = std::numeric_limits<double>::infinity();
+};
+
 /**
  * Class for a Knitro context.
  */
@@ -60,18 +897,28 @@ public:
     /** Constructor. */
     Context()
     {
-        int knitro_return_code = KN_new(&knitro_context_);
+        int knitro_return_code = KNITROCPP_KN(KN_new)(&knitro_context_);
         if (knitro_return_code != 0)
             throw KnitroException("KN_new", knitro_return_code);
         if (knitro_context_ == NULL)
             throw std::runtime_error("Failed to find a valid license.");
     }
 
+    /** Constructor from a license that has already been checked out. */
+    explicit Context(License& license)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_new_lm)(license.lm_context_, &knitro_context_);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_new_lm", knitro_return_code);
+        if (knitro_context_ == NULL)
+            throw std::runtime_error("Failed to find a valid license.");
+    }
+
     /** Destructor. */
     ~Context()
     {
         if (own_context_)
-            KN_free(&knitro_context_);
+            KNITROCPP_KN(KN_free)(&knitro_context_);
     }
 
     Context(const Context&) = delete;
@@ -84,7 +931,7 @@ public:
     /** Reset all parameters to their default values. */
     void reset_params_to_defaults()
     {
-        int knitro_return_code = KN_reset_params_to_defaults(knitro_context_);
+        int knitro_return_code = KNITROCPP_KN(KN_reset_params_to_defaults)(knitro_context_);
         if (knitro_return_code != 0)
             throw KnitroException("KN_reset_params_to_defaults", knitro_return_code);
     }
@@ -92,7 +939,7 @@ public:
     /** Load all parameters from a file. */
     void load_param_file(const std::string& filename)
     {
-        int knitro_return_code = KN_load_param_file(
+        int knitro_return_code = KNITROCPP_KN(KN_load_param_file)(
                 knitro_context_,
                 filename.c_str());
         if (knitro_return_code != 0)
@@ -102,7 +949,7 @@ public:
     /** Save all current parameter values to a file. */
     void save_param_file(const std::string& filename)
     {
-        int knitro_return_code = KN_save_param_file(
+        int knitro_return_code = KNITROCPP_KN(KN_save_param_file)(
                 knitro_context_,
                 filename.c_str());
         if (knitro_return_code != 0)
@@ -114,7 +961,7 @@ public:
             const int param_id,
             const int value)
     {
-        int knitro_return_code = KN_set_int_param(
+        int knitro_return_code = KNITROCPP_KN(KN_set_int_param)(
                 knitro_context_,
                 param_id,
                 value);
@@ -127,7 +974,7 @@ public:
             const int param_id,
             const char* const value)
     {
-        int knitro_return_code = KN_set_char_param(
+        int knitro_return_code = KNITROCPP_KN(KN_set_char_param)(
                 knitro_context_,
                 param_id,
                 value);
@@ -140,7 +987,7 @@ public:
             const int param_id,
             const double value)
     {
-        int knitro_return_code = KN_set_double_param(
+        int knitro_return_code = KNITROCPP_KN(KN_set_double_param)(
                 knitro_context_,
                 param_id,
                 value);
@@ -153,7 +1000,7 @@ public:
             const std::string& name,
             const int value)
     {
-        int knitro_return_code = KN_set_int_param_by_name(
+        int knitro_return_code = KNITROCPP_KN(KN_set_int_param_by_name)(
                 knitro_context_,
                 name.c_str(),
                 value);
@@ -166,7 +1013,7 @@ public:
             const std::string& name,
             const std::string& value)
     {
-        int knitro_return_code = KN_set_char_param_by_name(
+        int knitro_return_code = KNITROCPP_KN(KN_set_char_param_by_name)(
                 knitro_context_,
                 name.c_str(),
                 value.c_str());
@@ -179,7 +1026,7 @@ public:
             const std::string& name,
             const double value)
     {
-        int knitro_return_code = KN_set_double_param_by_name(
+        int knitro_return_code = KNITROCPP_KN(KN_set_double_param_by_name)(
                 knitro_context_,
                 name.c_str(),
                 value);
@@ -191,7 +1038,7 @@ public:
     int get_int_param(const int param_id) const
     {
         int value = 0;
-        int knitro_return_code = KN_get_int_param(
+        int knitro_return_code = KNITROCPP_KN(KN_get_int_param)(
                 knitro_context_,
                 param_id,
                 &value);
@@ -204,7 +1051,7 @@ public:
     double get_double_param(const int param_id) const
     {
         double value = 0.0;
-        int knitro_return_code = KN_get_double_param(
+        int knitro_return_code = KNITROCPP_KN(KN_get_double_param)(
                 knitro_context_,
                 param_id,
                 &value);
@@ -213,11 +1060,41 @@ public:
         return value;
     }
 
+    /** Set an integer valued parameter using its descriptor. */
+    void set(
+            const IntParamDescriptor& param,
+            const int value)
+    {
+        check_param_value(param, value);
+        set_int_param(param.id, value);
+    }
+
+    /** Set a double valued parameter using its descriptor. */
+    void set(
+            const DoubleParamDescriptor& param,
+            const double value)
+    {
+        check_param_value(param, value);
+        set_double_param(param.id, value);
+    }
+
+    /** Get an integer valued parameter using its descriptor. */
+    int get(const IntParamDescriptor& param) const
+    {
+        return get_int_param(param.id);
+    }
+
+    /** Get a double valued parameter using its descriptor. */
+    double get(const DoubleParamDescriptor& param) const
+    {
+        return get_double_param(param.id);
+    }
+
     /** Get an integer valued parameter using its string name. */
     int get_int_param_by_name(const std::string& name) const
     {
         int value = 0;
-        int knitro_return_code = KN_get_int_param_by_name(
+        int knitro_return_code = KNITROCPP_KN(KN_get_int_param_by_name)(
                 knitro_context_,
                 name.c_str(),
                 &value);
@@ -230,7 +1107,7 @@ public:
     double get_double_param_by_name(const std::string& name) const
     {
         double value = 0.0;
-        int knitro_return_code = KN_get_double_param_by_name(
+        int knitro_return_code = KNITROCPP_KN(KN_get_double_param_by_name)(
                 knitro_context_,
                 name.c_str(),
                 &value);
@@ -247,11 +1124,13 @@ public:
     VariableId add_var()
     {
         VariableId variable_id = -1;
-        int knitro_return_code = KN_add_var(
+        int knitro_return_code = KNITROCPP_KN(KN_add_var)(
                 knitro_context_,
                 &variable_id);
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_var", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->add_var();
         return variable_id;
     }
 
@@ -259,12 +1138,16 @@ public:
     std::vector<VariableId> add_vars(VariableId number_of_variables)
     {
         std::vector<VariableId> variable_ids(number_of_variables, -1);
-        int knitro_return_code = KN_add_vars(
+        int knitro_return_code = KNITROCPP_KN(KN_add_vars)(
                 knitro_context_,
                 number_of_variables,
                 variable_ids.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_vars", knitro_return_code);
+        if (structure_mirror_) {
+            for (VariableId pos = 0; pos < number_of_variables; ++pos)
+                structure_mirror_->add_var();
+        }
         return variable_ids;
     }
 
@@ -272,11 +1155,13 @@ public:
     ConstraintId add_con()
     {
         ConstraintId constraint_id = -1;
-        int knitro_return_code = KN_add_con(
+        int knitro_return_code = KNITROCPP_KN(KN_add_con)(
                 knitro_context_,
                 &constraint_id);
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_con", knitro_return_code);
+        if (structure_mirror_)
+            mirror_add_cons(1);
         return constraint_id;
     }
 
@@ -284,26 +1169,59 @@ public:
     std::vector<ConstraintId> add_cons(ConstraintId number_of_constraints)
     {
         std::vector<ConstraintId> constraint_ids(number_of_constraints, -1);
-        int knitro_return_code = KN_add_cons(
+        int knitro_return_code = KNITROCPP_KN(KN_add_cons)(
                 knitro_context_,
                 number_of_constraints,
                 constraint_ids.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_cons", knitro_return_code);
+        if (structure_mirror_)
+            mirror_add_cons(number_of_constraints);
         return constraint_ids;
     }
 
+    /** Add a residual to the problem. */
+    ResidualId add_rsd()
+    {
+        ResidualId residual_id = -1;
+        int knitro_return_code = KNITROCPP_KN(KN_add_rsd)(
+                knitro_context_,
+                &residual_id);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_rsd", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_least_squares_objective_ = true;
+        return residual_id;
+    }
+
+    /** Add number_of_residuals residuals to the problem, returning their ids. */
+    std::vector<ResidualId> add_rsds(ResidualId number_of_residuals)
+    {
+        std::vector<ResidualId> residual_ids(number_of_residuals, -1);
+        int knitro_return_code = KNITROCPP_KN(KN_add_rsds)(
+                knitro_context_,
+                number_of_residuals,
+                residual_ids.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_rsds", knitro_return_code);
+        if (structure_mirror_ && number_of_residuals > 0)
+            structure_mirror_least_squares_objective_ = true;
+        return residual_ids;
+    }
+
     /** Set the lower bound of a variable. */
     void set_var_lobnd(
             VariableId variable_id,
             double lower_bound)
     {
-        int knitro_return_code = KN_set_var_lobnd(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_lobnd)(
                 knitro_context_,
                 variable_id,
                 lower_bound);
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_lobnd", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->variable_lower_bounds[variable_id] = lower_bound;
     }
 
     /** Set the lower bounds of a subset of variables. */
@@ -311,24 +1229,28 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<double>& lower_bounds)
     {
-        int knitro_return_code = KN_set_var_lobnds(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_lobnds)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
                 lower_bounds.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_lobnds", knitro_return_code);
+        if (structure_mirror_)
+            mirror_values(structure_mirror_->variable_lower_bounds, variable_ids, lower_bounds);
     }
 
     /** Set the lower bounds of all variables. */
     void set_var_lobnds(
             const std::vector<double>& lower_bounds)
     {
-        int knitro_return_code = KN_set_var_lobnds_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_lobnds_all)(
                 knitro_context_,
                 lower_bounds.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_lobnds_all", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->variable_lower_bounds = lower_bounds;
     }
 
     /** Set the upper bound of a variable. */
@@ -336,12 +1258,14 @@ public:
             VariableId variable_id,
             double upper_bound)
     {
-        int knitro_return_code = KN_set_var_upbnd(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_upbnd)(
                 knitro_context_,
                 variable_id,
                 upper_bound);
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_upbnd", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->variable_upper_bounds[variable_id] = upper_bound;
     }
 
     /** Set the upper bounds of a subset of variables. */
@@ -349,24 +1273,28 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<double>& upper_bounds)
     {
-        int knitro_return_code = KN_set_var_upbnds(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_upbnds)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
                 upper_bounds.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_upbnds", knitro_return_code);
+        if (structure_mirror_)
+            mirror_values(structure_mirror_->variable_upper_bounds, variable_ids, upper_bounds);
     }
 
     /** Set the upper bounds of all variables. */
     void set_var_upbnds(
             const std::vector<double>& upper_bounds)
     {
-        int knitro_return_code = KN_set_var_upbnds_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_upbnds_all)(
                 knitro_context_,
                 upper_bounds.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_upbnds_all", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->variable_upper_bounds = upper_bounds;
     }
 
     /** Set a fixed bound on a variable (lower == upper). */
@@ -374,12 +1302,16 @@ public:
             VariableId variable_id,
             double fixed_bound)
     {
-        int knitro_return_code = KN_set_var_fxbnd(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_fxbnd)(
                 knitro_context_,
                 variable_id,
                 fixed_bound);
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_fxbnd", knitro_return_code);
+        if (structure_mirror_) {
+            structure_mirror_->variable_lower_bounds[variable_id] = fixed_bound;
+            structure_mirror_->variable_upper_bounds[variable_id] = fixed_bound;
+        }
     }
 
     /** Set fixed bounds on a subset of variables. */
@@ -387,24 +1319,32 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<double>& fixed_bounds)
     {
-        int knitro_return_code = KN_set_var_fxbnds(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_fxbnds)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
                 fixed_bounds.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_fxbnds", knitro_return_code);
+        if (structure_mirror_) {
+            mirror_values(structure_mirror_->variable_lower_bounds, variable_ids, fixed_bounds);
+            mirror_values(structure_mirror_->variable_upper_bounds, variable_ids, fixed_bounds);
+        }
     }
 
     /** Set fixed bounds on all variables. */
     void set_var_fxbnds(
             const std::vector<double>& fixed_bounds)
     {
-        int knitro_return_code = KN_set_var_fxbnds_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_fxbnds_all)(
                 knitro_context_,
                 fixed_bounds.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_fxbnds_all", knitro_return_code);
+        if (structure_mirror_) {
+            structure_mirror_->variable_lower_bounds = fixed_bounds;
+            structure_mirror_->variable_upper_bounds = fixed_bounds;
+        }
     }
 
     /** Get the lower bound of a variable. */
@@ -412,7 +1352,7 @@ public:
             VariableId variable_id) const
     {
         double lower_bound = 0.0;
-        int knitro_return_code = KN_get_var_lobnd(
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_lobnd)(
                 knitro_context_,
                 variable_id,
                 &lower_bound);
@@ -426,7 +1366,7 @@ public:
             VariableId variable_id) const
     {
         double upper_bound = 0.0;
-        int knitro_return_code = KN_get_var_upbnd(
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_upbnd)(
                 knitro_context_,
                 variable_id,
                 &upper_bound);
@@ -435,12 +1375,36 @@ public:
         return upper_bound;
     }
 
+    /** Get the lower bounds of all variables. */
+    std::vector<double> get_var_lobnds() const
+    {
+        std::vector<double> lower_bounds(this->get_number_vars(), 0.0);
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_lobnds_all)(
+                knitro_context_,
+                lower_bounds.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_get_var_lobnds_all", knitro_return_code);
+        return lower_bounds;
+    }
+
+    /** Get the upper bounds of all variables. */
+    std::vector<double> get_var_upbnds() const
+    {
+        std::vector<double> upper_bounds(this->get_number_vars(), 0.0);
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_upbnds_all)(
+                knitro_context_,
+                upper_bounds.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_get_var_upbnds_all", knitro_return_code);
+        return upper_bounds;
+    }
+
     /** Get the fixed bound of a variable. */
     double get_var_fxbnd(
             VariableId variable_id) const
     {
         double fixed_bound = 0.0;
-        int knitro_return_code = KN_get_var_fxbnd(
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_fxbnd)(
                 knitro_context_,
                 variable_id,
                 &fixed_bound);
@@ -454,12 +1418,14 @@ public:
             VariableId variable_id,
             int variable_type)
     {
-        int knitro_return_code = KN_set_var_type(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_type)(
                 knitro_context_,
                 variable_id,
                 variable_type);
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_type", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->variable_types[variable_id] = variable_type;
     }
 
     /** Set the types of a subset of variables. */
@@ -467,24 +1433,28 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<int>& variable_types)
     {
-        int knitro_return_code = KN_set_var_types(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_types)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
                 variable_types.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_types", knitro_return_code);
+        if (structure_mirror_)
+            mirror_values(structure_mirror_->variable_types, variable_ids, variable_types);
     }
 
     /** Set the types of all variables. */
     void set_var_types(
             const std::vector<int>& variable_types)
     {
-        int knitro_return_code = KN_set_var_types_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_types_all)(
                 knitro_context_,
                 variable_types.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_var_types_all", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->variable_types = variable_types;
     }
 
     /** Get the type of a variable. */
@@ -492,7 +1462,7 @@ public:
             VariableId variable_id) const
     {
         int variable_type = -1;
-        int knitro_return_code = KN_get_var_type(
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_type)(
                 knitro_context_,
                 variable_id,
                 &variable_type);
@@ -506,7 +1476,7 @@ public:
             VariableId variable_id,
             int property)
     {
-        int knitro_return_code = KN_set_var_property(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_property)(
                 knitro_context_,
                 variable_id,
                 property);
@@ -519,7 +1489,7 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<int>& properties)
     {
-        int knitro_return_code = KN_set_var_properties(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_properties)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
@@ -532,7 +1502,7 @@ public:
     void set_var_properties(
             const std::vector<int>& properties)
     {
-        int knitro_return_code = KN_set_var_properties_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_properties_all)(
                 knitro_context_,
                 properties.data());
         if (knitro_return_code != 0)
@@ -544,12 +1514,14 @@ public:
             ConstraintId constraint_id,
             double lower_bound)
     {
-        int knitro_return_code = KN_set_con_lobnd(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_lobnd)(
                 knitro_context_,
                 constraint_id,
                 lower_bound);
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_con_lobnd", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->constraint_lower_bounds[constraint_id] = lower_bound;
     }
 
     /** Set the lower bounds of a subset of constraints. */
@@ -557,24 +1529,28 @@ public:
             const std::vector<ConstraintId>& constraint_ids,
             const std::vector<double>& lower_bounds)
     {
-        int knitro_return_code = KN_set_con_lobnds(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_lobnds)(
                 knitro_context_,
                 constraint_ids.size(),
                 constraint_ids.data(),
                 lower_bounds.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_con_lobnds", knitro_return_code);
+        if (structure_mirror_)
+            mirror_values(structure_mirror_->constraint_lower_bounds, constraint_ids, lower_bounds);
     }
 
     /** Set the lower bounds of all constraints. */
     void set_con_lobnds(
             const std::vector<double>& lower_bounds)
     {
-        int knitro_return_code = KN_set_con_lobnds_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_lobnds_all)(
                 knitro_context_,
                 lower_bounds.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_con_lobnds_all", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->constraint_lower_bounds = lower_bounds;
     }
 
     /** Set the upper bound of a constraint. */
@@ -582,12 +1558,14 @@ public:
             ConstraintId constraint_id,
             double upper_bound)
     {
-        int knitro_return_code = KN_set_con_upbnd(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_upbnd)(
                 knitro_context_,
                 constraint_id,
                 upper_bound);
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_con_upbnd", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->constraint_upper_bounds[constraint_id] = upper_bound;
     }
 
     /** Set the upper bounds of a subset of constraints. */
@@ -595,24 +1573,28 @@ public:
             const std::vector<ConstraintId>& constraint_ids,
             const std::vector<double>& upper_bounds)
     {
-        int knitro_return_code = KN_set_con_upbnds(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_upbnds)(
                 knitro_context_,
                 constraint_ids.size(),
                 constraint_ids.data(),
                 upper_bounds.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_con_upbnds", knitro_return_code);
+        if (structure_mirror_)
+            mirror_values(structure_mirror_->constraint_upper_bounds, constraint_ids, upper_bounds);
     }
 
     /** Set the upper bounds of all constraints. */
     void set_con_upbnds(
             const std::vector<double>& upper_bounds)
     {
-        int knitro_return_code = KN_set_con_upbnds_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_upbnds_all)(
                 knitro_context_,
                 upper_bounds.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_con_upbnds_all", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->constraint_upper_bounds = upper_bounds;
     }
 
     /** Set an equality bound on a constraint. */
@@ -620,12 +1602,16 @@ public:
             ConstraintId constraint_id,
             double value)
     {
-        int knitro_return_code = KN_set_con_eqbnd(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_eqbnd)(
                 knitro_context_,
                 constraint_id,
                 value);
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_con_eqbnd", knitro_return_code);
+        if (structure_mirror_) {
+            structure_mirror_->constraint_lower_bounds[constraint_id] = value;
+            structure_mirror_->constraint_upper_bounds[constraint_id] = value;
+        }
     }
 
     /** Set equality bounds on a subset of constraints. */
@@ -633,24 +1619,32 @@ public:
             const std::vector<ConstraintId>& constraint_ids,
             const std::vector<double>& values)
     {
-        int knitro_return_code = KN_set_con_eqbnds(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_eqbnds)(
                 knitro_context_,
                 constraint_ids.size(),
                 constraint_ids.data(),
                 values.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_con_eqbnds", knitro_return_code);
+        if (structure_mirror_) {
+            mirror_values(structure_mirror_->constraint_lower_bounds, constraint_ids, values);
+            mirror_values(structure_mirror_->constraint_upper_bounds, constraint_ids, values);
+        }
     }
 
     /** Set equality bounds on all constraints. */
     void set_con_eqbnds(
             const std::vector<double>& values)
     {
-        int knitro_return_code = KN_set_con_eqbnds_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_eqbnds_all)(
                 knitro_context_,
                 values.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_con_eqbnds_all", knitro_return_code);
+        if (structure_mirror_) {
+            structure_mirror_->constraint_lower_bounds = values;
+            structure_mirror_->constraint_upper_bounds = values;
+        }
     }
 
     /** Get the lower bound of a constraint. */
@@ -658,7 +1652,7 @@ public:
             ConstraintId constraint_id) const
     {
         double lower_bound = 0.0;
-        int knitro_return_code = KN_get_con_lobnd(
+        int knitro_return_code = KNITROCPP_KN(KN_get_con_lobnd)(
                 knitro_context_,
                 constraint_id,
                 &lower_bound);
@@ -672,7 +1666,7 @@ public:
             ConstraintId constraint_id) const
     {
         double upper_bound = 0.0;
-        int knitro_return_code = KN_get_con_upbnd(
+        int knitro_return_code = KNITROCPP_KN(KN_get_con_upbnd)(
                 knitro_context_,
                 constraint_id,
                 &upper_bound);
@@ -686,7 +1680,7 @@ public:
             ConstraintId constraint_id) const
     {
         double value = 0.0;
-        int knitro_return_code = KN_get_con_eqbnd(
+        int knitro_return_code = KNITROCPP_KN(KN_get_con_eqbnd)(
                 knitro_context_,
                 constraint_id,
                 &value);
@@ -699,18 +1693,20 @@ public:
     void set_obj_goal(
             int objective_goal)
     {
-        int knitro_return_code = KN_set_obj_goal(
+        int knitro_return_code = KNITROCPP_KN(KN_set_obj_goal)(
                 knitro_context_,
                 objective_goal);
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_obj_goal", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->objective_goal = objective_goal;
     }
 
     /** Get the objective goal (KN_OBJGOAL_MINIMIZE or KN_OBJGOAL_MAXIMIZE). */
     int get_obj_goal() const
     {
         int objective_goal = -1;
-        int knitro_return_code = KN_get_obj_goal(
+        int knitro_return_code = KNITROCPP_KN(KN_get_obj_goal)(
                 knitro_context_,
                 &objective_goal);
         if (knitro_return_code != 0)
@@ -721,7 +1717,7 @@ public:
     /** Set properties on the objective function. */
     void set_obj_property(int property)
     {
-        int knitro_return_code = KN_set_obj_property(
+        int knitro_return_code = KNITROCPP_KN(KN_set_obj_property)(
                 knitro_context_,
                 property);
         if (knitro_return_code != 0)
@@ -733,7 +1729,7 @@ public:
             ConstraintId constraint_id,
             int property)
     {
-        int knitro_return_code = KN_set_con_property(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_property)(
                 knitro_context_,
                 constraint_id,
                 property);
@@ -746,7 +1742,7 @@ public:
             const std::vector<ConstraintId>& constraint_ids,
             const std::vector<int>& properties)
     {
-        int knitro_return_code = KN_set_con_properties(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_properties)(
                 knitro_context_,
                 constraint_ids.size(),
                 constraint_ids.data(),
@@ -759,7 +1755,7 @@ public:
     void set_con_properties(
             const std::vector<int>& properties)
     {
-        int knitro_return_code = KN_set_con_properties_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_properties_all)(
                 knitro_context_,
                 properties.data());
         if (knitro_return_code != 0)
@@ -771,7 +1767,7 @@ public:
             VariableId variable_id,
             double value)
     {
-        int knitro_return_code = KN_set_var_primal_init_value(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_primal_init_value)(
                 knitro_context_,
                 variable_id,
                 value);
@@ -784,7 +1780,7 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<double>& values)
     {
-        int knitro_return_code = KN_set_var_primal_init_values(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_primal_init_values)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
@@ -797,7 +1793,7 @@ public:
     void set_var_primal_init_values(
             const std::vector<double>& values)
     {
-        int knitro_return_code = KN_set_var_primal_init_values_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_primal_init_values_all)(
                 knitro_context_,
                 values.data());
         if (knitro_return_code != 0)
@@ -809,7 +1805,7 @@ public:
             VariableId variable_id,
             double value)
     {
-        int knitro_return_code = KN_set_var_dual_init_value(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_dual_init_value)(
                 knitro_context_,
                 variable_id,
                 value);
@@ -822,7 +1818,7 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<double>& values)
     {
-        int knitro_return_code = KN_set_var_dual_init_values(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_dual_init_values)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
@@ -835,7 +1831,7 @@ public:
     void set_var_dual_init_values(
             const std::vector<double>& values)
     {
-        int knitro_return_code = KN_set_var_dual_init_values_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_dual_init_values_all)(
                 knitro_context_,
                 values.data());
         if (knitro_return_code != 0)
@@ -847,7 +1843,7 @@ public:
             ConstraintId constraint_id,
             double value)
     {
-        int knitro_return_code = KN_set_con_dual_init_value(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_dual_init_value)(
                 knitro_context_,
                 constraint_id,
                 value);
@@ -860,7 +1856,7 @@ public:
             const std::vector<ConstraintId>& constraint_ids,
             const std::vector<double>& values)
     {
-        int knitro_return_code = KN_set_con_dual_init_values(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_dual_init_values)(
                 knitro_context_,
                 constraint_ids.size(),
                 constraint_ids.data(),
@@ -873,7 +1869,7 @@ public:
     void set_con_dual_init_values(
             const std::vector<double>& values)
     {
-        int knitro_return_code = KN_set_con_dual_init_values_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_dual_init_values_all)(
                 knitro_context_,
                 values.data());
         if (knitro_return_code != 0)
@@ -888,52 +1884,95 @@ public:
     void add_obj_constant(
             const double constant)
     {
-        int knitro_return_code = KN_add_obj_constant(
+        int knitro_return_code = KNITROCPP_KN(KN_add_obj_constant)(
                 knitro_context_,
                 constant);
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_obj_constant", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->objective_constant += constant;
     }
 
     /** Delete all constant terms from the objective function. */
     void del_obj_constant()
     {
-        int knitro_return_code = KN_del_obj_constant(knitro_context_);
+        int knitro_return_code = KNITROCPP_KN(KN_del_obj_constant)(knitro_context_);
         if (knitro_return_code != 0)
             throw KnitroException("KN_del_obj_constant", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->objective_constant = 0.0;
     }
 
     /** Change the constant term in the objective function. */
     void chg_obj_constant(const double constant)
     {
-        int knitro_return_code = KN_chg_obj_constant(
+        int knitro_return_code = KNITROCPP_KN(KN_chg_obj_constant)(
+                knitro_context_,
+                constant);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_chg_obj_constant", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->objective_constant = constant;
+    }
+
+    /** Add a constant to a constraint function. */
+    void add_con_constant(
+            ConstraintId constraint_id,
+            const double constant)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_add_con_constant)(
+                knitro_context_,
+                constraint_id,
+                constant);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_con_constant", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->constraint_constants[constraint_id] += constant;
+    }
+
+    /** Add constants to a subset of constraint functions. */
+    void add_con_constants(
+            const std::vector<ConstraintId>& constraint_ids,
+            const std::vector<double>& constants)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_add_con_constants)(
                 knitro_context_,
-                constant);
+                constraint_ids.size(),
+                constraint_ids.data(),
+                constants.data());
         if (knitro_return_code != 0)
-            throw KnitroException("KN_chg_obj_constant", knitro_return_code);
+            throw KnitroException("KN_add_con_constants", knitro_return_code);
+        if (structure_mirror_) {
+            for (std::size_t pos = 0; pos < constraint_ids.size(); ++pos)
+                structure_mirror_->constraint_constants[constraint_ids[pos]] += constants[pos];
+        }
     }
 
-    /** Add a constant to a constraint function. */
-    void add_con_constant(
-            ConstraintId constraint_id,
-            const double constant)
+    /** Add constants to all constraint functions. */
+    void add_con_constants(
+            const std::vector<double>& constants)
     {
-        int knitro_return_code = KN_add_con_constant(
+        int knitro_return_code = KNITROCPP_KN(KN_add_con_constants_all)(
                 knitro_context_,
-                constraint_id,
-                constant);
+                constants.data());
         if (knitro_return_code != 0)
-            throw KnitroException("KN_add_con_constant", knitro_return_code);
+            throw KnitroException("KN_add_con_constants_all", knitro_return_code);
+        if (structure_mirror_) {
+            for (std::size_t pos = 0; pos < constants.size(); ++pos)
+                structure_mirror_->constraint_constants[pos] += constants[pos];
+        }
     }
 
     /** Delete all constant terms from a constraint function. */
     void del_con_constant(ConstraintId constraint_id)
     {
-        int knitro_return_code = KN_del_con_constant(
+        int knitro_return_code = KNITROCPP_KN(KN_del_con_constant)(
                 knitro_context_,
                 constraint_id);
         if (knitro_return_code != 0)
             throw KnitroException("KN_del_con_constant", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->constraint_constants[constraint_id] = 0.0;
     }
 
     /** Change the constant term in a constraint function. */
@@ -941,12 +1980,70 @@ public:
             ConstraintId constraint_id,
             const double constant)
     {
-        int knitro_return_code = KN_chg_con_constant(
+        int knitro_return_code = KNITROCPP_KN(KN_chg_con_constant)(
                 knitro_context_,
                 constraint_id,
                 constant);
         if (knitro_return_code != 0)
             throw KnitroException("KN_chg_con_constant", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->constraint_constants[constraint_id] = constant;
+    }
+
+    /** Change the constant terms of a subset of constraint functions. */
+    void chg_con_constants(
+            const std::vector<ConstraintId>& constraint_ids,
+            const std::vector<double>& constants)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_chg_con_constants)(
+                knitro_context_,
+                constraint_ids.size(),
+                constraint_ids.data(),
+                constants.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_chg_con_constants", knitro_return_code);
+        if (structure_mirror_) {
+            for (std::size_t pos = 0; pos < constraint_ids.size(); ++pos)
+                structure_mirror_->constraint_constants[constraint_ids[pos]] = constants[pos];
+        }
+    }
+
+    /** Add a constant to a residual function. */
+    void add_rsd_constant(
+            ResidualId residual_id,
+            const double constant)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_add_rsd_constant)(
+                knitro_context_,
+                residual_id,
+                constant);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_rsd_constant", knitro_return_code);
+    }
+
+    /** Add constants to a subset of residual functions. */
+    void add_rsd_constants(
+            const std::vector<ResidualId>& residual_ids,
+            const std::vector<double>& constants)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_add_rsd_constants)(
+                knitro_context_,
+                residual_ids.size(),
+                residual_ids.data(),
+                constants.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_rsd_constants", knitro_return_code);
+    }
+
+    /** Add constants to all residual functions. */
+    void add_rsd_constants(
+            const std::vector<double>& constants)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_add_rsd_constants_all)(
+                knitro_context_,
+                constants.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_rsd_constants_all", knitro_return_code);
     }
 
     /*
@@ -958,13 +2055,17 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<double>& coefficients)
     {
-        int knitro_return_code = KN_add_obj_linear_struct(
+        int knitro_return_code = KNITROCPP_KN(KN_add_obj_linear_struct)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
                 coefficients.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_obj_linear_struct", knitro_return_code);
+        if (structure_mirror_) {
+            for (std::size_t pos = 0; pos < variable_ids.size(); ++pos)
+                structure_mirror_->add_obj_linear_term(variable_ids[pos], coefficients[pos]);
+        }
     }
 
     /** Add linear structure to the objective function. */
@@ -972,12 +2073,14 @@ public:
             VariableId variable_id,
             const double coefficient)
     {
-        int knitro_return_code = KN_add_obj_linear_term (
+        int knitro_return_code = KNITROCPP_KN(KN_add_obj_linear_term)(
                 knitro_context_,
                 variable_id,
                 coefficient);
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_obj_linear_term", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->add_obj_linear_term(variable_id, coefficient);
     }
 
     /** Add linear structure to multiple constraint functions at once. */
@@ -986,7 +2089,7 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<double>& coefficients)
     {
-        int knitro_return_code = KN_add_con_linear_struct(
+        int knitro_return_code = KNITROCPP_KN(KN_add_con_linear_struct)(
                 knitro_context_,
                 constraint_ids.size(),
                 constraint_ids.data(),
@@ -994,6 +2097,10 @@ public:
                 coefficients.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_con_linear_struct", knitro_return_code);
+        if (structure_mirror_) {
+            for (std::size_t pos = 0; pos < constraint_ids.size(); ++pos)
+                structure_mirror_->add_con_linear_term(constraint_ids[pos], variable_ids[pos], coefficients[pos]);
+        }
     }
 
     /** Add linear structure to one constraint function (bulk). */
@@ -1002,7 +2109,7 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<double>& coefficients)
     {
-        int knitro_return_code = KN_add_con_linear_struct_one(
+        int knitro_return_code = KNITROCPP_KN(KN_add_con_linear_struct_one)(
                 knitro_context_,
                 variable_ids.size(),
                 constraint_id,
@@ -1010,6 +2117,10 @@ public:
                 coefficients.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_con_linear_struct_one", knitro_return_code);
+        if (structure_mirror_) {
+            for (std::size_t pos = 0; pos < variable_ids.size(); ++pos)
+                structure_mirror_->add_con_linear_term(constraint_id, variable_ids[pos], coefficients[pos]);
+        }
     }
 
     /** Add linear structure to the constraint functions. */
@@ -1018,13 +2129,62 @@ public:
             VariableId variable_id,
             const double coefficient)
     {
-        int knitro_return_code = KN_add_con_linear_term(
+        int knitro_return_code = KNITROCPP_KN(KN_add_con_linear_term)(
                 knitro_context_,
                 constraint_id,
                 variable_id,
                 coefficient);
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_con_linear_term", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->add_con_linear_term(constraint_id, variable_id, coefficient);
+    }
+
+    /** Add linear structure to multiple residual functions at once. */
+    void add_rsd_linear_struct(
+            const std::vector<ResidualId>& residual_ids,
+            const std::vector<VariableId>& variable_ids,
+            const std::vector<double>& coefficients)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_add_rsd_linear_struct)(
+                knitro_context_,
+                residual_ids.size(),
+                residual_ids.data(),
+                variable_ids.data(),
+                coefficients.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_rsd_linear_struct", knitro_return_code);
+    }
+
+    /** Add linear structure to one residual function (bulk). */
+    void add_rsd_linear_struct_one(
+            ResidualId residual_id,
+            const std::vector<VariableId>& variable_ids,
+            const std::vector<double>& coefficients)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_add_rsd_linear_struct_one)(
+                knitro_context_,
+                variable_ids.size(),
+                residual_id,
+                variable_ids.data(),
+                coefficients.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_rsd_linear_struct_one", knitro_return_code);
+    }
+
+    /** Add linear structure to the residual functions. */
+    void add_rsd_linear_term(
+            ResidualId residual_id,
+            VariableId variable_id,
+            const double coefficient)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_add_rsd_linear_term)(
+                knitro_context_,
+                residual_id,
+                variable_id,
+                coefficient);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_rsd_linear_term", knitro_return_code);
     }
 
     /*
@@ -1037,7 +2197,7 @@ public:
             const std::vector<VariableId>& variable_ids_2,
             const std::vector<double>& coefficients)
     {
-        int knitro_return_code = KN_add_obj_quadratic_struct(
+        int knitro_return_code = KNITROCPP_KN(KN_add_obj_quadratic_struct)(
                 knitro_context_,
                 variable_ids_1.size(),
                 variable_ids_1.data(),
@@ -1045,6 +2205,10 @@ public:
                 coefficients.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_obj_quadratic_struct", knitro_return_code);
+        if (structure_mirror_) {
+            for (std::size_t pos = 0; pos < variable_ids_1.size(); ++pos)
+                structure_mirror_->add_obj_quadratic_term(variable_ids_1[pos], variable_ids_2[pos], coefficients[pos]);
+        }
     }
 
     /** Add quadratic structure to the objective. */
@@ -1053,13 +2217,15 @@ public:
             VariableId variable_id_2,
             const double coefficient)
     {
-        int knitro_return_code = KN_add_obj_quadratic_term(
+        int knitro_return_code = KNITROCPP_KN(KN_add_obj_quadratic_term)(
                 knitro_context_,
                 variable_id_1,
                 variable_id_2,
                 coefficient);
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_obj_quadratic_term", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->add_obj_quadratic_term(variable_id_1, variable_id_2, coefficient);
     }
 
     /** Add quadratic structure to multiple constraint functions at once. */
@@ -1069,7 +2235,7 @@ public:
             const std::vector<VariableId>& variable_ids_2,
             const std::vector<double>& coefficients)
     {
-        int knitro_return_code = KN_add_con_quadratic_struct(
+        int knitro_return_code = KNITROCPP_KN(KN_add_con_quadratic_struct)(
                 knitro_context_,
                 constraint_ids.size(),
                 constraint_ids.data(),
@@ -1078,6 +2244,10 @@ public:
                 coefficients.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_con_quadratic_struct", knitro_return_code);
+        if (structure_mirror_) {
+            for (std::size_t pos = 0; pos < constraint_ids.size(); ++pos)
+                structure_mirror_->add_con_quadratic_term(constraint_ids[pos], variable_ids_1[pos], variable_ids_2[pos], coefficients[pos]);
+        }
     }
 
     /** Add quadratic structure to one constraint function (bulk). */
@@ -1087,7 +2257,7 @@ public:
             const std::vector<VariableId>& variable_ids_2,
             const std::vector<double>& coefficients)
     {
-        int knitro_return_code = KN_add_con_quadratic_struct_one(
+        int knitro_return_code = KNITROCPP_KN(KN_add_con_quadratic_struct_one)(
                 knitro_context_,
                 variable_ids_1.size(),
                 constraint_id,
@@ -1096,6 +2266,10 @@ public:
                 coefficients.data());
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_con_quadratic_struct_one", knitro_return_code);
+        if (structure_mirror_) {
+            for (std::size_t pos = 0; pos < variable_ids_1.size(); ++pos)
+                structure_mirror_->add_con_quadratic_term(constraint_id, variable_ids_1[pos], variable_ids_2[pos], coefficients[pos]);
+        }
     }
 
     /** Add quadratic structure to the constraint functions. */
@@ -1105,7 +2279,7 @@ public:
             VariableId variable_id_2,
             const double coefficient)
     {
-        int knitro_return_code = KN_add_con_quadratic_term(
+        int knitro_return_code = KNITROCPP_KN(KN_add_con_quadratic_term)(
                 knitro_context_,
                 constraint_id,
                 variable_id_1,
@@ -1113,16 +2287,306 @@ public:
                 coefficient);
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_con_quadratic_term", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_->add_con_quadratic_term(constraint_id, variable_id_1, variable_id_2, coefficient);
     }
 
     /*
      * Adding conic structure
      */
 
+    /**
+     * Add L2 norm structure ||Ax + b||_2 to a constraint function.
+     *
+     * The matrix A has number_of_coordinates rows and is given in
+     * coordinate format: coordinate_ids[k] is the row, variable_ids[k] the
+     * column and coefficients[k] the value of its k-th nonzero. constants
+     * is the vector b; it may be left empty if b = 0.
+     *
+     * A second-order cone constraint ||Ax + b||_2 <= c^T x + d is obtained
+     * by adding the linear structure -c^T x and constant -d to the same
+     * constraint and setting its upper bound to 0.
+     */
+    void add_con_L2norm(
+            ConstraintId constraint_id,
+            KNINT number_of_coordinates,
+            const std::vector<KNINT>& coordinate_ids,
+            const std::vector<VariableId>& variable_ids,
+            const std::vector<double>& coefficients,
+            const std::vector<double>& constants = {})
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_add_con_L2norm)(
+                knitro_context_,
+                constraint_id,
+                number_of_coordinates,
+                coordinate_ids.size(),
+                coordinate_ids.data(),
+                variable_ids.data(),
+                coefficients.data(),
+                (constants.empty())? nullptr: constants.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_con_L2norm", knitro_return_code);
+        if (structure_mirror_)
+            structure_mirror_nonlinear_constraints_[constraint_id] |= 2;
+    }
+
     /*
      * Adding complementarity constraints
      */
 
+    /**
+     * Set complementarity constraints between pairs of variables.
+     *
+     * For each k, variables variable_ids_1[k] and variable_ids_2[k] are
+     * complementary, with type complementarity_types[k] (e.g.
+     * KN_CCTYPE_VARVAR).
+     */
+    void set_compcons(
+            const std::vector<int>& complementarity_types,
+            const std::vector<VariableId>& variable_ids_1,
+            const std::vector<VariableId>& variable_ids_2)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_set_compcons)(
+                knitro_context_,
+                variable_ids_1.size(),
+                complementarity_types.data(),
+                variable_ids_1.data(),
+                variable_ids_2.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_compcons", knitro_return_code);
+    }
+
+    /** Set complementarity constraints of type KN_CCTYPE_VARVAR. */
+    void set_compcons(
+            const std::vector<VariableId>& variable_ids_1,
+            const std::vector<VariableId>& variable_ids_2)
+    {
+        set_compcons(
+                std::vector<int>(variable_ids_1.size(), KN_CCTYPE_VARVAR),
+                variable_ids_1,
+                variable_ids_2);
+    }
+
+    /*
+     * Loading a staged model
+     */
+
+    /**
+     * Add the variables, constraints and structure of a model.
+     *
+     * The variables and constraints are added after the ones already in the
+     * context; the ids of the model are shifted accordingly.
+     */
+    void load_model(const Model& model)
+    {
+        VariableId variable_offset = get_number_vars();
+        ConstraintId constraint_offset = get_number_cons();
+        std::vector<VariableId> variable_ids = add_vars(model.number_of_variables());
+        std::vector<ConstraintId> constraint_ids = add_cons(model.number_of_constraints());
+        auto shift_variable_ids = [variable_offset](const std::vector<VariableId>& ids)
+        {
+            std::vector<VariableId> shifted_ids(ids);
+            for (VariableId& id: shifted_ids)
+                id += variable_offset;
+            return shifted_ids;
+        };
+        auto shift_constraint_ids = [constraint_offset](const std::vector<ConstraintId>& ids)
+        {
+            std::vector<ConstraintId> shifted_ids(ids);
+            for (ConstraintId& id: shifted_ids)
+                id += constraint_offset;
+            return shifted_ids;
+        };
+
+        if (!variable_ids.empty()) {
+            set_var_lobnds(variable_ids, model.variable_lower_bounds);
+            set_var_upbnds(variable_ids, model.variable_upper_bounds);
+            set_var_types(variable_ids, model.variable_types);
+        }
+        if (!constraint_ids.empty()) {
+            set_con_lobnds(constraint_ids, model.constraint_lower_bounds);
+            set_con_upbnds(constraint_ids, model.constraint_upper_bounds);
+            add_con_constants(constraint_ids, model.constraint_constants);
+        }
+
+        set_obj_goal(model.objective_goal);
+        if (model.objective_constant != 0.0)
+            add_obj_constant(model.objective_constant);
+        if (!model.objective_linear_variable_ids.empty()) {
+            add_obj_linear_struct(
+                    shift_variable_ids(model.objective_linear_variable_ids),
+                    model.objective_linear_coefficients);
+        }
+        if (!model.objective_quadratic_variable_ids_1.empty()) {
+            add_obj_quadratic_struct(
+                    shift_variable_ids(model.objective_quadratic_variable_ids_1),
+                    shift_variable_ids(model.objective_quadratic_variable_ids_2),
+                    model.objective_quadratic_coefficients);
+        }
+        if (!model.constraint_linear_constraint_ids.empty()) {
+            add_con_linear_struct(
+                    shift_constraint_ids(model.constraint_linear_constraint_ids),
+                    shift_variable_ids(model.constraint_linear_variable_ids),
+                    model.constraint_linear_coefficients);
+        }
+        if (!model.constraint_quadratic_constraint_ids.empty()) {
+            add_con_quadratic_struct(
+                    shift_constraint_ids(model.constraint_quadratic_constraint_ids),
+                    shift_variable_ids(model.constraint_quadratic_variable_ids_1),
+                    shift_variable_ids(model.constraint_quadratic_variable_ids_2),
+                    model.constraint_quadratic_coefficients);
+        }
+    }
+
+    /*
+     * Scaling
+     */
+
+    /**
+     * Set the scaling factors and centers of a subset of variables, such
+     * that x = scale_factor * x_scaled + scale_center. scale_centers may be
+     * left empty.
+     */
+    void set_var_scalings(
+            const std::vector<VariableId>& variable_ids,
+            const std::vector<double>& scale_factors,
+            const std::vector<double>& scale_centers = {})
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_scalings)(
+                knitro_context_,
+                variable_ids.size(),
+                variable_ids.data(),
+                scale_factors.data(),
+                (scale_centers.empty())? nullptr: scale_centers.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_var_scalings", knitro_return_code);
+    }
+
+    /** Set the scaling factors and centers of all variables. */
+    void set_var_scalings(
+            const std::vector<double>& scale_factors,
+            const std::vector<double>& scale_centers = {})
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_scalings_all)(
+                knitro_context_,
+                scale_factors.data(),
+                (scale_centers.empty())? nullptr: scale_centers.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_var_scalings_all", knitro_return_code);
+    }
+
+    /**
+     * Set the scaling factors of a subset of constraints, such that
+     * c_scaled = scale_factor * c.
+     */
+    void set_con_scalings(
+            const std::vector<ConstraintId>& constraint_ids,
+            const std::vector<double>& scale_factors)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_scalings)(
+                knitro_context_,
+                constraint_ids.size(),
+                constraint_ids.data(),
+                scale_factors.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_con_scalings", knitro_return_code);
+    }
+
+    /** Set the scaling factors of all constraints. */
+    void set_con_scalings(
+            const std::vector<double>& scale_factors)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_scalings_all)(
+                knitro_context_,
+                scale_factors.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_con_scalings_all", knitro_return_code);
+    }
+
+    /** Set the scaling factor of the objective, such that f_scaled = scale_factor * f. */
+    void set_obj_scaling(double scale_factor)
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_set_obj_scaling)(
+                knitro_context_,
+                scale_factor);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_obj_scaling", knitro_return_code);
+    }
+
+    /*
+     * Structure mirror
+     */
+
+    /**
+     * Keep a copy of the bounds, types, constants, linear and quadratic
+     * structure added to the context.
+     *
+     * The mirror is used by the tools working on the structure of the
+     * model, such as tighten_bounds. It must be enabled before adding
+     * variables and constraints.
+     */
+    void enable_structure_mirror()
+    {
+        if (get_number_vars() > 0 || get_number_cons() > 0) {
+            throw std::runtime_error(
+                    "KnitroCpp error: the structure mirror must be enabled "
+                    "before adding variables or constraints.");
+        }
+        structure_mirror_ = std::unique_ptr<Model>(new Model());
+    }
+
+    /** Return true iff the structure mirror is enabled. */
+    bool has_structure_mirror() const { return structure_mirror_ != nullptr; }
+
+    /** Get the structure mirror. */
+    const Model& structure_mirror() const
+    {
+        if (!structure_mirror_)
+            throw std::runtime_error("KnitroCpp error: the structure mirror is not enabled.");
+        return *structure_mirror_;
+    }
+
+    /**
+     * Return true iff a constraint has structure which is not in the
+     * mirror (evaluation callback or L2 norm).
+     */
+    bool is_con_mirror_nonlinear(ConstraintId constraint_id) const
+    {
+        return structure_mirror_ == nullptr
+            || structure_mirror_nonlinear_constraints_[constraint_id];
+    }
+
+    /**
+     * Return true iff a constraint of the mirror has an L2 norm term (see
+     * add_con_L2norm).
+     */
+    bool is_con_mirror_l2norm(ConstraintId constraint_id) const
+    {
+        return structure_mirror_ != nullptr
+            && (structure_mirror_nonlinear_constraints_[constraint_id] & 2);
+    }
+
+    /**
+     * Return true iff the objective has structure which is not in the
+     * mirror (evaluation callback or residuals).
+     */
+    bool is_obj_mirror_nonlinear() const
+    {
+        return structure_mirror_ == nullptr
+            || structure_mirror_nonlinear_objective_
+            || structure_mirror_least_squares_objective_;
+    }
+
+    /**
+     * Return true iff residuals have been added to the model of the mirror,
+     * the objective then being a least squares objective.
+     */
+    bool is_obj_mirror_least_squares() const
+    {
+        return structure_mirror_ != nullptr
+            && structure_mirror_least_squares_objective_;
+    }
+
     /*
      * Names
      */
@@ -1132,7 +2596,7 @@ public:
             VariableId variable_id,
             const std::string& name)
     {
-        int knitro_return_code = KN_set_var_name(
+        int knitro_return_code = KNITROCPP_KN(KN_set_var_name)(
                 knitro_context_,
                 variable_id,
                 name.c_str());
@@ -1144,7 +2608,7 @@ public:
     std::string get_var_name(VariableId variable_id) const
     {
         char buffer[4096];
-        int knitro_return_code = KN_get_var_name(
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_name)(
                 knitro_context_,
                 variable_id,
                 sizeof(buffer),
@@ -1159,7 +2623,7 @@ public:
             ConstraintId constraint_id,
             const std::string& name)
     {
-        int knitro_return_code = KN_set_con_name(
+        int knitro_return_code = KNITROCPP_KN(KN_set_con_name)(
                 knitro_context_,
                 constraint_id,
                 name.c_str());
@@ -1171,7 +2635,7 @@ public:
     std::string get_con_name(ConstraintId constraint_id) const
     {
         char buffer[4096];
-        int knitro_return_code = KN_get_con_name(
+        int knitro_return_code = KNITROCPP_KN(KN_get_con_name)(
                 knitro_context_,
                 constraint_id,
                 sizeof(buffer),
@@ -1184,7 +2648,7 @@ public:
     /** Set the name of the objective. */
     void set_obj_name(const std::string& name)
     {
-        int knitro_return_code = KN_set_obj_name(
+        int knitro_return_code = KNITROCPP_KN(KN_set_obj_name)(
                 knitro_context_,
                 name.c_str());
         if (knitro_return_code != 0)
@@ -1195,7 +2659,7 @@ public:
     std::string get_obj_name() const
     {
         char buffer[4096];
-        int knitro_return_code = KN_get_obj_name(
+        int knitro_return_code = KNITROCPP_KN(KN_get_obj_name)(
                 knitro_context_,
                 sizeof(buffer),
                 buffer);
@@ -1219,12 +2683,17 @@ public:
             const std::vector<ConstraintId>& constraint_ids,
             EvalCallback eval_callback_function)
     {
-        EvalCallbackStruct eval_callback_struct;
-        eval_callback_struct.eval_callback = eval_callback_function;
         eval_callbacks_.push_back(std::unique_ptr<EvalCallbackStruct>(
-                    new EvalCallbackStruct(eval_callback_struct)));
+                    new EvalCallbackStruct()));
+        EvalCallbackStruct& eval_callback_struct = *eval_callbacks_.back();
+        eval_callback_struct.eval_callback = eval_callback_function;
+        eval_callback_struct.evaluate_objective = evaluate_objective;
+        eval_callback_struct.constraint_ids = constraint_ids;
+        eval_callback_struct.timed = callback_timing_;
+        eval_callback_struct.index = number_of_eval_callbacks_++;
+        eval_callback_struct.trace_recorder = trace_recorder_.get();
         CB_context* callback_context;
-        int knitro_return_code = KN_add_eval_callback(
+        int knitro_return_code = KNITROCPP_KN(KN_add_eval_callback)(
                 knitro_context_,
                 evaluate_objective,
                 constraint_ids.size(),
@@ -1233,12 +2702,19 @@ public:
                 &callback_context);
         if (knitro_return_code != 0)
             throw KnitroException("KN_add_eval_callback", knitro_return_code);
-        knitro_return_code = KN_set_cb_user_params(
+        if (structure_mirror_) {
+            for (ConstraintId constraint_id: constraint_ids)
+                structure_mirror_nonlinear_constraints_[constraint_id] |= 1;
+            if (evaluate_objective)
+                structure_mirror_nonlinear_objective_ = true;
+        }
+        knitro_return_code = KNITROCPP_KN(KN_set_cb_user_params)(
                 knitro_context_,
                 callback_context,
                 eval_callbacks_.back().get());
         if (knitro_return_code != 0)
             throw KnitroException("KN_set_cb_user_params", knitro_return_code);
+        eval_callbacks_.back()->callback_context = callback_context;
         cb2eval_[callback_context] = eval_callbacks_.back().get();
         return callback_context;
     }
@@ -1248,8 +2724,10 @@ public:
             CB_context* callback_context,
             EvalCallback gradient_callback_function)
     {
-        cb2eval_.at(callback_context)->gradient = gradient_callback_function;
-        int knitro_return_code = KN_set_cb_grad(
+        EvalCallbackStruct* eval_callback_struct = cb2eval_.at(callback_context);
+        eval_callback_struct->gradient = gradient_callback_function;
+        eval_callback_struct->dense_gradient = true;
+        int knitro_return_code = KNITROCPP_KN(KN_set_cb_grad)(
                 knitro_context_,
                 callback_context,
                 KN_DENSE,
@@ -1259,65 +2737,573 @@ public:
                 nullptr,
                 gradient_callback);
         if (knitro_return_code != 0)
-            throw KnitroException("KN_set_cb_grad", knitro_return_code);
+            throw KnitroException("KN_set_cb_grad", knitro_return_code);
+    }
+
+    /** Set gradient callback (sparse). */
+    void set_cb_grad(
+            CB_context* callback_context,
+            const std::vector<VariableId>& objgrad_variable_ids,
+            const std::vector<ConstraintId>& jacobian_constraint_ids,
+            const std::vector<VariableId>& jacobian_variable_ids,
+            EvalCallback gradient_callback_function)
+    {
+        EvalCallbackStruct* eval_callback_struct = cb2eval_.at(callback_context);
+        eval_callback_struct->gradient = gradient_callback_function;
+        eval_callback_struct->dense_gradient = false;
+        eval_callback_struct->objgrad_variable_ids = objgrad_variable_ids;
+        eval_callback_struct->jacobian_constraint_ids = jacobian_constraint_ids;
+        eval_callback_struct->jacobian_variable_ids = jacobian_variable_ids;
+        int knitro_return_code = KNITROCPP_KN(KN_set_cb_grad)(
+                knitro_context_,
+                callback_context,
+                objgrad_variable_ids.size(),
+                objgrad_variable_ids.data(),
+                jacobian_constraint_ids.size(),
+                jacobian_constraint_ids.data(),
+                jacobian_variable_ids.data(),
+                gradient_callback);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_cb_grad", knitro_return_code);
+    }
+
+    /**
+     * Evaluate the evaluation callbacks at a point, outside of a solve.
+     *
+     * The objective value computed by the callbacks is added to objective
+     * and the constraint values are added to constraint_values, which must
+     * have one entry per constraint; the linear and quadratic structure is
+     * not included. Least squares callbacks are skipped. Return 0, or the
+     * first non-zero return code of a callback. It may be called
+     * concurrently if the callbacks are thread safe; each concurrent caller
+     * must then pass a distinct thread_id, which the callbacks receive as
+     * the threadID of the evaluation request.
+     */
+    int evaluate_callbacks(
+            const double* const x,
+            double& objective,
+            double* const constraint_values,
+            int thread_id = 0) const
+    {
+        static thread_local std::vector<double> values;
+        for (const auto& eval_callback_struct: eval_callbacks_) {
+            if (eval_callback_struct->least_squares)
+                continue;
+            const std::vector<ConstraintId>& constraint_ids = eval_callback_struct->constraint_ids;
+            values.assign(constraint_ids.size(), 0.0);
+            double callback_objective = 0.0;
+            KN_eval_request eval_request = {};
+            eval_request.type = KN_RC_EVALFC;
+            eval_request.threadID = thread_id;
+            eval_request.x = x;
+            KN_eval_result eval_result = {};
+            eval_result.obj = &callback_objective;
+            eval_result.c = values.data();
+            int callback_return_code = eval_callback_struct->eval_callback(
+                    *this,
+                    eval_callback_struct->callback_context,
+                    &eval_request,
+                    &eval_result);
+            if (callback_return_code != 0)
+                return callback_return_code;
+            if (eval_callback_struct->evaluate_objective)
+                objective += callback_objective;
+            for (std::size_t pos = 0; pos < constraint_ids.size(); ++pos)
+                constraint_values[constraint_ids[pos]] += values[pos];
+        }
+        return 0;
+    }
+
+    /**
+     * Evaluate the gradient callbacks at a point, outside of a solve.
+     *
+     * The objective gradient and the Jacobian of the parts of the model
+     * evaluated by callbacks are returned in coordinate format; the linear
+     * and quadratic structure is not included. Callbacks without gradient
+     * callback are skipped.
+     */
+    void evaluate_callback_gradients(
+            const std::vector<double>& x,
+            std::vector<VariableId>& objgrad_variable_ids,
+            std::vector<double>& objgrad_values,
+            std::vector<ConstraintId>& jacobian_constraint_ids,
+            std::vector<VariableId>& jacobian_variable_ids,
+            std::vector<double>& jacobian_values) const
+    {
+        objgrad_variable_ids.clear();
+        objgrad_values.clear();
+        jacobian_constraint_ids.clear();
+        jacobian_variable_ids.clear();
+        jacobian_values.clear();
+        VariableId number_of_variables = x.size();
+        for (const auto& eval_callback_struct: eval_callbacks_) {
+            if (eval_callback_struct->least_squares || !eval_callback_struct->gradient)
+                continue;
+
+            // Sparsity pattern of the callback.
+            std::size_t objgrad_start = objgrad_variable_ids.size();
+            std::size_t jacobian_start = jacobian_constraint_ids.size();
+            if (eval_callback_struct->dense_gradient) {
+                if (eval_callback_struct->evaluate_objective) {
+                    for (VariableId variable_id = 0;
+                            variable_id < number_of_variables;
+                            ++variable_id) {
+                        objgrad_variable_ids.push_back(variable_id);
+                    }
+                }
+                for (ConstraintId constraint_id: eval_callback_struct->constraint_ids) {
+                    for (VariableId variable_id = 0;
+                            variable_id < number_of_variables;
+                            ++variable_id) {
+                        jacobian_constraint_ids.push_back(constraint_id);
+                        jacobian_variable_ids.push_back(variable_id);
+                    }
+                }
+            } else {
+                objgrad_variable_ids.insert(
+                        objgrad_variable_ids.end(),
+                        eval_callback_struct->objgrad_variable_ids.begin(),
+                        eval_callback_struct->objgrad_variable_ids.end());
+                jacobian_constraint_ids.insert(
+                        jacobian_constraint_ids.end(),
+                        eval_callback_struct->jacobian_constraint_ids.begin(),
+                        eval_callback_struct->jacobian_constraint_ids.end());
+                jacobian_variable_ids.insert(
+                        jacobian_variable_ids.end(),
+                        eval_callback_struct->jacobian_variable_ids.begin(),
+                        eval_callback_struct->jacobian_variable_ids.end());
+            }
+            objgrad_values.resize(objgrad_variable_ids.size(), 0.0);
+            jacobian_values.resize(jacobian_constraint_ids.size(), 0.0);
+
+            KN_eval_request eval_request = {};
+            eval_request.type = KN_RC_EVALGA;
+            eval_request.x = x.data();
+            KN_eval_result eval_result = {};
+            eval_result.objGrad = objgrad_values.data() + objgrad_start;
+            eval_result.jac = jacobian_values.data() + jacobian_start;
+            int callback_return_code = eval_callback_struct->gradient(
+                    *this,
+                    eval_callback_struct->callback_context,
+                    &eval_request,
+                    &eval_result);
+            if (callback_return_code != 0) {
+                throw std::runtime_error(
+                        "KnitroCpp error: gradient callback returned "
+                        + std::to_string(callback_return_code) + ".");
+            }
+        }
+    }
+
+    /*
+     * Callback timing
+     */
+
+    /** Time the evaluations of the callbacks. */
+    void enable_callback_timing()
+    {
+        callback_timing_ = true;
+        for (const auto& eval_callback_struct: eval_callbacks_)
+            eval_callback_struct->timed = true;
+    }
+
+    /** Get the timings of the evaluation callbacks. */
+    CallbackTimings get_callback_timings() const
+    {
+        CallbackTimings timings;
+        CallbackTiming* timings_by_type[4] = {
+            &timings.function,
+            &timings.gradient,
+            &timings.hessian,
+            &timings.hessian_vector};
+        for (const auto& eval_callback_struct: eval_callbacks_) {
+            if (eval_callback_struct->least_squares)
+                continue;
+            for (int callback_type = 0; callback_type < 4; ++callback_type) {
+                timings_by_type[callback_type]->number_of_evaluations
+                    += eval_callback_struct->number_of_evaluations[callback_type].load();
+                timings_by_type[callback_type]->time
+                    += 1e-9 * eval_callback_struct->nanoseconds[callback_type].load();
+            }
+        }
+        return timings;
+    }
+
+    /** Reset the timings of the evaluation callbacks. */
+    void reset_callback_timings()
+    {
+        for (const auto& eval_callback_struct: eval_callbacks_) {
+            for (int callback_type = 0; callback_type < 4; ++callback_type) {
+                eval_callback_struct->number_of_evaluations[callback_type] = 0;
+                eval_callback_struct->nanoseconds[callback_type] = 0;
+            }
+        }
+    }
+
+    /**
+     * Choose the 'hessopt' parameter (and the L-BFGS memory) from the
+     * measured cost of the callbacks.
+     *
+     * Callback timing is enabled. The timings gathered so far are used,
+     * for example those of a previous solve of a similar model; if there
+     * are not enough of them, the callbacks are evaluated at x. The cost
+     * per iteration of each option is the time of the evaluations it
+     * requires plus the cost of its quasi-Newton update, multiplied by its
+     * relative number of iterations. The decision is stored in the report
+     * returned by hessian_strategy_report().
+     */
+    const HessianStrategyReport& choose_hessian_strategy(
+            const std::vector<double>& x,
+            const HessianStrategyParameters& parameters = HessianStrategyParameters())
+    {
+        enable_callback_timing();
+        HessianStrategyReport report;
+        bool has_callbacks = false;
+        bool exact_available = true;
+        bool product_available = true;
+        bool enough_samples = true;
+        for (const auto& eval_callback_struct: eval_callbacks_) {
+            if (eval_callback_struct->least_squares)
+                continue;
+            has_callbacks = true;
+            if (!eval_callback_struct->hessian)
+                exact_available = false;
+            if (!eval_callback_struct->hessian_vector)
+                product_available = false;
+            for (int callback_type = 0; callback_type < 4; ++callback_type) {
+                bool has_callback
+                    = (callback_type == Function)
+                    || (callback_type == Gradient && eval_callback_struct->gradient)
+                    || (callback_type == Hessian && eval_callback_struct->hessian)
+                    || (callback_type == HessianVector && eval_callback_struct->hessian_vector);
+                if (has_callback
+                        && eval_callback_struct->number_of_evaluations[callback_type]
+                        < parameters.number_of_samples) {
+                    enough_samples = false;
+                }
+            }
+        }
+        if (has_callbacks && !enough_samples) {
+            for (std::uint64_t sample = 0; sample < parameters.number_of_samples; ++sample)
+                probe_callbacks(x);
+            report.probed = true;
+        }
+
+        // Each callback is called once per iteration, so the average times
+        // of the callbacks are summed.
+        for (const auto& eval_callback_struct: eval_callbacks_) {
+            if (eval_callback_struct->least_squares)
+                continue;
+            double* times[4] = {
+                &report.function_time,
+                &report.gradient_time,
+                &report.hessian_time,
+                &report.hessian_vector_time};
+            for (int callback_type = 0; callback_type < 4; ++callback_type) {
+                std::uint64_t number_of_evaluations
+                    = eval_callback_struct->number_of_evaluations[callback_type];
+                if (number_of_evaluations > 0) {
+                    *times[callback_type] += 1e-9
+                        * eval_callback_struct->nanoseconds[callback_type] / number_of_evaluations;
+                }
+            }
+        }
+
+        double number_of_variables = x.size();
+        double evaluation_time = report.function_time + report.gradient_time;
+        double lmsize = std::floor(
+                parameters.lbfgs_overhead_ratio * evaluation_time
+                / (4 * number_of_variables * parameters.flop_time));
+        report.lmsize = (int)std::max(
+                (double)parameters.minimum_lmsize,
+                std::min((double)param::lmsize.maximum_value, lmsize));
+        if (exact_available)
+            report.exact_cost = evaluation_time + report.hessian_time;
+        if (has_callbacks && product_available) {
+            report.product_cost = evaluation_time
+                + parameters.number_of_hessian_vector_products * report.hessian_vector_time;
+        }
+        if (number_of_variables <= parameters.maximum_number_of_bfgs_variables) {
+            report.bfgs_cost = parameters.bfgs_relative_iterations * (evaluation_time
+                    + 2 * number_of_variables * number_of_variables * parameters.flop_time);
+        }
+        report.lbfgs_cost = parameters.lbfgs_relative_iterations * (evaluation_time
+                + 4 * report.lmsize * number_of_variables * parameters.flop_time);
+
+        std::pair<double, int> options[4] = {
+            {report.exact_cost, KN_HESSOPT_EXACT},
+            {report.product_cost, KN_HESSOPT_PRODUCT},
+            {report.bfgs_cost, KN_HESSOPT_BFGS},
+            {report.lbfgs_cost, KN_HESSOPT_LBFGS}};
+        report.hessopt = std::min_element(
+                options,
+                options + 4,
+                [](const std::pair<double, int>& option_1, const std::pair<double, int>& option_2)
+                {
+                    return option_1.first < option_2.first;
+                })->second;
+        set(param::hessopt, report.hessopt);
+        if (report.hessopt == KN_HESSOPT_LBFGS) {
+            set(param::lmsize, report.lmsize);
+        } else {
+            report.lmsize = 0;
+        }
+        hessian_strategy_report_ = report;
+        return hessian_strategy_report_;
+    }
+
+    /**
+     * Record the evaluations of the callbacks in a trace file.
+     *
+     * Each evaluation request (x, lambda, sigma, vec) and the values
+     * computed by the callback are written; the trace can be replayed
+     * without Knitro with TraceReplay (replay.hpp). Least squares
+     * callbacks are not recorded. It must be called once all variables and
+     * constraints have been added.
+     */
+    void start_trace(const std::string& filename)
+    {
+        trace_recorder_ = std::unique_ptr<TraceRecorder>(new TraceRecorder(
+                    filename,
+                    get_number_vars(),
+                    get_number_cons()));
+        for (const auto& eval_callback_struct: eval_callbacks_) {
+            if (!eval_callback_struct->least_squares)
+                eval_callback_struct->trace_recorder = trace_recorder_.get();
+        }
+    }
+
+    /** Stop recording and close the trace file; return the number of records. */
+    std::size_t stop_trace()
+    {
+        if (!trace_recorder_)
+            return 0;
+        for (const auto& eval_callback_struct: eval_callbacks_)
+            eval_callback_struct->trace_recorder = nullptr;
+        std::size_t number_of_records = trace_recorder_->number_of_records();
+        trace_recorder_.reset();
+        return number_of_records;
+    }
+
+    /** Get the report of the last call to choose_hessian_strategy. */
+    const HessianStrategyReport& hessian_strategy_report() const { return hessian_strategy_report_; }
+
+    /** Set Hessian callback (dense). */
+    void set_cb_hess(
+            CB_context* callback_context,
+            EvalCallback hessian_callback_function)
+    {
+        EvalCallbackStruct* eval_callback_struct = cb2eval_.at(callback_context);
+        eval_callback_struct->hessian = hessian_callback_function;
+        eval_callback_struct->dense_hessian = true;
+        int knitro_return_code = KNITROCPP_KN(KN_set_cb_hess)(
+                knitro_context_,
+                callback_context,
+                KN_DENSE_ROWMAJOR,
+                nullptr,
+                nullptr,
+                hessian_callback);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_cb_hess", knitro_return_code);
+    }
+
+    /** Set Hessian callback (sparse). */
+    void set_cb_hess(
+            CB_context* callback_context,
+            const std::vector<VariableId>& variable_ids_1,
+            const std::vector<VariableId>& variable_ids_2,
+            EvalCallback hessian_callback_function)
+    {
+        EvalCallbackStruct* eval_callback_struct = cb2eval_.at(callback_context);
+        eval_callback_struct->hessian = hessian_callback_function;
+        eval_callback_struct->dense_hessian = false;
+        eval_callback_struct->number_of_hessian_nonzeros = variable_ids_1.size();
+        int knitro_return_code = KNITROCPP_KN(KN_set_cb_hess)(
+                knitro_context_,
+                callback_context,
+                variable_ids_1.size(),
+                variable_ids_1.data(),
+                variable_ids_2.data(),
+                hessian_callback);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_cb_hess", knitro_return_code);
+    }
+
+    /** Set Hessian callback (sparse, from a Hessian pattern). */
+    void set_cb_hess(
+            CB_context* callback_context,
+            const HessianPattern& hessian_pattern,
+            EvalCallback hessian_callback_function)
+    {
+        set_cb_hess(
+                callback_context,
+                hessian_pattern.variable_ids_1(),
+                hessian_pattern.variable_ids_2(),
+                hessian_callback_function);
+    }
+
+    using HessianValuesCallback = std::function<int(
+            const Context&,
+            CB_context_ptr,
+            KN_eval_request_ptr const,
+            double* const)>;  // values
+
+    /**
+     * Set Hessian callback (sparse, from a Lagrangian Hessian map).
+     *
+     * The callback writes the unscaled values of the blocks of the map into
+     * the value buffer it receives; the weighting by sigma and lambda and
+     * the assembly of eval_result->hess are done by the wrapper.
+     */
+    void set_cb_hess(
+            CB_context* callback_context,
+            const LagrangianHessianMap& lagrangian_hessian_map,
+            HessianValuesCallback hessian_values_callback_function)
+    {
+        std::shared_ptr<const LagrangianHessianMap> map(
+                new LagrangianHessianMap(lagrangian_hessian_map));
+        set_cb_hess(
+                callback_context,
+                map->hessian_pattern(),
+                [map, hessian_values_callback_function](
+                    const Context& knitro_context,
+                    CB_context* callback_context,
+                    KN_eval_request_ptr const eval_request,
+                    KN_eval_result_ptr const eval_result)
+                {
+                    static thread_local std::vector<double> values;
+                    if ((KNLONG)values.size() < map->number_of_values())
+                        values.resize(map->number_of_values());
+                    std::fill(values.begin(), values.begin() + map->number_of_values(), 0.0);
+                    int status = hessian_values_callback_function(
+                            knitro_context,
+                            callback_context,
+                            eval_request,
+                            values.data());
+                    if (status != 0)
+                        return status;
+                    map->assemble(eval_request, values.data(), eval_result->hess);
+                    return 0;
+                });
+    }
+
+    using HessianVectorCallback = std::function<int(
+            const Context&,
+            CB_context_ptr,
+            const double* const,  // x
+            const double* const,  // lambda
+            double,  // sigma
+            const double* const,  // vec
+            double* const)>;  // hessVec
+
+    /**
+     * Set Hessian-vector product callback.
+     *
+     * The Hessian is never formed: the callback receives the current point,
+     * the multipliers, the objective scaling sigma (0 when Knitro requests
+     * the product without the objective part) and a vector vec, and must
+     * write the product of the Hessian of the Lagrangian with vec into
+     * hessVec. This also sets the 'hessopt' parameter to
+     * KN_HESSOPT_PRODUCT.
+     */
+    void set_cb_hessvec(
+            CB_context* callback_context,
+            HessianVectorCallback hessian_vector_callback_function)
+    {
+        cb2eval_.at(callback_context)->hessian_vector = hessian_vector_callback_function;
+        int knitro_return_code = KNITROCPP_KN(KN_set_cb_hess)(
+                knitro_context_,
+                callback_context,
+                0,
+                nullptr,
+                nullptr,
+                hessian_vector_callback);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_cb_hess", knitro_return_code);
+        set_int_param(KN_PARAM_HESSOPT, KN_HESSOPT_PRODUCT);
     }
 
-    /** Set gradient callback (sparse). */
-    void set_cb_grad(
-            CB_context* callback_context,
-            const std::vector<VariableId>& objgrad_variable_ids,
-            const std::vector<ConstraintId>& jacobian_constraint_ids,
-            const std::vector<VariableId>& jacobian_variable_ids,
-            EvalCallback gradient_callback_function)
+    /**
+     * Add a callback evaluating a subset of the residuals.
+     *
+     * The callback must write the residual values into eval_result->rsd.
+     */
+    CB_context* add_lsq_eval_callback(
+            const std::vector<ResidualId>& residual_ids,
+            EvalCallback residual_callback_function)
     {
-        cb2eval_.at(callback_context)->gradient = gradient_callback_function;
-        int knitro_return_code = KN_set_cb_grad(
+        eval_callbacks_.push_back(std::unique_ptr<EvalCallbackStruct>(
+                    new EvalCallbackStruct()));
+        EvalCallbackStruct& eval_callback_struct = *eval_callbacks_.back();
+        eval_callback_struct.eval_callback = residual_callback_function;
+        eval_callback_struct.least_squares = true;
+        eval_callback_struct.timed = callback_timing_;
+        CB_context* callback_context;
+        int knitro_return_code = KNITROCPP_KN(KN_add_lsq_eval_callback)(
+                knitro_context_,
+                residual_ids.size(),
+                residual_ids.data(),
+                eval_callback,
+                &callback_context);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_add_lsq_eval_callback", knitro_return_code);
+        knitro_return_code = KNITROCPP_KN(KN_set_cb_user_params)(
                 knitro_context_,
                 callback_context,
-                objgrad_variable_ids.size(),
-                objgrad_variable_ids.data(),
-                jacobian_constraint_ids.size(),
-                jacobian_constraint_ids.data(),
-                jacobian_variable_ids.data(),
-                gradient_callback);
+                eval_callbacks_.back().get());
         if (knitro_return_code != 0)
-            throw KnitroException("KN_set_cb_grad", knitro_return_code);
+            throw KnitroException("KN_set_cb_user_params", knitro_return_code);
+        eval_callbacks_.back()->callback_context = callback_context;
+        cb2eval_[callback_context] = eval_callbacks_.back().get();
+        return callback_context;
     }
 
-    /** Set Hessian callback (dense). */
-    void set_cb_hess(
+    /**
+     * Set residual Jacobian callback (dense).
+     *
+     * The callback must write the residual Jacobian into
+     * eval_result->rsdJac. This also sets the 'hessopt' parameter to
+     * KN_HESSOPT_GAUSS_NEWTON.
+     */
+    void set_cb_rsd_jac(
             CB_context* callback_context,
-            EvalCallback hessian_callback_function)
+            EvalCallback residual_jacobian_callback_function)
     {
-        cb2eval_.at(callback_context)->hessian = hessian_callback_function;
-        int knitro_return_code = KN_set_cb_hess(
+        cb2eval_.at(callback_context)->gradient = residual_jacobian_callback_function;
+        int knitro_return_code = KNITROCPP_KN(KN_set_cb_rsd_jac)(
                 knitro_context_,
                 callback_context,
                 KN_DENSE_ROWMAJOR,
                 nullptr,
                 nullptr,
-                hessian_callback);
+                gradient_callback);
         if (knitro_return_code != 0)
-            throw KnitroException("KN_set_cb_hess", knitro_return_code);
+            throw KnitroException("KN_set_cb_rsd_jac", knitro_return_code);
+        set_int_param(KN_PARAM_HESSOPT, KN_HESSOPT_GAUSS_NEWTON);
     }
 
-    /** Set Hessian callback (sparse). */
-    void set_cb_hess(
+    /**
+     * Set residual Jacobian callback (sparse).
+     *
+     * This also sets the 'hessopt' parameter to KN_HESSOPT_GAUSS_NEWTON.
+     */
+    void set_cb_rsd_jac(
             CB_context* callback_context,
-            const std::vector<VariableId>& variable_ids_1,
-            const std::vector<VariableId>& variable_ids_2,
-            EvalCallback hessian_callback_function)
+            const std::vector<ResidualId>& jacobian_residual_ids,
+            const std::vector<VariableId>& jacobian_variable_ids,
+            EvalCallback residual_jacobian_callback_function)
     {
-        cb2eval_.at(callback_context)->hessian = hessian_callback_function;
-        int knitro_return_code = KN_set_cb_hess(
+        cb2eval_.at(callback_context)->gradient = residual_jacobian_callback_function;
+        int knitro_return_code = KNITROCPP_KN(KN_set_cb_rsd_jac)(
                 knitro_context_,
                 callback_context,
-                variable_ids_1.size(),
-                variable_ids_1.data(),
-                variable_ids_2.data(),
-                hessian_callback);
+                jacobian_residual_ids.size(),
+                jacobian_residual_ids.data(),
+                jacobian_variable_ids.data(),
+                gradient_callback);
         if (knitro_return_code != 0)
-            throw KnitroException("KN_set_cb_hess", knitro_return_code);
+            throw KnitroException("KN_set_cb_rsd_jac", knitro_return_code);
+        set_int_param(KN_PARAM_HESSOPT, KN_HESSOPT_GAUSS_NEWTON);
     }
 
     /*
@@ -1326,12 +3312,25 @@ public:
 
     using UserCallback = std::function<int(const Context&, const double* const, const double* const)>;
 
+    /** Set the callback called at each new iterate. */
+    void set_newpt_callback(
+            UserCallback newpt_callback_function)
+    {
+        newpt_callback_ = newpt_callback_function;
+        int knitro_return_code = KNITROCPP_KN(KN_set_newpt_callback)(
+                knitro_context_,
+                newpt_callback,
+                (void*)this);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_newpt_callback", knitro_return_code);
+    }
+
     /** Set the MIP node callback. */
     void set_mip_node_callback(
             UserCallback mip_node_callback_function)
     {
         mip_node_callback_ = mip_node_callback_function;
-        int knitro_return_code = KN_set_mip_node_callback(
+        int knitro_return_code = KNITROCPP_KN(KN_set_mip_node_callback)(
                 knitro_context_,
                 mip_node_callback,
                 (void* const)this);
@@ -1339,6 +3338,60 @@ public:
             throw KnitroException("KN_set_mip_node_callback", knitro_return_code);
     }
 
+    using MultistartInitialPointCallback = std::function<int(
+            const Context&,
+            KNINT,  // solve number
+            const double* const,  // lower bounds
+            const double* const,  // upper bounds
+            double* const,  // x
+            double* const)>;  // lambda
+
+    /** Set the callback providing the initial point of each multistart solve. */
+    void set_ms_initpt_callback(
+            MultistartInitialPointCallback ms_initpt_callback_function)
+    {
+        ms_initpt_callback_ = ms_initpt_callback_function;
+        int knitro_return_code = KNITROCPP_KN(KN_set_ms_initpt_callback)(
+                knitro_context_,
+                ms_initpt_callback,
+                (void*)this);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_ms_initpt_callback", knitro_return_code);
+    }
+
+    /** Set the callback called after each multistart solve. */
+    void set_ms_process_callback(
+            UserCallback ms_process_callback_function)
+    {
+        ms_process_callback_ = ms_process_callback_function;
+        int knitro_return_code = KNITROCPP_KN(KN_set_ms_process_callback)(
+                knitro_context_,
+                ms_process_callback,
+                (void*)this);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_ms_process_callback", knitro_return_code);
+    }
+
+    using PutsCallback = std::function<int(const char* const)>;
+
+    /**
+     * Set the callback receiving the output of Knitro instead of it being
+     * printed to stdout.
+     *
+     * The callback must return the number of characters it processed.
+     */
+    void set_puts_callback(
+            PutsCallback puts_callback_function)
+    {
+        puts_callback_ = puts_callback_function;
+        int knitro_return_code = KNITROCPP_KN(KN_set_puts_callback)(
+                knitro_context_,
+                puts_callback,
+                this);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_set_puts_callback", knitro_return_code);
+    }
+
     /*
      * Other algorithmic/modeling features
      */
@@ -1348,7 +3401,7 @@ public:
             VariableId variable_id,
             double value)
     {
-        int knitro_return_code = KN_set_mip_var_primal_init_value(
+        int knitro_return_code = KNITROCPP_KN(KN_set_mip_var_primal_init_value)(
                 knitro_context_,
                 variable_id,
                 value);
@@ -1361,7 +3414,7 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<double>& values)
     {
-        int knitro_return_code = KN_set_mip_var_primal_init_values(
+        int knitro_return_code = KNITROCPP_KN(KN_set_mip_var_primal_init_values)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
@@ -1374,7 +3427,7 @@ public:
     void set_mip_var_primal_init_values(
             const std::vector<double>& values)
     {
-        int knitro_return_code = KN_set_mip_var_primal_init_values_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_mip_var_primal_init_values_all)(
                 knitro_context_,
                 values.data());
         if (knitro_return_code != 0)
@@ -1386,7 +3439,7 @@ public:
             VariableId variable_id,
             int priority)
     {
-        int knitro_return_code = KN_set_mip_branching_priority(
+        int knitro_return_code = KNITROCPP_KN(KN_set_mip_branching_priority)(
                 knitro_context_,
                 variable_id,
                 priority);
@@ -1399,7 +3452,7 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<int>& priorities)
     {
-        int knitro_return_code = KN_set_mip_branching_priorities(
+        int knitro_return_code = KNITROCPP_KN(KN_set_mip_branching_priorities)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
@@ -1412,7 +3465,7 @@ public:
     void set_mip_branching_priorities(
             const std::vector<int>& priorities)
     {
-        int knitro_return_code = KN_set_mip_branching_priorities_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_mip_branching_priorities_all)(
                 knitro_context_,
                 priorities.data());
         if (knitro_return_code != 0)
@@ -1424,7 +3477,7 @@ public:
             VariableId variable_id,
             int strategy)
     {
-        int knitro_return_code = KN_set_mip_intvar_strategy(
+        int knitro_return_code = KNITROCPP_KN(KN_set_mip_intvar_strategy)(
                 knitro_context_,
                 variable_id,
                 strategy);
@@ -1437,7 +3490,7 @@ public:
             const std::vector<VariableId>& variable_ids,
             const std::vector<int>& strategies)
     {
-        int knitro_return_code = KN_set_mip_intvar_strategies(
+        int knitro_return_code = KNITROCPP_KN(KN_set_mip_intvar_strategies)(
                 knitro_context_,
                 variable_ids.size(),
                 variable_ids.data(),
@@ -1450,7 +3503,7 @@ public:
     void set_mip_intvar_strategies(
             const std::vector<int>& strategies)
     {
-        int knitro_return_code = KN_set_mip_intvar_strategies_all(
+        int knitro_return_code = KNITROCPP_KN(KN_set_mip_intvar_strategies_all)(
                 knitro_context_,
                 strategies.data());
         if (knitro_return_code != 0)
@@ -1464,7 +3517,7 @@ public:
     /** Update the internal model without solving. */
     void update()
     {
-        int knitro_return_code = KN_update(knitro_context_);
+        int knitro_return_code = KNITROCPP_KN(KN_update)(knitro_context_);
         if (knitro_return_code != 0)
             throw KnitroException("KN_update", knitro_return_code);
     }
@@ -1472,7 +3525,7 @@ public:
     /* Call Knitro to solve the problem. */
     int solve()
     {
-        return KN_solve(knitro_context_);
+        return KNITROCPP_KN(KN_solve)(knitro_context_);
     }
 
     /*
@@ -1483,7 +3536,7 @@ public:
     VariableId get_number_vars() const
     {
         VariableId number_of_variables = -1;
-        int knitro_return_code = KN_get_number_vars(
+        int knitro_return_code = KNITROCPP_KN(KN_get_number_vars)(
                 knitro_context_,
                 &number_of_variables);
         if (knitro_return_code != 0)
@@ -1495,7 +3548,7 @@ public:
     ConstraintId get_number_cons() const
     {
         ConstraintId number_of_constraints = -1;
-        int knitro_return_code = KN_get_number_cons(
+        int knitro_return_code = KNITROCPP_KN(KN_get_number_cons)(
                 knitro_context_,
                 &number_of_constraints);
         if (knitro_return_code != 0)
@@ -1503,11 +3556,23 @@ public:
         return number_of_constraints;
     }
 
+    /** Get the number of residuals in the model. */
+    ResidualId get_number_rsds() const
+    {
+        ResidualId number_of_residuals = -1;
+        int knitro_return_code = KNITROCPP_KN(KN_get_number_rsds)(
+                knitro_context_,
+                &number_of_residuals);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_get_number_rsds", knitro_return_code);
+        return number_of_residuals;
+    }
+
     /** Get the value of the objective. */
     double get_obj_value() const
     {
         double objective = 0.0;
-        int knitro_return_code = KN_get_obj_value(
+        int knitro_return_code = KNITROCPP_KN(KN_get_obj_value)(
                 knitro_context_,
                 &objective);
         if (knitro_return_code != 0)
@@ -1520,7 +3585,7 @@ public:
             VariableId variable_id) const
     {
         double value = 0.0;
-        int knitro_return_code = KN_get_var_primal_value (
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_primal_value)(
                 knitro_context_,
                 variable_id,
                 &value);
@@ -1533,7 +3598,7 @@ public:
     std::vector<double> get_var_primal_values() const
     {
         std::vector<double> values(this->get_number_vars(), 0.0);
-        int knitro_return_code = KN_get_var_primal_values_all(
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_primal_values_all)(
                 knitro_context_,
                 values.data());
         if (knitro_return_code != 0)
@@ -1546,7 +3611,7 @@ public:
             VariableId variable_id) const
     {
         double value = 0.0;
-        int knitro_return_code = KN_get_var_dual_value (
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_dual_value)(
                 knitro_context_,
                 variable_id,
                 &value);
@@ -1559,7 +3624,7 @@ public:
     std::vector<double> get_var_dual_values() const
     {
         std::vector<double> values(this->get_number_vars(), 0.0);
-        int knitro_return_code = KN_get_var_dual_values_all(
+        int knitro_return_code = KNITROCPP_KN(KN_get_var_dual_values_all)(
                 knitro_context_,
                 values.data());
         if (knitro_return_code != 0)
@@ -1572,7 +3637,7 @@ public:
             ConstraintId constraint_id) const
     {
         double value = 0.0;
-        int knitro_return_code = KN_get_con_dual_value (
+        int knitro_return_code = KNITROCPP_KN(KN_get_con_dual_value)(
                 knitro_context_,
                 constraint_id,
                 &value);
@@ -1585,7 +3650,7 @@ public:
     std::vector<double> get_con_dual_values() const
     {
         std::vector<double> values(this->get_number_cons(), 0.0);
-        int knitro_return_code = KN_get_con_dual_values_all(
+        int knitro_return_code = KNITROCPP_KN(KN_get_con_dual_values_all)(
                 knitro_context_,
                 values.data());
         if (knitro_return_code != 0)
@@ -1598,7 +3663,7 @@ public:
             ConstraintId constraint_id) const
     {
         double value = 0.0;
-        int knitro_return_code = KN_get_con_value (
+        int knitro_return_code = KNITROCPP_KN(KN_get_con_value)(
                 knitro_context_,
                 constraint_id,
                 &value);
@@ -1611,7 +3676,7 @@ public:
     std::vector<double> get_con_values() const
     {
         std::vector<double> values(this->get_number_cons(), 0.0);
-        int knitro_return_code = KN_get_con_values_all(
+        int knitro_return_code = KNITROCPP_KN(KN_get_con_values_all)(
                 knitro_context_,
                 values.data());
         if (knitro_return_code != 0)
@@ -1619,11 +3684,170 @@ public:
         return values;
     }
 
+    /** Get the values of all residuals. */
+    std::vector<double> get_rsd_values() const
+    {
+        std::vector<double> values(this->get_number_rsds(), 0.0);
+        int knitro_return_code = KNITROCPP_KN(KN_get_rsd_values_all)(
+                knitro_context_,
+                values.data());
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_get_rsd_values_all", knitro_return_code);
+        return values;
+    }
+
+    /** Get the number of nonzeros of the Jacobian of the constraints. */
+    KNLONG get_jacobian_nnz() const
+    {
+        KNLONG number_of_nonzeros = 0;
+        int knitro_return_code = KNITROCPP_KN(KN_get_jacobian_nnz)(
+                knitro_context_,
+                &number_of_nonzeros);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_get_jacobian_nnz", knitro_return_code);
+        return number_of_nonzeros;
+    }
+
+    /**
+     * Get the values of the Jacobian of the constraints at the solution.
+     *
+     * The buffers must have get_jacobian_nnz() elements.
+     */
+    void get_jacobian_values(
+            ConstraintId* const constraint_ids,
+            VariableId* const variable_ids,
+            double* const values) const
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_get_jacobian_values)(
+                knitro_context_,
+                constraint_ids,
+                variable_ids,
+                values);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_get_jacobian_values", knitro_return_code);
+    }
+
+    /** Get the Jacobian of the constraints at the solution. */
+    void get_jacobian(SparseMatrix& jacobian) const
+    {
+        KNLONG number_of_nonzeros = get_jacobian_nnz();
+        jacobian.number_of_rows = get_number_cons();
+        jacobian.number_of_columns = get_number_vars();
+        jacobian.row_ids.resize(number_of_nonzeros);
+        jacobian.column_ids.resize(number_of_nonzeros);
+        jacobian.values.resize(number_of_nonzeros);
+        get_jacobian_values(
+                jacobian.row_ids.data(),
+                jacobian.column_ids.data(),
+                jacobian.values.data());
+        jacobian.update_csr();
+    }
+
+    /** Get the number of nonzeros of the Jacobian of the residuals. */
+    KNLONG get_rsd_jacobian_nnz() const
+    {
+        KNLONG number_of_nonzeros = 0;
+        int knitro_return_code = KNITROCPP_KN(KN_get_rsd_jacobian_nnz)(
+                knitro_context_,
+                &number_of_nonzeros);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_get_rsd_jacobian_nnz", knitro_return_code);
+        return number_of_nonzeros;
+    }
+
+    /**
+     * Get the values of the Jacobian of the residuals at the solution.
+     *
+     * The buffers must have get_rsd_jacobian_nnz() elements.
+     */
+    void get_rsd_jacobian_values(
+            ResidualId* const residual_ids,
+            VariableId* const variable_ids,
+            double* const values) const
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_get_rsd_jacobian_values)(
+                knitro_context_,
+                residual_ids,
+                variable_ids,
+                values);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_get_rsd_jacobian_values", knitro_return_code);
+    }
+
+    /** Get the Jacobian of the residuals at the solution. */
+    void get_rsd_jacobian(SparseMatrix& jacobian) const
+    {
+        KNLONG number_of_nonzeros = get_rsd_jacobian_nnz();
+        jacobian.number_of_rows = get_number_rsds();
+        jacobian.number_of_columns = get_number_vars();
+        jacobian.row_ids.resize(number_of_nonzeros);
+        jacobian.column_ids.resize(number_of_nonzeros);
+        jacobian.values.resize(number_of_nonzeros);
+        get_rsd_jacobian_values(
+                jacobian.row_ids.data(),
+                jacobian.column_ids.data(),
+                jacobian.values.data());
+        jacobian.update_csr();
+    }
+
+    /** Get the number of nonzeros of the Hessian of the Lagrangian. */
+    KNLONG get_hessian_nnz() const
+    {
+        KNLONG number_of_nonzeros = 0;
+        int knitro_return_code = KNITROCPP_KN(KN_get_hessian_nnz)(
+                knitro_context_,
+                &number_of_nonzeros);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_get_hessian_nnz", knitro_return_code);
+        return number_of_nonzeros;
+    }
+
+    /**
+     * Get the values of the Hessian of the Lagrangian at the solution.
+     *
+     * Only the upper triangle is returned. The buffers must have
+     * get_hessian_nnz() elements.
+     */
+    void get_hessian_values(
+            VariableId* const variable_ids_1,
+            VariableId* const variable_ids_2,
+            double* const values) const
+    {
+        int knitro_return_code = KNITROCPP_KN(KN_get_hessian_values)(
+                knitro_context_,
+                variable_ids_1,
+                variable_ids_2,
+                values);
+        if (knitro_return_code != 0)
+            throw KnitroException("KN_get_hessian_values", knitro_return_code);
+    }
+
+    /**
+     * Get the Hessian of the Lagrangian at the solution (upper triangle).
+     *
+     * It is only available if the Hessian is computed exactly (hessopt
+     * KN_HESSOPT_EXACT).
+     */
+    void get_hessian(SparseMatrix& hessian) const
+    {
+        KNLONG number_of_nonzeros = get_hessian_nnz();
+        hessian.number_of_rows = get_number_vars();
+        hessian.number_of_columns = hessian.number_of_rows;
+        hessian.row_ids.resize(number_of_nonzeros);
+        hessian.column_ids.resize(number_of_nonzeros);
+        hessian.values.resize(number_of_nonzeros);
+        get_hessian_values(
+                hessian.row_ids.data(),
+                hessian.column_ids.data(),
+                hessian.values.data());
+        hessian.update_csr();
+    }
+
     /** Get the absolute feasibility error at the solution. */
     double get_abs_feas_error() const
     {
         double abs_feas_error = -1;
-        int knitro_return_code = KN_get_abs_feas_error(
+        int knitro_return_code = KNITROCPP_KN(KN_get_abs_feas_error)(
                 knitro_context_,
                 &abs_feas_error);
         if (knitro_return_code != 0)
@@ -1635,7 +3859,7 @@ public:
     double get_rel_feas_error() const
     {
         double rel_feas_error = -1;
-        int knitro_return_code = KN_get_rel_feas_error(
+        int knitro_return_code = KNITROCPP_KN(KN_get_rel_feas_error)(
                 knitro_context_,
                 &rel_feas_error);
         if (knitro_return_code != 0)
@@ -1647,7 +3871,7 @@ public:
     double get_abs_opt_error() const
     {
         double abs_opt_error = -1;
-        int knitro_return_code = KN_get_abs_opt_error(
+        int knitro_return_code = KNITROCPP_KN(KN_get_abs_opt_error)(
                 knitro_context_,
                 &abs_opt_error);
         if (knitro_return_code != 0)
@@ -1659,7 +3883,7 @@ public:
     double get_rel_opt_error() const
     {
         double rel_opt_error = -1;
-        int knitro_return_code = KN_get_rel_opt_error(
+        int knitro_return_code = KNITROCPP_KN(KN_get_rel_opt_error)(
                 knitro_context_,
                 &rel_opt_error);
         if (knitro_return_code != 0)
@@ -1671,7 +3895,7 @@ public:
     int get_number_iters() const
     {
         int num_iters = 0;
-        int knitro_return_code = KN_get_number_iters(
+        int knitro_return_code = KNITROCPP_KN(KN_get_number_iters)(
                 knitro_context_,
                 &num_iters);
         if (knitro_return_code != 0)
@@ -1683,7 +3907,7 @@ public:
     double get_solve_time_cpu() const
     {
         double time = 0.0;
-        int knitro_return_code = KN_get_solve_time_cpu(
+        int knitro_return_code = KNITROCPP_KN(KN_get_solve_time_cpu)(
                 knitro_context_,
                 &time);
         if (knitro_return_code != 0)
@@ -1695,7 +3919,7 @@ public:
     double get_solve_time_real() const
     {
         double time = 0.0;
-        int knitro_return_code = KN_get_solve_time_real(
+        int knitro_return_code = KNITROCPP_KN(KN_get_solve_time_real)(
                 knitro_context_,
                 &time);
         if (knitro_return_code != 0)
@@ -1707,7 +3931,7 @@ public:
     bool has_mip_incumbent() const
     {
         double incumbent_objective;
-        int knitro_return_code = KN_get_mip_incumbent_obj(
+        int knitro_return_code = KNITROCPP_KN(KN_get_mip_incumbent_obj)(
                 knitro_context_,
                 &incumbent_objective);
         if (knitro_return_code < 0)
@@ -1719,7 +3943,7 @@ public:
     double get_mip_incumbent_obj() const
     {
         double incumbent_objective;
-        int knitro_return_code = KN_get_mip_incumbent_obj(
+        int knitro_return_code = KNITROCPP_KN(KN_get_mip_incumbent_obj)(
                 knitro_context_,
                 &incumbent_objective);
         if (knitro_return_code < 0)
@@ -1731,7 +3955,7 @@ public:
     double get_mip_relaxation_bnd() const
     {
         double relaxation_bound = 0.0;
-        int knitro_return_code = KN_get_mip_relaxation_bnd(
+        int knitro_return_code = KNITROCPP_KN(KN_get_mip_relaxation_bnd)(
                 knitro_context_,
                 &relaxation_bound);
         if (knitro_return_code != 0)
@@ -1743,7 +3967,7 @@ public:
     double get_mip_lastnode_obj() const
     {
         double last_node_obj = 0.0;
-        int knitro_return_code = KN_get_mip_lastnode_obj(
+        int knitro_return_code = KNITROCPP_KN(KN_get_mip_lastnode_obj)(
                 knitro_context_,
                 &last_node_obj);
         if (knitro_return_code != 0)
@@ -1755,7 +3979,7 @@ public:
     int get_mip_number_nodes() const
     {
         int num_nodes = 0;
-        int knitro_return_code = KN_get_mip_number_nodes(
+        int knitro_return_code = KNITROCPP_KN(KN_get_mip_number_nodes)(
                 knitro_context_,
                 &num_nodes);
         if (knitro_return_code != 0)
@@ -1767,7 +3991,7 @@ public:
     double get_mip_abs_gap() const
     {
         double abs_gap = 0.0;
-        int knitro_return_code = KN_get_mip_abs_gap(
+        int knitro_return_code = KNITROCPP_KN(KN_get_mip_abs_gap)(
                 knitro_context_,
                 &abs_gap);
         if (knitro_return_code != 0)
@@ -1779,7 +4003,7 @@ public:
     double get_mip_rel_gap() const
     {
         double rel_gap = 0.0;
-        int knitro_return_code = KN_get_mip_rel_gap(
+        int knitro_return_code = KNITROCPP_KN(KN_get_mip_rel_gap)(
                 knitro_context_,
                 &rel_gap);
         if (knitro_return_code != 0)
@@ -1787,15 +4011,25 @@ public:
         return rel_gap;
     }
 
-    /** Get the MIP incumbent solution. */
-    std::vector<double> get_mip_incumbent_x() const
+    /**
+     * Get the MIP incumbent solution.
+     *
+     * The buffer must have get_number_vars() elements.
+     */
+    void get_mip_incumbent_x(double* const mip_incumbent_x) const
     {
-        std::vector<double> mip_incumbent_x(get_number_vars(), 0.0);
-        int knitro_return_code = KN_get_mip_incumbent_x(
+        int knitro_return_code = KNITROCPP_KN(KN_get_mip_incumbent_x)(
                 knitro_context_,
-                mip_incumbent_x.data());
+                mip_incumbent_x);
         if (knitro_return_code != 0)
             throw KnitroException("KN_get_mip_incumbent_x", knitro_return_code);
+    }
+
+    /** Get the MIP incumbent solution. */
+    std::vector<double> get_mip_incumbent_x() const
+    {
+        std::vector<double> mip_incumbent_x(get_number_vars(), 0.0);
+        get_mip_incumbent_x(mip_incumbent_x.data());
         return mip_incumbent_x;
     }
 
@@ -1806,6 +4040,57 @@ private:
         EvalCallback eval_callback;
         EvalCallback gradient;
         EvalCallback hessian;
+        HessianVectorCallback hessian_vector;
+
+        /** Callback context. */
+        CB_context* callback_context = nullptr;
+
+        /** Boolean indicating if the callback evaluates residuals. */
+        bool least_squares = false;
+
+        /** Boolean indicating if the callback evaluates the objective. */
+        bool evaluate_objective = false;
+
+        /** Constraints evaluated by the callback. */
+        std::vector<ConstraintId> constraint_ids;
+
+        /** Boolean indicating if the gradient callback is dense. */
+        bool dense_gradient = false;
+
+        /** Sparsity pattern of a sparse gradient callback. */
+        std::vector<VariableId> objgrad_variable_ids;
+        std::vector<ConstraintId> jacobian_constraint_ids;
+        std::vector<VariableId> jacobian_variable_ids;
+
+        /** Boolean indicating if the Hessian callback is dense. */
+        bool dense_hessian = false;
+
+        /** Number of nonzeros of a sparse Hessian callback. */
+        std::size_t number_of_hessian_nonzeros = 0;
+
+        /** Boolean indicating if the evaluations are timed. */
+        bool timed = false;
+
+        /** Index among the evaluation callbacks, excluding least squares ones. */
+        std::uint32_t index = 0;
+
+        /** Trace recorder, if the evaluations are recorded. */
+        TraceRecorder* trace_recorder = nullptr;
+
+        /**
+         * Number of evaluations and time spent in nanoseconds, for each
+         * CallbackType.
+         */
+        std::atomic<std::uint64_t> number_of_evaluations[4] = {};
+        std::atomic<std::uint64_t> nanoseconds[4] = {};
+    };
+
+    enum CallbackType
+    {
+        Function = 0,
+        Gradient = 1,
+        Hessian = 2,
+        HessianVector = 3,
     };
 
     /*
@@ -1823,9 +4108,48 @@ private:
 
     std::unordered_map<CB_context*, EvalCallbackStruct*> cb2eval_;
 
+    /** Boolean indicating if the evaluations of the callbacks are timed. */
+    bool callback_timing_ = false;
+
+    /** Number of evaluation callbacks, excluding least squares ones. */
+    std::uint32_t number_of_eval_callbacks_ = 0;
+
+    /** Trace recorder. */
+    std::unique_ptr<TraceRecorder> trace_recorder_;
+
+    /** Report of the last Hessian strategy selection. */
+    HessianStrategyReport hessian_strategy_report_;
+
+    /** Structure mirror. */
+    std::unique_ptr<Model> structure_mirror_;
+
+    /**
+     * Constraints of the mirror with structure not in the mirror (bit 1:
+     * evaluation callback, bit 2: L2 norm).
+     */
+    std::vector<char> structure_mirror_nonlinear_constraints_;
+
+    /** Boolean indicating if the objective has an evaluation callback. */
+    bool structure_mirror_nonlinear_objective_ = false;
+
+    /** Boolean indicating if residuals have been added to the mirrored model. */
+    bool structure_mirror_least_squares_objective_ = false;
+
+    /** New point callback. */
+    UserCallback newpt_callback_;
+
     /** MIP node callback. */
     UserCallback mip_node_callback_;
 
+    /** Multistart initial point callback. */
+    MultistartInitialPointCallback ms_initpt_callback_;
+
+    /** Multistart process callback. */
+    UserCallback ms_process_callback_;
+
+    /** Puts callback. */
+    PutsCallback puts_callback_;
+
     /*
      * Private methods
      */
@@ -1839,11 +4163,23 @@ private:
     {
         EvalCallbackStruct* eval_callback_struct = (EvalCallbackStruct*)user_params;
         Context knitro_context(kc);
-        return eval_callback_struct->eval_callback(
-                knitro_context,
-                callback_context,
-                eval_request,
-                eval_result);
+        int callback_return_code = timed_call(*eval_callback_struct, Function, [&]()
+                {
+                    return eval_callback_struct->eval_callback(
+                            knitro_context,
+                            callback_context,
+                            eval_request,
+                            eval_result);
+                });
+        if (eval_callback_struct->trace_recorder != nullptr) {
+            record_evaluation(
+                    *eval_callback_struct,
+                    Function,
+                    eval_request,
+                    eval_result,
+                    callback_return_code);
+        }
+        return callback_return_code;
     }
 
     static int gradient_callback(
@@ -1855,11 +4191,23 @@ private:
     {
         EvalCallbackStruct* eval_callback_struct = (EvalCallbackStruct*)user_params;
         Context knitro_context(kc);
-        return eval_callback_struct->gradient(
-                knitro_context,
-                callback_context,
-                eval_request,
-                eval_result);
+        int callback_return_code = timed_call(*eval_callback_struct, Gradient, [&]()
+                {
+                    return eval_callback_struct->gradient(
+                            knitro_context,
+                            callback_context,
+                            eval_request,
+                            eval_result);
+                });
+        if (eval_callback_struct->trace_recorder != nullptr) {
+            record_evaluation(
+                    *eval_callback_struct,
+                    Gradient,
+                    eval_request,
+                    eval_result,
+                    callback_return_code);
+        }
+        return callback_return_code;
     }
 
     static int hessian_callback(
@@ -1871,11 +4219,252 @@ private:
     {
         EvalCallbackStruct* eval_callback_struct = (EvalCallbackStruct*)user_params;
         Context knitro_context(kc);
-        return eval_callback_struct->hessian(
-                knitro_context,
-                callback_context,
-                eval_request,
-                eval_result);
+        int callback_return_code = timed_call(*eval_callback_struct, Hessian, [&]()
+                {
+                    return eval_callback_struct->hessian(
+                            knitro_context,
+                            callback_context,
+                            eval_request,
+                            eval_result);
+                });
+        if (eval_callback_struct->trace_recorder != nullptr) {
+            record_evaluation(
+                    *eval_callback_struct,
+                    Hessian,
+                    eval_request,
+                    eval_result,
+                    callback_return_code);
+        }
+        return callback_return_code;
+    }
+
+    static int hessian_vector_callback(
+            KN_context* kc,
+            CB_context* callback_context,
+            KN_eval_request_ptr const eval_request,
+            KN_eval_result_ptr const eval_result,
+            void* const user_params)
+    {
+        EvalCallbackStruct* eval_callback_struct = (EvalCallbackStruct*)user_params;
+        Context knitro_context(kc);
+        double sigma = (eval_request->type == KN_RC_EVALHV_NO_F)?
+            0.0: *(eval_request->sigma);
+        int callback_return_code = timed_call(*eval_callback_struct, HessianVector, [&]()
+                {
+                    return eval_callback_struct->hessian_vector(
+                            knitro_context,
+                            callback_context,
+                            eval_request->x,
+                            eval_request->lambda,
+                            sigma,
+                            eval_request->vec,
+                            eval_result->hessVec);
+                });
+        if (eval_callback_struct->trace_recorder != nullptr) {
+            record_evaluation(
+                    *eval_callback_struct,
+                    HessianVector,
+                    eval_request,
+                    eval_result,
+                    callback_return_code);
+        }
+        return callback_return_code;
+    }
+
+    /** Write an evaluation to the trace recorder of a callback. */
+    static void record_evaluation(
+            const EvalCallbackStruct& eval_callback_struct,
+            CallbackType callback_type,
+            KN_eval_request_ptr const eval_request,
+            KN_eval_result_ptr const eval_result,
+            int callback_return_code)
+    {
+        TraceRecorder& trace_recorder = *eval_callback_struct.trace_recorder;
+        std::size_t number_of_variables = trace_recorder.number_of_variables();
+        std::size_t number_of_duals = trace_recorder.number_of_constraints() + number_of_variables;
+        std::size_t number_of_constraints = eval_callback_struct.constraint_ids.size();
+        TraceRecorder::Array arrays[5] = {
+            {eval_request->x, number_of_variables},
+            {nullptr, 0},
+            {nullptr, 0},
+            {nullptr, 0},
+            {nullptr, 0}};
+        double sigma = 0.0;
+        switch (callback_type) {
+        case Function: {
+            arrays[3] = {eval_result->obj, (std::size_t)eval_callback_struct.evaluate_objective};
+            arrays[4] = {eval_result->c, number_of_constraints};
+            break;
+        } case Gradient: {
+            if (eval_callback_struct.dense_gradient) {
+                arrays[3] = {eval_result->objGrad, (eval_callback_struct.evaluate_objective)? number_of_variables: 0};
+                arrays[4] = {eval_result->jac, number_of_constraints * number_of_variables};
+            } else {
+                arrays[3] = {eval_result->objGrad, eval_callback_struct.objgrad_variable_ids.size()};
+                arrays[4] = {eval_result->jac, eval_callback_struct.jacobian_constraint_ids.size()};
+            }
+            break;
+        } case Hessian: case HessianVector: {
+            arrays[1] = {eval_request->lambda, number_of_duals};
+            if (eval_request->type != KN_RC_EVALH_NO_F
+                    && eval_request->type != KN_RC_EVALHV_NO_F)
+                sigma = *(eval_request->sigma);
+            if (callback_type == HessianVector) {
+                arrays[2] = {eval_request->vec, number_of_variables};
+                arrays[3] = {eval_result->hessVec, number_of_variables};
+            } else {
+                arrays[3] = {eval_result->hess, (eval_callback_struct.dense_hessian)?
+                    number_of_variables * (number_of_variables + 1) / 2:
+                    eval_callback_struct.number_of_hessian_nonzeros};
+            }
+            break;
+        }
+        }
+        trace_recorder.record(
+                (std::uint8_t)callback_type,
+                eval_callback_struct.index,
+                eval_request->type,
+                callback_return_code,
+                sigma,
+                arrays);
+    }
+
+    /** Call a callback, timing it if timing is enabled. */
+    template <typename Function>
+    static int timed_call(
+            EvalCallbackStruct& eval_callback_struct,
+            CallbackType callback_type,
+            const Function& function)
+    {
+        if (!eval_callback_struct.timed)
+            return function();
+        auto start = std::chrono::steady_clock::now();
+        int callback_return_code = function();
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        eval_callback_struct.number_of_evaluations[callback_type].fetch_add(1, std::memory_order_relaxed);
+        eval_callback_struct.nanoseconds[callback_type].fetch_add(nanoseconds, std::memory_order_relaxed);
+        return callback_return_code;
+    }
+
+    /**
+     * Call each evaluation, gradient, Hessian and Hessian-vector callback
+     * once at x.
+     */
+    void probe_callbacks(const std::vector<double>& x)
+    {
+        VariableId number_of_variables = x.size();
+        std::vector<double> lambda(get_number_cons() + number_of_variables, 1.0);
+        std::vector<double> vec(number_of_variables, 1.0);
+        double sigma = 1.0;
+        double objective = 0.0;
+        std::vector<double> buffer_1;
+        std::vector<double> buffer_2;
+        for (const auto& eval_callback_struct_ptr: eval_callbacks_) {
+            EvalCallbackStruct& eval_callback_struct = *eval_callback_struct_ptr;
+            if (eval_callback_struct.least_squares)
+                continue;
+            CB_context* callback_context = eval_callback_struct.callback_context;
+            std::size_t number_of_constraints = eval_callback_struct.constraint_ids.size();
+            KN_eval_request eval_request = {};
+            eval_request.x = x.data();
+            eval_request.lambda = lambda.data();
+            eval_request.sigma = &sigma;
+            eval_request.vec = vec.data();
+            KN_eval_result eval_result = {};
+            auto check = [](int callback_return_code)
+            {
+                if (callback_return_code != 0) {
+                    throw std::runtime_error(
+                            "KnitroCpp error: callback returned "
+                            + std::to_string(callback_return_code) + ".");
+                }
+            };
+
+            eval_request.type = KN_RC_EVALFC;
+            buffer_1.assign(number_of_constraints, 0.0);
+            eval_result.obj = &objective;
+            eval_result.c = buffer_1.data();
+            check(timed_call(eval_callback_struct, Function, [&]()
+                        {
+                            return eval_callback_struct.eval_callback(
+                                    *this, callback_context, &eval_request, &eval_result);
+                        }));
+
+            if (eval_callback_struct.gradient) {
+                eval_request.type = KN_RC_EVALGA;
+                if (eval_callback_struct.dense_gradient) {
+                    buffer_1.assign(number_of_variables, 0.0);
+                    buffer_2.assign(number_of_constraints * number_of_variables, 0.0);
+                } else {
+                    buffer_1.assign(eval_callback_struct.objgrad_variable_ids.size(), 0.0);
+                    buffer_2.assign(eval_callback_struct.jacobian_constraint_ids.size(), 0.0);
+                }
+                eval_result.objGrad = buffer_1.data();
+                eval_result.jac = buffer_2.data();
+                check(timed_call(eval_callback_struct, Gradient, [&]()
+                            {
+                                return eval_callback_struct.gradient(
+                                        *this, callback_context, &eval_request, &eval_result);
+                            }));
+            }
+
+            if (eval_callback_struct.hessian) {
+                eval_request.type = KN_RC_EVALH;
+                buffer_1.assign((eval_callback_struct.dense_hessian)?
+                        number_of_variables * (number_of_variables + 1) / 2:
+                        eval_callback_struct.number_of_hessian_nonzeros, 0.0);
+                eval_result.hess = buffer_1.data();
+                check(timed_call(eval_callback_struct, Hessian, [&]()
+                            {
+                                return eval_callback_struct.hessian(
+                                        *this, callback_context, &eval_request, &eval_result);
+                            }));
+            }
+
+            if (eval_callback_struct.hessian_vector) {
+                buffer_1.assign(number_of_variables, 0.0);
+                check(timed_call(eval_callback_struct, HessianVector, [&]()
+                            {
+                                return eval_callback_struct.hessian_vector(
+                                        *this, callback_context,
+                                        x.data(), lambda.data(), sigma, vec.data(),
+                                        buffer_1.data());
+                            }));
+            }
+        }
+    }
+
+    void mirror_add_cons(ConstraintId number_of_constraints)
+    {
+        for (ConstraintId pos = 0; pos < number_of_constraints; ++pos)
+            structure_mirror_->add_con();
+        structure_mirror_nonlinear_constraints_.resize(
+                structure_mirror_nonlinear_constraints_.size() + number_of_constraints, 0);
+    }
+
+    /** Copy values into some entries of a vector of the structure mirror. */
+    template <typename Id, typename T>
+    static void mirror_values(
+            std::vector<T>& destination,
+            const std::vector<Id>& ids,
+            const std::vector<T>& values)
+    {
+        for (std::size_t pos = 0; pos < ids.size(); ++pos)
+            destination[ids[pos]] = values[pos];
+    }
+
+    static int newpt_callback(
+            KN_context* kc,
+            const double* const x,
+            const double* const lambda,
+            void* const user_params)
+    {
+        Context* knitro_context_orig = (Context*)user_params;
+        if (!knitro_context_orig->newpt_callback_)
+            return 0;
+        Context knitro_context(kc);
+        return knitro_context_orig->newpt_callback_(knitro_context, x, lambda);
     }
 
     static int mip_node_callback(
@@ -1885,10 +4474,53 @@ private:
             void* const user_params)
     {
         Context* knitro_context_orig = (Context*)user_params;
+        if (!knitro_context_orig->mip_node_callback_)
+            return 0;
         Context knitro_context(kc);
         return knitro_context_orig->mip_node_callback_(knitro_context, x, lambda);
     }
 
+    static int ms_initpt_callback(
+            KN_context* kc,
+            const KNINT solve_number,
+            const double* const lower_bounds,
+            const double* const upper_bounds,
+            double* const x,
+            double* const lambda,
+            void* const user_params)
+    {
+        Context* knitro_context_orig = (Context*)user_params;
+        Context knitro_context(kc);
+        return knitro_context_orig->ms_initpt_callback_(
+                knitro_context,
+                solve_number,
+                lower_bounds,
+                upper_bounds,
+                x,
+                lambda);
+    }
+
+    static int ms_process_callback(
+            KN_context* kc,
+            const double* const x,
+            const double* const lambda,
+            void* const user_params)
+    {
+        Context* knitro_context_orig = (Context*)user_params;
+        Context knitro_context(kc);
+        return knitro_context_orig->ms_process_callback_(knitro_context, x, lambda);
+    }
+
+    static int puts_callback(
+            const char* const str,
+            void* const user_params)
+    {
+        Context* knitro_context = (Context*)user_params;
+        return knitro_context->puts_callback_(str);
+    }
+
+    friend class TraceReplay;
+
     /** Constructor from an already existing C context. */
     Context(KN_context* knitro_context):
         knitro_context_(knitro_context),
@@ -1896,4 +4528,173 @@ private:
 
 };
 
+/**
+ * Class for a pool of Knitro contexts sharing a single license.
+ *
+ * The license is checked out once when the pool is built. acquire() hands
+ * out a fresh context, which is returned to the pool when its handle goes
+ * out of scope. Since a Knitro model cannot be cleared, a returned context
+ * is freed and replaced by a new one created from the held license, which
+ * does not require a license checkout.
+ *
+ * The pool must outlive the handles it hands out.
+ */
+class ContextPool
+{
+
+public:
+
+    /** Handle on a context of the pool. */
+    class Handle
+    {
+
+    public:
+
+        Handle(Handle&& handle):
+            context_pool_(handle.context_pool_),
+            knitro_context_(std::move(handle.knitro_context_)) { }
+
+        ~Handle()
+        {
+            if (knitro_context_ != nullptr)
+                context_pool_->release(std::move(knitro_context_));
+        }
+
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        Context& operator*() const { return *knitro_context_; }
+
+        Context* operator->() const { return knitro_context_.get(); }
+
+    private:
+
+        Handle(
+                ContextPool* context_pool,
+                std::unique_ptr<Context> knitro_context):
+            context_pool_(context_pool),
+            knitro_context_(std::move(knitro_context)) { }
+
+        /** Pool the context belongs to. */
+        ContextPool* context_pool_;
+
+        /** Context. */
+        std::unique_ptr<Context> knitro_context_;
+
+        friend class ContextPool;
+
+    };
+
+    /**
+     * Constructor.
+     *
+     * The pool keeps up to number_of_idle_contexts fresh contexts ready to
+     * be acquired.
+     */
+    ContextPool(std::size_t number_of_idle_contexts = 1):
+        maximum_number_of_idle_contexts_(number_of_idle_contexts)
+    {
+        for (std::size_t pos = 0; pos < number_of_idle_contexts; ++pos)
+            idle_contexts_.push_back(std::unique_ptr<Context>(new Context(license_)));
+    }
+
+    ContextPool(const ContextPool&) = delete;
+    ContextPool& operator=(const ContextPool&) = delete;
+
+    /** Acquire a fresh context. */
+    Handle acquire()
+    {
+        std::unique_ptr<Context> knitro_context;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            number_of_contexts_in_use_++;
+            maximum_number_of_contexts_in_use_ = (std::max)(
+                    maximum_number_of_contexts_in_use_,
+                    number_of_contexts_in_use_);
+            if (!idle_contexts_.empty()) {
+                knitro_context = std::move(idle_contexts_.back());
+                idle_contexts_.pop_back();
+            }
+        }
+        if (knitro_context == nullptr) {
+            try {
+                knitro_context = std::unique_ptr<Context>(new Context(license_));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                number_of_contexts_in_use_--;
+                throw;
+            }
+        }
+        return Handle(this, std::move(knitro_context));
+    }
+
+    /** Get the time spent checking out the license, in seconds. */
+    double license_checkout_time() const { return license_.checkout_time(); }
+
+    /** Get the number of contexts currently acquired. */
+    std::size_t number_of_contexts_in_use() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return number_of_contexts_in_use_;
+    }
+
+    /** Get the largest number of contexts simultaneously acquired. */
+    std::size_t maximum_number_of_contexts_in_use() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return maximum_number_of_contexts_in_use_;
+    }
+
+    /** Get the number of fresh contexts ready to be acquired. */
+    std::size_t number_of_idle_contexts() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return idle_contexts_.size();
+    }
+
+private:
+
+    /** License shared by the contexts. */
+    License license_;
+
+    /** Maximum number of fresh contexts kept in the pool. */
+    std::size_t maximum_number_of_idle_contexts_;
+
+    /** Mutex protecting the members below. */
+    mutable std::mutex mutex_;
+
+    /** Fresh contexts ready to be acquired. */
+    std::vector<std::unique_ptr<Context>> idle_contexts_;
+
+    /** Number of contexts currently acquired. */
+    std::size_t number_of_contexts_in_use_ = 0;
+
+    /** Largest number of contexts simultaneously acquired. */
+    std::size_t maximum_number_of_contexts_in_use_ = 0;
+
+    /** Return a context to the pool. */
+    void release(std::unique_ptr<Context> knitro_context)
+    {
+        knitro_context.reset();
+        bool refill = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            number_of_contexts_in_use_--;
+            refill = (idle_contexts_.size() < maximum_number_of_idle_contexts_);
+        }
+        if (!refill)
+            return;
+        std::unique_ptr<Context> fresh_context;
+        try {
+            fresh_context = std::unique_ptr<Context>(new Context(license_));
+        } catch (...) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_contexts_.size() < maximum_number_of_idle_contexts_)
+            idle_contexts_.push_back(std::move(fresh_context));
+    }
+
+};
+
 }
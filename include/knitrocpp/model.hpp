@@ -0,0 +1,160 @@
+#pragma once
+
+#include <vector>
+
+extern "C"
+{
+#include "knitro.h"
+}
+
+namespace knitrocpp
+{
+
+using VariableId = KNINT;
+using ConstraintId = KNINT;
+
+/**
+ * Structure for a model with linear and quadratic structure.
+ *
+ * A model can be staged, inspected or transformed (for example by a
+ * Presolve) before being loaded into a context with Context::load_model.
+ */
+struct Model
+{
+    /** Objective goal (KN_OBJGOAL_MINIMIZE or KN_OBJGOAL_MAXIMIZE). */
+    int objective_goal = KN_OBJGOAL_MINIMIZE;
+
+    /** Objective constant. */
+    double objective_constant = 0.0;
+
+    /** Linear terms of the objective. */
+    std::vector<VariableId> objective_linear_variable_ids;
+    std::vector<double> objective_linear_coefficients;
+
+    /** Quadratic terms of the objective. */
+    std::vector<VariableId> objective_quadratic_variable_ids_1;
+    std::vector<VariableId> objective_quadratic_variable_ids_2;
+    std::vector<double> objective_quadratic_coefficients;
+
+    /** Variable bounds and types. */
+    std::vector<double> variable_lower_bounds;
+    std::vector<double> variable_upper_bounds;
+    std::vector<int> variable_types;
+
+    /** Constraint bounds and constants. */
+    std::vector<double> constraint_lower_bounds;
+    std::vector<double> constraint_upper_bounds;
+    std::vector<double> constraint_constants;
+
+    /** Linear terms of the constraints. */
+    std::vector<ConstraintId> constraint_linear_constraint_ids;
+    std::vector<VariableId> constraint_linear_variable_ids;
+    std::vector<double> constraint_linear_coefficients;
+
+    /** Quadratic terms of the constraints. */
+    std::vector<ConstraintId> constraint_quadratic_constraint_ids;
+    std::vector<VariableId> constraint_quadratic_variable_ids_1;
+    std::vector<VariableId> constraint_quadratic_variable_ids_2;
+    std::vector<double> constraint_quadratic_coefficients;
+
+    /** Get the number of variables. */
+    VariableId number_of_variables() const { return variable_lower_bounds.size(); }
+
+    /** Get the number of constraints. */
+    ConstraintId number_of_constraints() const { return constraint_lower_bounds.size(); }
+
+    /** Add a free continuous variable. */
+    VariableId add_var()
+    {
+        variable_lower_bounds.push_back(-KN_INFINITY);
+        variable_upper_bounds.push_back(KN_INFINITY);
+        variable_types.push_back(KN_VARTYPE_CONTINUOUS);
+        return number_of_variables() - 1;
+    }
+
+    /** Add an unbounded constraint. */
+    ConstraintId add_con()
+    {
+        constraint_lower_bounds.push_back(-KN_INFINITY);
+        constraint_upper_bounds.push_back(KN_INFINITY);
+        constraint_constants.push_back(0.0);
+        return number_of_constraints() - 1;
+    }
+
+    /** Add a linear term to the objective. */
+    void add_obj_linear_term(
+            VariableId variable_id,
+            double coefficient)
+    {
+        objective_linear_variable_ids.push_back(variable_id);
+        objective_linear_coefficients.push_back(coefficient);
+    }
+
+    /** Add a quadratic term to the objective. */
+    void add_obj_quadratic_term(
+            VariableId variable_id_1,
+            VariableId variable_id_2,
+            double coefficient)
+    {
+        objective_quadratic_variable_ids_1.push_back(variable_id_1);
+        objective_quadratic_variable_ids_2.push_back(variable_id_2);
+        objective_quadratic_coefficients.push_back(coefficient);
+    }
+
+    /** Add a linear term to a constraint. */
+    void add_con_linear_term(
+            ConstraintId constraint_id,
+            VariableId variable_id,
+            double coefficient)
+    {
+        constraint_linear_constraint_ids.push_back(constraint_id);
+        constraint_linear_variable_ids.push_back(variable_id);
+        constraint_linear_coefficients.push_back(coefficient);
+    }
+
+    /** Add a quadratic term to a constraint. */
+    void add_con_quadratic_term(
+            ConstraintId constraint_id,
+            VariableId variable_id_1,
+            VariableId variable_id_2,
+            double coefficient)
+    {
+        constraint_quadratic_constraint_ids.push_back(constraint_id);
+        constraint_quadratic_variable_ids_1.push_back(variable_id_1);
+        constraint_quadratic_variable_ids_2.push_back(variable_id_2);
+        constraint_quadratic_coefficients.push_back(coefficient);
+    }
+
+    /** Evaluate the objective at a point. */
+    double evaluate_objective(const double* const x) const
+    {
+        double value = objective_constant;
+        for (std::size_t pos = 0; pos < objective_linear_variable_ids.size(); ++pos)
+            value += objective_linear_coefficients[pos] * x[objective_linear_variable_ids[pos]];
+        for (std::size_t pos = 0; pos < objective_quadratic_variable_ids_1.size(); ++pos) {
+            value += objective_quadratic_coefficients[pos]
+                * x[objective_quadratic_variable_ids_1[pos]]
+                * x[objective_quadratic_variable_ids_2[pos]];
+        }
+        return value;
+    }
+
+    /** Evaluate the constraints at a point. */
+    std::vector<double> evaluate_constraints(const double* const x) const
+    {
+        std::vector<double> values = constraint_constants;
+        for (std::size_t pos = 0; pos < constraint_linear_constraint_ids.size(); ++pos) {
+            values[constraint_linear_constraint_ids[pos]]
+                += constraint_linear_coefficients[pos] * x[constraint_linear_variable_ids[pos]];
+        }
+        for (std::size_t pos = 0; pos < constraint_quadratic_constraint_ids.size(); ++pos) {
+            values[constraint_quadratic_constraint_ids[pos]]
+                += constraint_quadratic_coefficients[pos]
+                * x[constraint_quadratic_variable_ids_1[pos]]
+                * x[constraint_quadratic_variable_ids_2[pos]];
+        }
+        return values;
+    }
+};
+
+}
@@ -0,0 +1,413 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace knitrocpp
+{
+
+/**
+ * Class for generating multistart initial points from a Halton sequence.
+ *
+ * Points are spread within the variable bounds; for infinite bounds, the
+ * range is limited to maximum_bound_range. Points are generated by batches
+ * by a pool of worker threads owned by the generator, and the next batch is
+ * generated in the background while the current one is consumed.
+ *
+ * A point is discarded if it is closer than the exclusion radius to a point
+ * already explored, the distance being the root mean square of the
+ * coordinate differences scaled by the variable ranges.
+ */
+class MultistartPointGenerator
+{
+
+public:
+
+    /** Constructor. */
+    MultistartPointGenerator(
+            const std::vector<double>& lower_bounds,
+            const std::vector<double>& upper_bounds,
+            double maximum_bound_range = 1000.0,
+            std::size_t batch_size = 64,
+            unsigned number_of_threads = std::thread::hardware_concurrency()):
+        batch_size_(batch_size),
+        number_of_threads_((std::max)((std::min)(
+                    (std::size_t)number_of_threads,
+                    batch_size),
+                (std::size_t)1)),
+        origins_(lower_bounds.size()),
+        ranges_(lower_bounds.size()),
+        primes_(compute_primes(lower_bounds.size()))
+    {
+        for (std::size_t variable_id = 0;
+                variable_id < lower_bounds.size();
+                ++variable_id) {
+            double lower_bound = lower_bounds[variable_id];
+            double upper_bound = upper_bounds[variable_id];
+            bool lower_infinite = (lower_bound <= -KN_INFINITY);
+            bool upper_infinite = (upper_bound >= KN_INFINITY);
+            if (lower_infinite && upper_infinite) {
+                origins_[variable_id] = -maximum_bound_range / 2;
+                ranges_[variable_id] = maximum_bound_range;
+            } else if (lower_infinite) {
+                origins_[variable_id] = upper_bound - maximum_bound_range;
+                ranges_[variable_id] = maximum_bound_range;
+            } else if (upper_infinite) {
+                origins_[variable_id] = lower_bound;
+                ranges_[variable_id] = maximum_bound_range;
+            } else {
+                origins_[variable_id] = lower_bound;
+                ranges_[variable_id] = upper_bound - lower_bound;
+            }
+        }
+        next_batch_.resize(batch_size_ * origins_.size());
+        try {
+            for (std::size_t thread_id = 0; thread_id < number_of_threads_; ++thread_id)
+                threads_.push_back(std::thread(&MultistartPointGenerator::run, this, thread_id));
+        } catch (...) {
+            stop_workers();
+            throw;
+        }
+        start_next_batch(0);
+        wait_next_batch();
+        batch_.swap(next_batch_);
+        start_next_batch(batch_size_);
+    }
+
+    /** Destructor. */
+    ~MultistartPointGenerator()
+    {
+        stop_workers();
+    }
+
+    MultistartPointGenerator(const MultistartPointGenerator&) = delete;
+    MultistartPointGenerator& operator=(const MultistartPointGenerator&) = delete;
+
+    /** Set the exclusion radius. */
+    void set_exclusion_radius(double exclusion_radius)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exclusion_radius_ = exclusion_radius;
+    }
+
+    /**
+     * Write the next initial point into x.
+     *
+     * If no point far enough from the explored points is found in
+     * maximum_number_of_batches batches, the last point generated is used.
+     */
+    void generate(
+            double* const x,
+            std::size_t maximum_number_of_batches = 16)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t number_of_variables = origins_.size();
+        for (std::size_t attempt = 0;
+                attempt < maximum_number_of_batches * batch_size_;
+                ++attempt) {
+            if (batch_position_ == batch_size_) {
+                wait_next_batch();
+                batch_.swap(next_batch_);
+                batch_start_ += batch_size_;
+                batch_position_ = 0;
+                start_next_batch(batch_start_ + batch_size_);
+            }
+            const double* point = batch_.data() + batch_position_ * number_of_variables;
+            batch_position_++;
+            std::copy(point, point + number_of_variables, x);
+            if (!is_explored(point))
+                return;
+            number_of_discarded_points_++;
+        }
+    }
+
+    /** Add an explored point, typically a local solution. */
+    void add_explored_point(const double* const x)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        explored_points_.insert(explored_points_.end(), x, x + origins_.size());
+    }
+
+    /** Get the number of points discarded because already explored. */
+    std::size_t number_of_discarded_points() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return number_of_discarded_points_;
+    }
+
+private:
+
+    /** Number of points per batch. */
+    std::size_t batch_size_;
+
+    /** Number of worker threads generating the batches. */
+    std::size_t number_of_threads_;
+
+    /** Origin of the sampling box of each variable. */
+    std::vector<double> origins_;
+
+    /** Width of the sampling box of each variable. */
+    std::vector<double> ranges_;
+
+    /** Prime number used as base for each variable. */
+    std::vector<std::uint64_t> primes_;
+
+    /** Mutex protecting the members below. */
+    mutable std::mutex mutex_;
+
+    /** Current batch of points, stored contiguously. */
+    std::vector<double> batch_;
+
+    /** Index in the sequence of the first point of the current batch. */
+    std::size_t batch_start_ = 0;
+
+    /** Position of the next point in the current batch. */
+    std::size_t batch_position_ = 0;
+
+    /*
+     * Worker pool.
+     */
+
+    /** Worker threads. */
+    std::vector<std::thread> threads_;
+
+    /**
+     * Mutex protecting the members below; the workers write their part of
+     * next_batch_ without holding it.
+     */
+    std::mutex pool_mutex_;
+
+    /** Condition variable signaled when a batch is started or on stop. */
+    std::condition_variable start_condition_variable_;
+
+    /** Condition variable signaled when the next batch is complete. */
+    std::condition_variable done_condition_variable_;
+
+    /** Next batch of points, being generated by the workers. */
+    std::vector<double> next_batch_;
+
+    /** Index in the sequence of the first point of the next batch. */
+    std::size_t next_batch_start_ = 0;
+
+    /** Number of batches started; workers compare it to the last batch they generated. */
+    std::size_t number_of_started_batches_ = 0;
+
+    /** Number of workers which have generated their part of the next batch. */
+    std::size_t number_of_finished_workers_ = 0;
+
+    /** True iff the workers must exit. */
+    bool stop_ = false;
+
+    /** Exclusion radius. */
+    double exclusion_radius_ = 0.05;
+
+    /** Explored points, stored contiguously. */
+    std::vector<double> explored_points_;
+
+    /** Number of discarded points. */
+    std::size_t number_of_discarded_points_ = 0;
+
+    /** Compute the first number_of_primes prime numbers. */
+    static std::vector<std::uint64_t> compute_primes(std::size_t number_of_primes)
+    {
+        std::vector<std::uint64_t> primes;
+        std::size_t limit = 16;
+        while (primes.size() < number_of_primes) {
+            limit *= 2;
+            std::vector<bool> composite(limit + 1, false);
+            primes.clear();
+            for (std::size_t value = 2;
+                    value <= limit && primes.size() < number_of_primes;
+                    ++value) {
+                if (composite[value])
+                    continue;
+                primes.push_back(value);
+                for (std::size_t multiple = value * value;
+                        multiple <= limit;
+                        multiple += value) {
+                    composite[multiple] = true;
+                }
+            }
+        }
+        return primes;
+    }
+
+    /** Compute the radical inverse of index in a given base. */
+    static double radical_inverse(
+            std::uint64_t index,
+            std::uint64_t base)
+    {
+        double inverse_base = 1.0 / base;
+        double factor = inverse_base;
+        double value = 0.0;
+        while (index > 0) {
+            value += (index % base) * factor;
+            index /= base;
+            factor *= inverse_base;
+        }
+        return value;
+    }
+
+    /** Generate the points [point_start, point_end) of the next batch. */
+    void generate_points(
+            std::size_t batch_start,
+            std::size_t point_start,
+            std::size_t point_end)
+    {
+        std::size_t number_of_variables = origins_.size();
+        for (std::size_t point_id = point_start; point_id < point_end; ++point_id) {
+            // Skip the first elements of the sequence, which are strongly
+            // correlated between dimensions.
+            std::uint64_t index = batch_start + point_id + 20;
+            double* point = next_batch_.data() + point_id * number_of_variables;
+            for (std::size_t variable_id = 0;
+                    variable_id < number_of_variables;
+                    ++variable_id) {
+                point[variable_id] = origins_[variable_id]
+                    + ranges_[variable_id] * radical_inverse(
+                            index,
+                            primes_[variable_id]);
+            }
+        }
+    }
+
+    /** Main loop of a worker thread. */
+    void run(std::size_t thread_id)
+    {
+        std::size_t number_of_generated_batches = 0;
+        for (;;) {
+            std::size_t batch_start = 0;
+            {
+                std::unique_lock<std::mutex> lock(pool_mutex_);
+                start_condition_variable_.wait(lock, [this, number_of_generated_batches]()
+                        {
+                            return stop_ || number_of_started_batches_ != number_of_generated_batches;
+                        });
+                if (stop_)
+                    return;
+                number_of_generated_batches = number_of_started_batches_;
+                batch_start = next_batch_start_;
+            }
+            generate_points(
+                    batch_start,
+                    batch_size_ * thread_id / number_of_threads_,
+                    batch_size_ * (thread_id + 1) / number_of_threads_);
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            number_of_finished_workers_++;
+            if (number_of_finished_workers_ == number_of_threads_)
+                done_condition_variable_.notify_one();
+        }
+    }
+
+    /**
+     * Start the generation of the next batch by the workers.
+     *
+     * next_batch_ must not be accessed until wait_next_batch() returns.
+     */
+    void start_next_batch(std::size_t batch_start)
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        next_batch_.resize(batch_size_ * origins_.size());
+        next_batch_start_ = batch_start;
+        number_of_finished_workers_ = 0;
+        number_of_started_batches_++;
+        start_condition_variable_.notify_all();
+    }
+
+    /** Wait until the workers have generated the next batch. */
+    void wait_next_batch()
+    {
+        std::unique_lock<std::mutex> lock(pool_mutex_);
+        done_condition_variable_.wait(lock, [this]()
+                {
+                    return number_of_finished_workers_ == number_of_threads_;
+                });
+    }
+
+    /** Stop and join the worker threads. */
+    void stop_workers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            stop_ = true;
+        }
+        start_condition_variable_.notify_all();
+        for (std::thread& thread: threads_)
+            thread.join();
+    }
+
+    /** Return true iff a point is within the exclusion radius of an explored point. */
+    bool is_explored(const double* const point) const
+    {
+        std::size_t number_of_variables = origins_.size();
+        if (number_of_variables == 0 || exclusion_radius_ <= 0.0)
+            return false;
+        double threshold = exclusion_radius_ * exclusion_radius_ * number_of_variables;
+        for (std::size_t explored_start = 0;
+                explored_start < explored_points_.size();
+                explored_start += number_of_variables) {
+            const double* explored_point = explored_points_.data() + explored_start;
+            double distance = 0.0;
+            for (std::size_t variable_id = 0;
+                    variable_id < number_of_variables
+                    && distance < threshold;
+                    ++variable_id) {
+                if (ranges_[variable_id] <= 0.0)
+                    continue;
+                double difference = (point[variable_id] - explored_point[variable_id])
+                    / ranges_[variable_id];
+                distance += difference * difference;
+            }
+            if (distance < threshold)
+                return true;
+        }
+        return false;
+    }
+
+};
+
+
+/**
+ * Use a point generator for the multistart initial points of a solve.
+ *
+ * The solution of each multistart solve is added to the explored points of
+ * the generator. This replaces the callbacks set with
+ * Context::set_ms_initpt_callback and Context::set_ms_process_callback. The
+ * generator must outlive the solve.
+ */
+inline void set_ms_point_generator(
+        Context& knitro_context,
+        MultistartPointGenerator& multistart_point_generator)
+{
+    MultistartPointGenerator* generator = &multistart_point_generator;
+    knitro_context.set_ms_initpt_callback(
+            [generator](
+                const Context&,
+                KNINT,
+                const double* const,
+                const double* const,
+                double* const x,
+                double* const)
+            {
+                generator->generate(x);
+                return 0;
+            });
+    knitro_context.set_ms_process_callback(
+            [generator](
+                const Context&,
+                const double* const x,
+                const double* const)
+            {
+                generator->add_explored_point(x);
+                return 0;
+            });
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <map>
+#include <string>
+
+namespace knitrocpp
+{
+
+/**
+ * Class for a full configuration of parameters.
+ *
+ * apply() only sets the parameters whose value differs from the current
+ * value in the context.
+ */
+class ParamSet
+{
+
+public:
+
+    /** Set an integer valued parameter. */
+    void set(
+            const IntParamDescriptor& param,
+            const int value)
+    {
+        check_param_value(param, value);
+        int_params_[param.id] = value;
+    }
+
+    /** Set a double valued parameter. */
+    void set(
+            const DoubleParamDescriptor& param,
+            const double value)
+    {
+        check_param_value(param, value);
+        double_params_[param.id] = value;
+    }
+
+    /** Set the parameters of a context; return the number of parameters changed. */
+    int apply(Context& knitro_context) const
+    {
+        int number_of_changes = 0;
+        for (const auto& param: int_params_) {
+            if (knitro_context.get_int_param(param.first) != param.second) {
+                knitro_context.set_int_param(param.first, param.second);
+                number_of_changes++;
+            }
+        }
+        for (const auto& param: double_params_) {
+            if (knitro_context.get_double_param(param.first) != param.second) {
+                knitro_context.set_double_param(param.first, param.second);
+                number_of_changes++;
+            }
+        }
+        return number_of_changes;
+    }
+
+private:
+
+    /** Integer valued parameters. */
+    std::map<int, int> int_params_;
+
+    /** Double valued parameters. */
+    std::map<int, double> double_params_;
+
+};
+
+}
@@ -0,0 +1,406 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace knitrocpp
+{
+
+/**
+ * Structure for the parameters of a point evaluator.
+ */
+struct PointEvaluatorParameters
+{
+    /** Number of threads evaluating the points of a batch. */
+    unsigned number_of_threads = std::thread::hardware_concurrency();
+
+    /** Number of points evaluated by a thread at a time. */
+    std::size_t chunk_size = 64;
+
+    /**
+     * Call the evaluation callbacks; if false, only the linear and
+     * quadratic structure is evaluated.
+     */
+    bool evaluate_callbacks = true;
+};
+
+/**
+ * Structure for the evaluation of a point.
+ */
+struct PointEvaluation
+{
+    /** Return code of the callbacks (0 if they succeeded). */
+    int status = 0;
+
+    /** Objective value. */
+    double objective_value = 0.0;
+
+    /**
+     * Largest violation of a constraint bound or of a variable bound, 0.0 if
+     * the point is feasible. The constraints which are not evaluated are
+     * not checked.
+     */
+    double maximum_violation = 0.0;
+
+    /**
+     * Boolean indicating if the objective has been evaluated; false for a
+     * least squares objective, objective_value is then NaN.
+     */
+    bool objective_evaluated = true;
+
+    /**
+     * Number of constraints which have not been evaluated (L2 norm
+     * constraints); their values are NaN.
+     */
+    ConstraintId number_of_unevaluated_constraints = 0;
+};
+
+/**
+ * Class for evaluating the objective and the constraints of the model of a
+ * context at points, without solving.
+ *
+ * The linear and quadratic structure is copied from the structure mirror
+ * of the context (see Context::enable_structure_mirror) into row-compressed
+ * (CSR) matrices when the evaluator is built; later modifications of the
+ * context are not seen. The parts of the model evaluated by callbacks are
+ * evaluated with Context::evaluate_callbacks, so the context must outlive
+ * the evaluator and, with several threads, the callbacks must be thread
+ * safe.
+ *
+ * L2 norm constraints and least squares objectives (residuals) are not
+ * evaluated: their values are NaN, the L2 norm constraints are excluded
+ * from the maximum violation, and each evaluation reports what has been
+ * skipped.
+ */
+class PointEvaluator
+{
+
+public:
+
+    /** Constructor. */
+    PointEvaluator(
+            const Context& knitro_context,
+            const PointEvaluatorParameters& parameters = {}):
+        knitro_context_(knitro_context),
+        parameters_(parameters)
+    {
+        const Model& model = knitro_context.structure_mirror();
+        number_of_variables_ = model.number_of_variables();
+        number_of_constraints_ = model.number_of_constraints();
+        objective_constant_ = model.objective_constant;
+        objective_linear_variable_ids_ = model.objective_linear_variable_ids;
+        objective_linear_coefficients_ = model.objective_linear_coefficients;
+        objective_quadratic_variable_ids_1_ = model.objective_quadratic_variable_ids_1;
+        objective_quadratic_variable_ids_2_ = model.objective_quadratic_variable_ids_2;
+        objective_quadratic_coefficients_ = model.objective_quadratic_coefficients;
+        variable_lower_bounds_ = model.variable_lower_bounds;
+        variable_upper_bounds_ = model.variable_upper_bounds;
+        constraint_lower_bounds_ = model.constraint_lower_bounds;
+        constraint_upper_bounds_ = model.constraint_upper_bounds;
+        constraint_constants_ = model.constraint_constants;
+        has_callbacks_ = knitro_context.is_obj_mirror_nonlinear();
+        objective_evaluated_ = !knitro_context.is_obj_mirror_least_squares();
+        constraint_evaluated_.assign(number_of_constraints_, 1);
+        for (ConstraintId constraint_id = 0;
+                constraint_id < number_of_constraints_;
+                ++constraint_id) {
+            if (knitro_context.is_con_mirror_nonlinear(constraint_id))
+                has_callbacks_ = true;
+            if (knitro_context.is_con_mirror_l2norm(constraint_id)) {
+                constraint_evaluated_[constraint_id] = 0;
+                number_of_unevaluated_constraints_++;
+            }
+        }
+
+        // Linear terms.
+        std::vector<std::size_t> positions;
+        build_csr(
+                model.constraint_linear_constraint_ids,
+                linear_row_starts_,
+                positions);
+        linear_variable_ids_.resize(positions.size());
+        linear_coefficients_.resize(positions.size());
+        for (std::size_t pos = 0; pos < positions.size(); ++pos) {
+            linear_variable_ids_[pos] = model.constraint_linear_variable_ids[positions[pos]];
+            linear_coefficients_[pos] = model.constraint_linear_coefficients[positions[pos]];
+        }
+
+        // Quadratic terms.
+        build_csr(
+                model.constraint_quadratic_constraint_ids,
+                quadratic_row_starts_,
+                positions);
+        quadratic_variable_ids_1_.resize(positions.size());
+        quadratic_variable_ids_2_.resize(positions.size());
+        quadratic_coefficients_.resize(positions.size());
+        for (std::size_t pos = 0; pos < positions.size(); ++pos) {
+            quadratic_variable_ids_1_[pos] = model.constraint_quadratic_variable_ids_1[positions[pos]];
+            quadratic_variable_ids_2_[pos] = model.constraint_quadratic_variable_ids_2[positions[pos]];
+            quadratic_coefficients_[pos] = model.constraint_quadratic_coefficients[positions[pos]];
+        }
+    }
+
+    /** Get the number of variables. */
+    VariableId number_of_variables() const { return number_of_variables_; }
+
+    /** Get the number of constraints. */
+    ConstraintId number_of_constraints() const { return number_of_constraints_; }
+
+    /** Return true iff the objective is evaluated (not least squares). */
+    bool is_objective_evaluated() const { return objective_evaluated_; }
+
+    /** Return true iff a constraint is evaluated (not an L2 norm constraint). */
+    bool is_constraint_evaluated(ConstraintId constraint_id) const
+    {
+        return constraint_evaluated_[constraint_id];
+    }
+
+    /**
+     * Evaluate a point.
+     *
+     * If constraint_values is not null, it receives the value of each
+     * constraint. thread_id is passed to Context::evaluate_callbacks;
+     * concurrent calls must use distinct identifiers.
+     */
+    PointEvaluation evaluate(
+            const double* const x,
+            double* constraint_values = nullptr,
+            int thread_id = 0) const
+    {
+        static thread_local std::vector<double> buffer;
+        if (constraint_values == nullptr) {
+            buffer.resize(number_of_constraints_);
+            constraint_values = buffer.data();
+        }
+        PointEvaluation evaluation;
+        evaluation.objective_evaluated = objective_evaluated_;
+        evaluation.number_of_unevaluated_constraints = number_of_unevaluated_constraints_;
+
+        // Objective.
+        double objective_value = objective_constant_;
+        for (std::size_t pos = 0; pos < objective_linear_variable_ids_.size(); ++pos)
+            objective_value += objective_linear_coefficients_[pos] * x[objective_linear_variable_ids_[pos]];
+        for (std::size_t pos = 0; pos < objective_quadratic_variable_ids_1_.size(); ++pos) {
+            objective_value += objective_quadratic_coefficients_[pos]
+                * x[objective_quadratic_variable_ids_1_[pos]]
+                * x[objective_quadratic_variable_ids_2_[pos]];
+        }
+
+        // Constraints.
+        for (ConstraintId constraint_id = 0;
+                constraint_id < number_of_constraints_;
+                ++constraint_id) {
+            double value = constraint_constants_[constraint_id];
+            for (std::size_t pos = linear_row_starts_[constraint_id];
+                    pos < linear_row_starts_[constraint_id + 1];
+                    ++pos) {
+                value += linear_coefficients_[pos] * x[linear_variable_ids_[pos]];
+            }
+            for (std::size_t pos = quadratic_row_starts_[constraint_id];
+                    pos < quadratic_row_starts_[constraint_id + 1];
+                    ++pos) {
+                value += quadratic_coefficients_[pos]
+                    * x[quadratic_variable_ids_1_[pos]]
+                    * x[quadratic_variable_ids_2_[pos]];
+            }
+            constraint_values[constraint_id] = value;
+        }
+
+        // Callbacks.
+        if (has_callbacks_ && parameters_.evaluate_callbacks) {
+            evaluation.status = knitro_context_.evaluate_callbacks(
+                    x,
+                    objective_value,
+                    constraint_values,
+                    thread_id);
+            if (evaluation.status != 0) {
+                evaluation.objective_value = std::numeric_limits<double>::quiet_NaN();
+                evaluation.maximum_violation = std::numeric_limits<double>::infinity();
+                return evaluation;
+            }
+        }
+        evaluation.objective_value = objective_value;
+        if (!objective_evaluated_)
+            evaluation.objective_value = std::numeric_limits<double>::quiet_NaN();
+        if (number_of_unevaluated_constraints_ > 0) {
+            for (ConstraintId constraint_id = 0;
+                    constraint_id < number_of_constraints_;
+                    ++constraint_id) {
+                if (!constraint_evaluated_[constraint_id])
+                    constraint_values[constraint_id] = std::numeric_limits<double>::quiet_NaN();
+            }
+        }
+
+        // Violation.
+        double maximum_violation = 0.0;
+        for (VariableId variable_id = 0;
+                variable_id < number_of_variables_;
+                ++variable_id) {
+            maximum_violation = std::max(maximum_violation, std::max(
+                        variable_lower_bounds_[variable_id] - x[variable_id],
+                        x[variable_id] - variable_upper_bounds_[variable_id]));
+        }
+        for (ConstraintId constraint_id = 0;
+                constraint_id < number_of_constraints_;
+                ++constraint_id) {
+            if (!constraint_evaluated_[constraint_id])
+                continue;
+            double value = constraint_values[constraint_id];
+            if (std::isnan(value)) {
+                maximum_violation = std::numeric_limits<double>::infinity();
+                break;
+            }
+            maximum_violation = std::max(maximum_violation, std::max(
+                        constraint_lower_bounds_[constraint_id] - value,
+                        value - constraint_upper_bounds_[constraint_id]));
+        }
+        evaluation.maximum_violation = maximum_violation;
+        return evaluation;
+    }
+
+    /**
+     * Evaluate a batch of points, in parallel.
+     *
+     * points contains the number_of_points points one after the other
+     * (number_of_variables values each). If constraint_values is not null,
+     * it receives the constraint values of the points one after the other
+     * (number_of_constraints values each).
+     */
+    void evaluate(
+            std::size_t number_of_points,
+            const double* const points,
+            PointEvaluation* const evaluations,
+            double* const constraint_values = nullptr) const
+    {
+        std::size_t chunk_size = std::max<std::size_t>(1, parameters_.chunk_size);
+        std::size_t number_of_chunks = (number_of_points + chunk_size - 1) / chunk_size;
+        std::atomic<std::size_t> next_chunk_id(0);
+        auto run_chunks = [&](int thread_id)
+        {
+            for (;;) {
+                std::size_t chunk_id = next_chunk_id.fetch_add(1);
+                if (chunk_id >= number_of_chunks)
+                    return;
+                std::size_t point_end = std::min(number_of_points, (chunk_id + 1) * chunk_size);
+                for (std::size_t point_id = chunk_id * chunk_size;
+                        point_id < point_end;
+                        ++point_id) {
+                    evaluations[point_id] = evaluate(
+                            points + point_id * number_of_variables_,
+                            (constraint_values == nullptr)? nullptr:
+                            constraint_values + point_id * number_of_constraints_,
+                            thread_id);
+                }
+            }
+        };
+        std::size_t number_of_threads = std::min<std::size_t>(
+                std::max(1u, parameters_.number_of_threads),
+                number_of_chunks);
+        std::vector<std::thread> threads;
+        for (std::size_t thread_id = 1; thread_id < number_of_threads; ++thread_id)
+            threads.push_back(std::thread(run_chunks, (int)thread_id));
+        run_chunks(0);
+        for (std::thread& thread: threads)
+            thread.join();
+    }
+
+    /** Evaluate a batch of points, in parallel. */
+    std::vector<PointEvaluation> evaluate(
+            const std::vector<std::vector<double>>& points) const
+    {
+        std::vector<double> flat_points;
+        flat_points.reserve(points.size() * number_of_variables_);
+        for (const std::vector<double>& point: points) {
+            if ((VariableId)point.size() != number_of_variables_) {
+                throw std::runtime_error(
+                        "KnitroCpp error: point of size " + std::to_string(point.size())
+                        + " for a model with " + std::to_string(number_of_variables_)
+                        + " variables.");
+            }
+            flat_points.insert(flat_points.end(), point.begin(), point.end());
+        }
+        std::vector<PointEvaluation> evaluations(points.size());
+        evaluate(points.size(), flat_points.data(), evaluations.data());
+        return evaluations;
+    }
+
+private:
+
+    /**
+     * Compute the row starts of a CSR matrix from the row ids of its terms
+     * and the positions of the terms sorted by row (stable).
+     */
+    void build_csr(
+            const std::vector<ConstraintId>& row_ids,
+            std::vector<std::size_t>& row_starts,
+            std::vector<std::size_t>& positions) const
+    {
+        row_starts.assign(number_of_constraints_ + 1, 0);
+        for (ConstraintId row_id: row_ids)
+            row_starts[row_id + 1]++;
+        for (ConstraintId row_id = 0; row_id < number_of_constraints_; ++row_id)
+            row_starts[row_id + 1] += row_starts[row_id];
+        std::vector<std::size_t> next(row_starts.begin(), row_starts.end() - 1);
+        positions.resize(row_ids.size());
+        for (std::size_t pos = 0; pos < row_ids.size(); ++pos)
+            positions[next[row_ids[pos]]++] = pos;
+    }
+
+    /** Context. */
+    const Context& knitro_context_;
+
+    /** Parameters. */
+    PointEvaluatorParameters parameters_;
+
+    /** Number of variables. */
+    VariableId number_of_variables_ = 0;
+
+    /** Number of constraints. */
+    ConstraintId number_of_constraints_ = 0;
+
+    /** Boolean indicating if parts of the model are evaluated by callbacks. */
+    bool has_callbacks_ = false;
+
+    /** Boolean indicating if the objective is evaluated. */
+    bool objective_evaluated_ = true;
+
+    /** For each constraint, 1 if it is evaluated, 0 otherwise. */
+    std::vector<char> constraint_evaluated_;
+
+    /** Number of constraints which are not evaluated. */
+    ConstraintId number_of_unevaluated_constraints_ = 0;
+
+    /** Objective. */
+    double objective_constant_ = 0.0;
+    std::vector<VariableId> objective_linear_variable_ids_;
+    std::vector<double> objective_linear_coefficients_;
+    std::vector<VariableId> objective_quadratic_variable_ids_1_;
+    std::vector<VariableId> objective_quadratic_variable_ids_2_;
+    std::vector<double> objective_quadratic_coefficients_;
+
+    /** Bounds. */
+    std::vector<double> variable_lower_bounds_;
+    std::vector<double> variable_upper_bounds_;
+    std::vector<double> constraint_lower_bounds_;
+    std::vector<double> constraint_upper_bounds_;
+    std::vector<double> constraint_constants_;
+
+    /** Linear terms of the constraints (CSR). */
+    std::vector<std::size_t> linear_row_starts_;
+    std::vector<VariableId> linear_variable_ids_;
+    std::vector<double> linear_coefficients_;
+
+    /** Quadratic terms of the constraints (CSR). */
+    std::vector<std::size_t> quadratic_row_starts_;
+    std::vector<VariableId> quadratic_variable_ids_1_;
+    std::vector<VariableId> quadratic_variable_ids_2_;
+    std::vector<double> quadratic_coefficients_;
+
+};
+
+}
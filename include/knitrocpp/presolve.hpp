@@ -0,0 +1,925 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace knitrocpp
+{
+
+/**
+ * Structure for the parameters of a presolve.
+ */
+struct PresolveParameters
+{
+    /** Tolerance used to compare bounds and coefficients. */
+    double tolerance = 1e-9;
+
+    /** Remove the variables whose lower and upper bounds are equal. */
+    bool remove_fixed_variables = true;
+
+    /** Replace the linear constraints with a single variable by bounds. */
+    bool remove_singleton_rows = true;
+
+    /** Remove the constraints without any variable. */
+    bool remove_empty_rows = true;
+
+    /** Merge the linear constraints which are multiples of each other. */
+    bool remove_duplicate_rows = true;
+};
+
+/**
+ * Class for a structural presolve of a model.
+ *
+ * The presolve builds a reduced model without fixed variables, singleton
+ * rows (turned into variable bounds), empty rows and duplicate linear rows.
+ * The reduced model is loaded into an empty context with
+ * Context::load_model; after the solve, the getters of the presolve return
+ * the solution in the index space of the original model.
+ *
+ * The model must describe the whole problem: evaluation callbacks refer to
+ * variable ids and cannot be added to the reduced model. The model must
+ * outlive the presolve.
+ */
+class Presolve
+{
+
+public:
+
+    /** Constructor. */
+    explicit Presolve(
+            const Model& model,
+            const PresolveParameters& parameters = PresolveParameters()):
+        model_(&model),
+        parameters_(parameters),
+        variable_lower_bounds_(model.variable_lower_bounds),
+        variable_upper_bounds_(model.variable_upper_bounds),
+        constraint_lower_bounds_(model.constraint_lower_bounds),
+        constraint_upper_bounds_(model.constraint_upper_bounds),
+        variable_fixed_(model.number_of_variables(), 0),
+        variable_values_(model.number_of_variables(), 0.0),
+        constraint_removed_(model.number_of_constraints(), 0),
+        scratch_coefficients_(model.number_of_variables(), 0.0),
+        scratch_touched_(model.number_of_variables(), 0)
+    {
+        build_incidence();
+        reduce();
+        build_reduced_model();
+    }
+
+    /** Get the reduced model. */
+    const Model& reduced_model() const { return reduced_model_; }
+
+    /** Return true iff the presolve detected that the model is infeasible. */
+    bool infeasible() const { return infeasible_; }
+
+    /** Get the number of fixed variables removed. */
+    VariableId number_of_removed_variables() const { return number_of_removed_variables_; }
+
+    /** Get the number of singleton rows turned into variable bounds. */
+    ConstraintId number_of_singleton_rows() const { return number_of_singleton_rows_; }
+
+    /** Get the number of empty rows removed. */
+    ConstraintId number_of_empty_rows() const { return number_of_empty_rows_; }
+
+    /** Get the number of duplicate rows removed. */
+    ConstraintId number_of_duplicate_rows() const { return number_of_duplicate_rows_; }
+
+    /** Get the id of a variable in the reduced model, -1 if it was removed. */
+    VariableId reduced_variable_id(VariableId variable_id) const { return reduced_variable_ids_[variable_id]; }
+
+    /** Get the id of a constraint in the reduced model, -1 if it was removed. */
+    ConstraintId reduced_constraint_id(ConstraintId constraint_id) const { return reduced_constraint_ids_[constraint_id]; }
+
+    /*
+     * Postsolve
+     */
+
+    /** Get the primal values of the original variables from reduced ones. */
+    std::vector<double> postsolve_primal_values(
+            const std::vector<double>& reduced_primal_values) const
+    {
+        std::vector<double> primal_values(variable_values_);
+        for (VariableId variable_id = 0;
+                variable_id < model_->number_of_variables();
+                ++variable_id) {
+            VariableId reduced_variable_id = reduced_variable_ids_[variable_id];
+            if (reduced_variable_id != -1)
+                primal_values[variable_id] = reduced_primal_values[reduced_variable_id];
+        }
+        return primal_values;
+    }
+
+    /**
+     * Get the dual values of the original constraints and variables from
+     * the primal values of the original variables and reduced dual values.
+     *
+     * The removed steps are undone in reverse order: a singleton or
+     * duplicate row gets the multiplier of the bound it implied if that
+     * bound is active, and the multiplier of a fixed variable is its
+     * reduced cost, such that the gradient of the Lagrangian vanishes.
+     */
+    void postsolve_dual_values(
+            const std::vector<double>& primal_values,
+            const std::vector<double>& reduced_constraint_dual_values,
+            const std::vector<double>& reduced_variable_dual_values,
+            std::vector<double>& constraint_dual_values,
+            std::vector<double>& variable_dual_values) const
+    {
+        constraint_dual_values.assign(model_->number_of_constraints(), 0.0);
+        variable_dual_values.assign(model_->number_of_variables(), 0.0);
+        for (ConstraintId constraint_id = 0;
+                constraint_id < model_->number_of_constraints();
+                ++constraint_id) {
+            ConstraintId reduced_constraint_id = reduced_constraint_ids_[constraint_id];
+            if (reduced_constraint_id != -1)
+                constraint_dual_values[constraint_id] = reduced_constraint_dual_values[reduced_constraint_id];
+        }
+        for (VariableId variable_id = 0;
+                variable_id < model_->number_of_variables();
+                ++variable_id) {
+            VariableId reduced_variable_id = reduced_variable_ids_[variable_id];
+            if (reduced_variable_id != -1)
+                variable_dual_values[variable_id] = reduced_variable_dual_values[reduced_variable_id];
+        }
+
+        for (auto it = postsolve_steps_.rbegin(); it != postsolve_steps_.rend(); ++it) {
+            const PostsolveStep& step = *it;
+            switch (step.type) {
+            case PostsolveStepType::FixedVariable: {
+                variable_dual_values[step.variable_id] = -lagrangian_gradient(
+                        step.variable_id,
+                        primal_values,
+                        constraint_dual_values);
+                break;
+            } case PostsolveStepType::SingletonRow: {
+                double& dual_value = variable_dual_values[step.variable_id];
+                if ((dual_value < 0 && step.implies_lower_bound)
+                        || (dual_value > 0 && step.implies_upper_bound)) {
+                    constraint_dual_values[step.constraint_id] = dual_value / step.coefficient;
+                    dual_value = 0.0;
+                }
+                break;
+            } case PostsolveStepType::DuplicateRow: {
+                double& dual_value = constraint_dual_values[step.kept_constraint_id];
+                if ((dual_value < 0 && step.implies_lower_bound)
+                        || (dual_value > 0 && step.implies_upper_bound)) {
+                    constraint_dual_values[step.constraint_id] = dual_value / step.coefficient;
+                    dual_value = 0.0;
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    /**
+     * Get the primal values of the original variables from a context in
+     * which the reduced model has been loaded.
+     */
+    std::vector<double> get_var_primal_values(const Context& reduced_context) const
+    {
+        return postsolve_primal_values(reduced_context.get_var_primal_values());
+    }
+
+    /** Get the values of the original constraints. */
+    std::vector<double> get_con_values(const Context& reduced_context) const
+    {
+        return model_->evaluate_constraints(get_var_primal_values(reduced_context).data());
+    }
+
+    /** Get the dual values of the original variables. */
+    std::vector<double> get_var_dual_values(const Context& reduced_context) const
+    {
+        std::vector<double> constraint_dual_values;
+        std::vector<double> variable_dual_values;
+        postsolve_dual_values(
+                get_var_primal_values(reduced_context),
+                reduced_context.get_con_dual_values(),
+                reduced_context.get_var_dual_values(),
+                constraint_dual_values,
+                variable_dual_values);
+        return variable_dual_values;
+    }
+
+    /** Get the dual values of the original constraints. */
+    std::vector<double> get_con_dual_values(const Context& reduced_context) const
+    {
+        std::vector<double> constraint_dual_values;
+        std::vector<double> variable_dual_values;
+        postsolve_dual_values(
+                get_var_primal_values(reduced_context),
+                reduced_context.get_con_dual_values(),
+                reduced_context.get_var_dual_values(),
+                constraint_dual_values,
+                variable_dual_values);
+        return constraint_dual_values;
+    }
+
+private:
+
+    enum class PostsolveStepType
+    {
+        FixedVariable,
+        SingletonRow,
+        DuplicateRow,
+    };
+
+    /**
+     * Structure for a reduction, undone during the postsolve.
+     *
+     * For a singleton row, coefficient is the coefficient of the variable.
+     * For a duplicate row, it is the ratio between the removed row and the
+     * kept row.
+     */
+    struct PostsolveStep
+    {
+        PostsolveStepType type;
+        VariableId variable_id;
+        ConstraintId constraint_id;
+        ConstraintId kept_constraint_id;
+        double coefficient;
+        bool implies_lower_bound;
+        bool implies_upper_bound;
+    };
+
+    /** Structure for the linear part of a row once fixed variables are substituted. */
+    struct RowAnalysis
+    {
+        /** Linear terms on non-fixed variables, sorted by variable id. */
+        std::vector<std::pair<VariableId, double>> terms;
+
+        /** Constant, including the contribution of the fixed variables. */
+        double constant = 0.0;
+
+        /** True iff the row has a quadratic term on two non-fixed variables. */
+        bool nonlinear = false;
+    };
+
+    /** Original model. */
+    const Model* model_;
+
+    /** Parameters. */
+    PresolveParameters parameters_;
+
+    /** Current bounds. */
+    std::vector<double> variable_lower_bounds_;
+    std::vector<double> variable_upper_bounds_;
+    std::vector<double> constraint_lower_bounds_;
+    std::vector<double> constraint_upper_bounds_;
+
+    /** Fixed variables and their values. */
+    std::vector<char> variable_fixed_;
+    std::vector<double> variable_values_;
+
+    /** Removed constraints. */
+    std::vector<char> constraint_removed_;
+
+    /** Linear and quadratic term indices of each constraint. */
+    std::vector<std::size_t> constraint_linear_starts_;
+    std::vector<std::size_t> constraint_linear_terms_;
+    std::vector<std::size_t> constraint_quadratic_starts_;
+    std::vector<std::size_t> constraint_quadratic_terms_;
+
+    /** Linear and quadratic constraint term indices of each variable. */
+    std::vector<std::size_t> variable_linear_starts_;
+    std::vector<std::size_t> variable_linear_terms_;
+    std::vector<std::size_t> variable_quadratic_starts_;
+    std::vector<std::size_t> variable_quadratic_terms_;
+
+    /** Objective quadratic term indices of each variable. */
+    std::vector<std::size_t> variable_objective_quadratic_starts_;
+    std::vector<std::size_t> variable_objective_quadratic_terms_;
+
+    /** Aggregated linear objective coefficients. */
+    std::vector<double> objective_linear_coefficients_;
+
+    /** Scratch arrays used to aggregate the terms of a row. */
+    std::vector<double> scratch_coefficients_;
+    std::vector<char> scratch_touched_;
+    std::vector<VariableId> scratch_variable_ids_;
+
+    /** Reductions, in the order in which they were applied. */
+    std::vector<PostsolveStep> postsolve_steps_;
+
+    /** Reduced model and index maps. */
+    Model reduced_model_;
+    std::vector<VariableId> reduced_variable_ids_;
+    std::vector<ConstraintId> reduced_constraint_ids_;
+
+    /** Statistics. */
+    bool infeasible_ = false;
+    VariableId number_of_removed_variables_ = 0;
+    ConstraintId number_of_singleton_rows_ = 0;
+    ConstraintId number_of_empty_rows_ = 0;
+    ConstraintId number_of_duplicate_rows_ = 0;
+
+    static bool is_infinite(double bound) { return std::abs(bound) >= KN_INFINITY; }
+
+    /** Build a compressed index of the positions of keys. */
+    template <typename Key>
+    static void build_index(
+            std::size_t number_of_keys,
+            const std::vector<Key>& keys,
+            std::vector<std::size_t>& starts,
+            std::vector<std::size_t>& positions)
+    {
+        starts.assign(number_of_keys + 1, 0);
+        for (Key key: keys)
+            starts[key + 1]++;
+        for (std::size_t key = 0; key < number_of_keys; ++key)
+            starts[key + 1] += starts[key];
+        positions.resize(keys.size());
+        std::vector<std::size_t> next(starts.begin(), starts.end() - 1);
+        for (std::size_t pos = 0; pos < keys.size(); ++pos)
+            positions[next[keys[pos]]++] = pos;
+    }
+
+    /** Build an index of the quadratic terms involving each variable. */
+    static void build_quadratic_index(
+            std::size_t number_of_variables,
+            const std::vector<VariableId>& variable_ids_1,
+            const std::vector<VariableId>& variable_ids_2,
+            std::vector<std::size_t>& starts,
+            std::vector<std::size_t>& positions)
+    {
+        std::vector<VariableId> keys;
+        std::vector<std::size_t> terms;
+        for (std::size_t pos = 0; pos < variable_ids_1.size(); ++pos) {
+            keys.push_back(variable_ids_1[pos]);
+            terms.push_back(pos);
+            if (variable_ids_2[pos] != variable_ids_1[pos]) {
+                keys.push_back(variable_ids_2[pos]);
+                terms.push_back(pos);
+            }
+        }
+        build_index(number_of_variables, keys, starts, positions);
+        for (std::size_t& position: positions)
+            position = terms[position];
+    }
+
+    void build_incidence()
+    {
+        const Model& model = *model_;
+        VariableId number_of_variables = model.number_of_variables();
+        ConstraintId number_of_constraints = model.number_of_constraints();
+        build_index(
+                number_of_constraints,
+                model.constraint_linear_constraint_ids,
+                constraint_linear_starts_,
+                constraint_linear_terms_);
+        build_index(
+                number_of_constraints,
+                model.constraint_quadratic_constraint_ids,
+                constraint_quadratic_starts_,
+                constraint_quadratic_terms_);
+        build_index(
+                number_of_variables,
+                model.constraint_linear_variable_ids,
+                variable_linear_starts_,
+                variable_linear_terms_);
+        build_quadratic_index(
+                number_of_variables,
+                model.constraint_quadratic_variable_ids_1,
+                model.constraint_quadratic_variable_ids_2,
+                variable_quadratic_starts_,
+                variable_quadratic_terms_);
+        build_quadratic_index(
+                number_of_variables,
+                model.objective_quadratic_variable_ids_1,
+                model.objective_quadratic_variable_ids_2,
+                variable_objective_quadratic_starts_,
+                variable_objective_quadratic_terms_);
+        objective_linear_coefficients_.assign(number_of_variables, 0.0);
+        for (std::size_t pos = 0; pos < model.objective_linear_variable_ids.size(); ++pos) {
+            objective_linear_coefficients_[model.objective_linear_variable_ids[pos]]
+                += model.objective_linear_coefficients[pos];
+        }
+    }
+
+    void add_scratch_term(
+            VariableId variable_id,
+            double coefficient)
+    {
+        if (!scratch_touched_[variable_id]) {
+            scratch_touched_[variable_id] = 1;
+            scratch_variable_ids_.push_back(variable_id);
+        }
+        scratch_coefficients_[variable_id] += coefficient;
+    }
+
+    /**
+     * Collect the scratch terms into a sorted vector of terms.
+     *
+     * Quadratic terms on two non-fixed variables are not collected.
+     */
+    void collect_scratch_terms(std::vector<std::pair<VariableId, double>>& terms)
+    {
+        terms.clear();
+        for (VariableId variable_id: scratch_variable_ids_) {
+            if (scratch_coefficients_[variable_id] != 0.0)
+                terms.push_back({variable_id, scratch_coefficients_[variable_id]});
+            scratch_coefficients_[variable_id] = 0.0;
+            scratch_touched_[variable_id] = 0;
+        }
+        scratch_variable_ids_.clear();
+        std::sort(terms.begin(), terms.end());
+    }
+
+    /** Substitute the fixed variables in a constraint. */
+    void analyze_row(
+            ConstraintId constraint_id,
+            RowAnalysis& analysis)
+    {
+        const Model& model = *model_;
+        analysis.constant = model.constraint_constants[constraint_id];
+        analysis.nonlinear = false;
+        for (std::size_t pos = constraint_linear_starts_[constraint_id];
+                pos < constraint_linear_starts_[constraint_id + 1];
+                ++pos) {
+            std::size_t term = constraint_linear_terms_[pos];
+            VariableId variable_id = model.constraint_linear_variable_ids[term];
+            double coefficient = model.constraint_linear_coefficients[term];
+            if (variable_fixed_[variable_id]) {
+                analysis.constant += coefficient * variable_values_[variable_id];
+            } else {
+                add_scratch_term(variable_id, coefficient);
+            }
+        }
+        for (std::size_t pos = constraint_quadratic_starts_[constraint_id];
+                pos < constraint_quadratic_starts_[constraint_id + 1];
+                ++pos) {
+            std::size_t term = constraint_quadratic_terms_[pos];
+            VariableId variable_id_1 = model.constraint_quadratic_variable_ids_1[term];
+            VariableId variable_id_2 = model.constraint_quadratic_variable_ids_2[term];
+            double coefficient = model.constraint_quadratic_coefficients[term];
+            substitute_quadratic_term(
+                    variable_id_1,
+                    variable_id_2,
+                    coefficient,
+                    analysis);
+        }
+        collect_scratch_terms(analysis.terms);
+    }
+
+    void substitute_quadratic_term(
+            VariableId variable_id_1,
+            VariableId variable_id_2,
+            double coefficient,
+            RowAnalysis& analysis)
+    {
+        bool fixed_1 = variable_fixed_[variable_id_1];
+        bool fixed_2 = variable_fixed_[variable_id_2];
+        if (fixed_1 && fixed_2) {
+            analysis.constant += coefficient
+                * variable_values_[variable_id_1]
+                * variable_values_[variable_id_2];
+        } else if (fixed_1) {
+            add_scratch_term(variable_id_2, coefficient * variable_values_[variable_id_1]);
+        } else if (fixed_2) {
+            add_scratch_term(variable_id_1, coefficient * variable_values_[variable_id_2]);
+        } else {
+            analysis.nonlinear = true;
+        }
+    }
+
+    /** Fix a variable whose bounds are equal. */
+    void fix_variable(VariableId variable_id)
+    {
+        double lower_bound = variable_lower_bounds_[variable_id];
+        double upper_bound = variable_upper_bounds_[variable_id];
+        variable_fixed_[variable_id] = 1;
+        variable_values_[variable_id] = (lower_bound == upper_bound)?
+            lower_bound: 0.5 * (lower_bound + upper_bound);
+        number_of_removed_variables_++;
+        postsolve_steps_.push_back({
+                PostsolveStepType::FixedVariable,
+                variable_id, -1, -1, 0.0, false, false});
+    }
+
+    bool can_be_fixed(VariableId variable_id) const
+    {
+        return !variable_fixed_[variable_id]
+            && !is_infinite(variable_lower_bounds_[variable_id])
+            && variable_upper_bounds_[variable_id] - variable_lower_bounds_[variable_id]
+            <= parameters_.tolerance;
+    }
+
+    /** Turn a singleton row into bounds; return true iff the row is removed. */
+    bool remove_singleton_row(
+            ConstraintId constraint_id,
+            const RowAnalysis& analysis)
+    {
+        VariableId variable_id = analysis.terms.front().first;
+        double coefficient = analysis.terms.front().second;
+        double lower_bound = constraint_lower_bounds_[constraint_id];
+        double upper_bound = constraint_upper_bounds_[constraint_id];
+        double implied_lower_bound = -KN_INFINITY;
+        double implied_upper_bound = KN_INFINITY;
+        if (coefficient > 0) {
+            if (!is_infinite(lower_bound))
+                implied_lower_bound = (lower_bound - analysis.constant) / coefficient;
+            if (!is_infinite(upper_bound))
+                implied_upper_bound = (upper_bound - analysis.constant) / coefficient;
+        } else {
+            if (!is_infinite(upper_bound))
+                implied_lower_bound = (upper_bound - analysis.constant) / coefficient;
+            if (!is_infinite(lower_bound))
+                implied_upper_bound = (lower_bound - analysis.constant) / coefficient;
+        }
+        if (model_->variable_types[variable_id] != KN_VARTYPE_CONTINUOUS) {
+            if (!is_infinite(implied_lower_bound))
+                implied_lower_bound = std::ceil(implied_lower_bound - parameters_.tolerance);
+            if (!is_infinite(implied_upper_bound))
+                implied_upper_bound = std::floor(implied_upper_bound + parameters_.tolerance);
+        }
+        double new_lower_bound = std::max(variable_lower_bounds_[variable_id], implied_lower_bound);
+        double new_upper_bound = std::min(variable_upper_bounds_[variable_id], implied_upper_bound);
+        if (new_lower_bound > new_upper_bound + parameters_.tolerance) {
+            infeasible_ = true;
+            return false;
+        }
+        bool implies_lower_bound = (implied_lower_bound > variable_lower_bounds_[variable_id]);
+        bool implies_upper_bound = (implied_upper_bound < variable_upper_bounds_[variable_id]);
+        variable_lower_bounds_[variable_id] = new_lower_bound;
+        variable_upper_bounds_[variable_id] = new_upper_bound;
+        constraint_removed_[constraint_id] = 1;
+        number_of_singleton_rows_++;
+        postsolve_steps_.push_back({
+                PostsolveStepType::SingletonRow,
+                variable_id,
+                constraint_id,
+                -1,
+                coefficient,
+                implies_lower_bound,
+                implies_upper_bound});
+        return true;
+    }
+
+    /** Fix variables and remove empty and singleton rows until nothing changes. */
+    void reduce()
+    {
+        const Model& model = *model_;
+        VariableId number_of_variables = model.number_of_variables();
+        ConstraintId number_of_constraints = model.number_of_constraints();
+
+        std::vector<ConstraintId> queue;
+        std::vector<char> queued(number_of_constraints, 1);
+        for (ConstraintId constraint_id = number_of_constraints - 1;
+                constraint_id >= 0;
+                --constraint_id) {
+            queue.push_back(constraint_id);
+        }
+        if (parameters_.remove_fixed_variables) {
+            for (VariableId variable_id = 0;
+                    variable_id < number_of_variables;
+                    ++variable_id) {
+                if (can_be_fixed(variable_id))
+                    fix_variable(variable_id);
+            }
+        }
+
+        RowAnalysis analysis;
+        while (!queue.empty() && !infeasible_) {
+            ConstraintId constraint_id = queue.back();
+            queue.pop_back();
+            queued[constraint_id] = 0;
+            if (constraint_removed_[constraint_id])
+                continue;
+            analyze_row(constraint_id, analysis);
+            if (analysis.nonlinear)
+                continue;
+
+            if (analysis.terms.empty()) {
+                if (!parameters_.remove_empty_rows)
+                    continue;
+                if (analysis.constant < constraint_lower_bounds_[constraint_id] - parameters_.tolerance
+                        || analysis.constant > constraint_upper_bounds_[constraint_id] + parameters_.tolerance) {
+                    infeasible_ = true;
+                    continue;
+                }
+                constraint_removed_[constraint_id] = 1;
+                number_of_empty_rows_++;
+                continue;
+            }
+
+            if (analysis.terms.size() != 1 || !parameters_.remove_singleton_rows)
+                continue;
+            if (!remove_singleton_row(constraint_id, analysis))
+                continue;
+            VariableId variable_id = analysis.terms.front().first;
+            if (!parameters_.remove_fixed_variables || !can_be_fixed(variable_id))
+                continue;
+            fix_variable(variable_id);
+            // The rows of the fixed variable may have become empty or singleton.
+            auto enqueue = [this, &queue, &queued](ConstraintId id)
+            {
+                if (!queued[id] && !constraint_removed_[id]) {
+                    queued[id] = 1;
+                    queue.push_back(id);
+                }
+            };
+            for (std::size_t pos = variable_linear_starts_[variable_id];
+                    pos < variable_linear_starts_[variable_id + 1];
+                    ++pos) {
+                enqueue(model.constraint_linear_constraint_ids[variable_linear_terms_[pos]]);
+            }
+            for (std::size_t pos = variable_quadratic_starts_[variable_id];
+                    pos < variable_quadratic_starts_[variable_id + 1];
+                    ++pos) {
+                enqueue(model.constraint_quadratic_constraint_ids[variable_quadratic_terms_[pos]]);
+            }
+        }
+
+        if (parameters_.remove_duplicate_rows && !infeasible_)
+            remove_duplicate_rows();
+    }
+
+    /** Merge the linear rows which are multiples of each other. */
+    void remove_duplicate_rows()
+    {
+        ConstraintId number_of_constraints = model_->number_of_constraints();
+        std::unordered_map<std::size_t, std::vector<ConstraintId>> buckets;
+        // Normalized terms, scale and constant of each candidate row.
+        std::vector<std::vector<std::pair<VariableId, double>>> normalized_terms(number_of_constraints);
+        std::vector<double> scales(number_of_constraints, 0.0);
+        std::vector<double> constants(number_of_constraints, 0.0);
+        RowAnalysis analysis;
+        for (ConstraintId constraint_id = 0;
+                constraint_id < number_of_constraints;
+                ++constraint_id) {
+            if (constraint_removed_[constraint_id])
+                continue;
+            analyze_row(constraint_id, analysis);
+            if (analysis.nonlinear || analysis.terms.size() < 2)
+                continue;
+
+            double scale = analysis.terms.front().second;
+            std::size_t hash = analysis.terms.size();
+            for (auto& term: analysis.terms) {
+                term.second /= scale;
+                // Round the coefficient so that nearly equal rows share a bucket.
+                double rounded_coefficient = std::round(term.second * 1e6);
+                std::uint64_t bits = 0;
+                std::memcpy(&bits, &rounded_coefficient, sizeof(bits));
+                hash ^= std::hash<VariableId>()(term.first) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+                hash ^= std::hash<std::uint64_t>()(bits) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+            }
+
+            std::vector<ConstraintId>& bucket = buckets[hash];
+            ConstraintId kept_constraint_id = -1;
+            for (ConstraintId candidate_constraint_id: bucket) {
+                if (same_terms(analysis.terms, normalized_terms[candidate_constraint_id])) {
+                    kept_constraint_id = candidate_constraint_id;
+                    break;
+                }
+            }
+            if (kept_constraint_id == -1) {
+                bucket.push_back(constraint_id);
+                normalized_terms[constraint_id] = analysis.terms;
+                scales[constraint_id] = scale;
+                constants[constraint_id] = analysis.constant;
+                continue;
+            }
+            if (merge_duplicate_row(
+                        constraint_id,
+                        scale,
+                        analysis.constant,
+                        kept_constraint_id,
+                        scales[kept_constraint_id],
+                        constants[kept_constraint_id])) {
+                constraint_removed_[constraint_id] = 1;
+                number_of_duplicate_rows_++;
+            }
+        }
+    }
+
+    bool same_terms(
+            const std::vector<std::pair<VariableId, double>>& terms_1,
+            const std::vector<std::pair<VariableId, double>>& terms_2) const
+    {
+        if (terms_1.size() != terms_2.size())
+            return false;
+        for (std::size_t pos = 0; pos < terms_1.size(); ++pos) {
+            if (terms_1[pos].first != terms_2[pos].first)
+                return false;
+            double difference = std::abs(terms_1[pos].second - terms_2[pos].second);
+            if (difference > parameters_.tolerance * std::max(1.0, std::abs(terms_1[pos].second)))
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Intersect the range of a duplicate row into the one of the kept row;
+     * return true iff the duplicate row can be removed.
+     *
+     * Both rows are written scale * y + constant where y is the common
+     * normalized linear part.
+     */
+    bool merge_duplicate_row(
+            ConstraintId constraint_id,
+            double scale,
+            double constant,
+            ConstraintId kept_constraint_id,
+            double kept_scale,
+            double kept_constant)
+    {
+        auto range = [](double lower_bound, double upper_bound, double s, double c)
+        {
+            double y_lower = -KN_INFINITY;
+            double y_upper = KN_INFINITY;
+            if (!is_infinite(lower_bound))
+                ((s > 0)? y_lower: y_upper) = (lower_bound - c) / s;
+            if (!is_infinite(upper_bound))
+                ((s > 0)? y_upper: y_lower) = (upper_bound - c) / s;
+            return std::make_pair(y_lower, y_upper);
+        };
+        auto kept_range = range(
+                constraint_lower_bounds_[kept_constraint_id],
+                constraint_upper_bounds_[kept_constraint_id],
+                kept_scale,
+                kept_constant);
+        auto removed_range = range(
+                constraint_lower_bounds_[constraint_id],
+                constraint_upper_bounds_[constraint_id],
+                scale,
+                constant);
+        double y_lower = std::max(kept_range.first, removed_range.first);
+        double y_upper = std::min(kept_range.second, removed_range.second);
+        if (y_lower > y_upper + parameters_.tolerance) {
+            infeasible_ = true;
+            return false;
+        }
+        bool tightens_y_lower = (removed_range.first > kept_range.first);
+        bool tightens_y_upper = (removed_range.second < kept_range.second);
+        if (tightens_y_lower)
+            ((kept_scale > 0)? constraint_lower_bounds_: constraint_upper_bounds_)[kept_constraint_id]
+                = kept_scale * y_lower + kept_constant;
+        if (tightens_y_upper)
+            ((kept_scale > 0)? constraint_upper_bounds_: constraint_lower_bounds_)[kept_constraint_id]
+                = kept_scale * y_upper + kept_constant;
+        postsolve_steps_.push_back({
+                PostsolveStepType::DuplicateRow,
+                -1,
+                constraint_id,
+                kept_constraint_id,
+                scale / kept_scale,
+                (kept_scale > 0)? tightens_y_lower: tightens_y_upper,
+                (kept_scale > 0)? tightens_y_upper: tightens_y_lower});
+        return true;
+    }
+
+    void build_reduced_model()
+    {
+        const Model& model = *model_;
+        VariableId number_of_variables = model.number_of_variables();
+        ConstraintId number_of_constraints = model.number_of_constraints();
+
+        reduced_variable_ids_.assign(number_of_variables, -1);
+        for (VariableId variable_id = 0;
+                variable_id < number_of_variables;
+                ++variable_id) {
+            if (variable_fixed_[variable_id])
+                continue;
+            reduced_variable_ids_[variable_id] = reduced_model_.add_var();
+            reduced_model_.variable_lower_bounds.back() = variable_lower_bounds_[variable_id];
+            reduced_model_.variable_upper_bounds.back() = variable_upper_bounds_[variable_id];
+            reduced_model_.variable_types.back() = model.variable_types[variable_id];
+        }
+
+        // Objective.
+        RowAnalysis analysis;
+        analysis.constant = model.objective_constant;
+        for (VariableId variable_id = 0;
+                variable_id < number_of_variables;
+                ++variable_id) {
+            double coefficient = objective_linear_coefficients_[variable_id];
+            if (coefficient == 0.0)
+                continue;
+            if (variable_fixed_[variable_id]) {
+                analysis.constant += coefficient * variable_values_[variable_id];
+            } else {
+                add_scratch_term(variable_id, coefficient);
+            }
+        }
+        for (std::size_t pos = 0; pos < model.objective_quadratic_variable_ids_1.size(); ++pos) {
+            VariableId variable_id_1 = model.objective_quadratic_variable_ids_1[pos];
+            VariableId variable_id_2 = model.objective_quadratic_variable_ids_2[pos];
+            if (!variable_fixed_[variable_id_1] && !variable_fixed_[variable_id_2]) {
+                reduced_model_.add_obj_quadratic_term(
+                        reduced_variable_ids_[variable_id_1],
+                        reduced_variable_ids_[variable_id_2],
+                        model.objective_quadratic_coefficients[pos]);
+            } else {
+                substitute_quadratic_term(
+                        variable_id_1,
+                        variable_id_2,
+                        model.objective_quadratic_coefficients[pos],
+                        analysis);
+            }
+        }
+        collect_scratch_terms(analysis.terms);
+        reduced_model_.objective_goal = model.objective_goal;
+        reduced_model_.objective_constant = analysis.constant;
+        for (const auto& term: analysis.terms)
+            reduced_model_.add_obj_linear_term(reduced_variable_ids_[term.first], term.second);
+
+        // Constraints.
+        reduced_constraint_ids_.assign(number_of_constraints, -1);
+        for (ConstraintId constraint_id = 0;
+                constraint_id < number_of_constraints;
+                ++constraint_id) {
+            if (constraint_removed_[constraint_id])
+                continue;
+            ConstraintId reduced_constraint_id = reduced_model_.add_con();
+            reduced_constraint_ids_[constraint_id] = reduced_constraint_id;
+            reduced_model_.constraint_lower_bounds.back() = constraint_lower_bounds_[constraint_id];
+            reduced_model_.constraint_upper_bounds.back() = constraint_upper_bounds_[constraint_id];
+            analyze_row(constraint_id, analysis);
+            reduced_model_.constraint_constants.back() = analysis.constant;
+            for (const auto& term: analysis.terms) {
+                reduced_model_.add_con_linear_term(
+                        reduced_constraint_id,
+                        reduced_variable_ids_[term.first],
+                        term.second);
+            }
+            if (!analysis.nonlinear)
+                continue;
+            for (std::size_t pos = constraint_quadratic_starts_[constraint_id];
+                    pos < constraint_quadratic_starts_[constraint_id + 1];
+                    ++pos) {
+                std::size_t term = constraint_quadratic_terms_[pos];
+                VariableId variable_id_1 = model.constraint_quadratic_variable_ids_1[term];
+                VariableId variable_id_2 = model.constraint_quadratic_variable_ids_2[term];
+                if (variable_fixed_[variable_id_1] || variable_fixed_[variable_id_2])
+                    continue;
+                reduced_model_.add_con_quadratic_term(
+                        reduced_constraint_id,
+                        reduced_variable_ids_[variable_id_1],
+                        reduced_variable_ids_[variable_id_2],
+                        model.constraint_quadratic_coefficients[term]);
+            }
+        }
+    }
+
+    /**
+     * Compute the derivative of the Lagrangian with respect to a variable,
+     * excluding its bound multiplier.
+     *
+     * Knitro minimizes -f for maximization problems.
+     */
+    double lagrangian_gradient(
+            VariableId variable_id,
+            const std::vector<double>& x,
+            const std::vector<double>& constraint_dual_values) const
+    {
+        const Model& model = *model_;
+        auto quadratic_derivative = [variable_id, &x](
+                VariableId variable_id_1,
+                VariableId variable_id_2,
+                double coefficient)
+        {
+            if (variable_id_1 == variable_id_2)
+                return 2 * coefficient * x[variable_id];
+            return coefficient * x[(variable_id_1 == variable_id)? variable_id_2: variable_id_1];
+        };
+
+        double objective_derivative = objective_linear_coefficients_[variable_id];
+        for (std::size_t pos = variable_objective_quadratic_starts_[variable_id];
+                pos < variable_objective_quadratic_starts_[variable_id + 1];
+                ++pos) {
+            std::size_t term = variable_objective_quadratic_terms_[pos];
+            objective_derivative += quadratic_derivative(
+                    model.objective_quadratic_variable_ids_1[term],
+                    model.objective_quadratic_variable_ids_2[term],
+                    model.objective_quadratic_coefficients[term]);
+        }
+        double derivative = (model.objective_goal == KN_OBJGOAL_MAXIMIZE)?
+            -objective_derivative: objective_derivative;
+        for (std::size_t pos = variable_linear_starts_[variable_id];
+                pos < variable_linear_starts_[variable_id + 1];
+                ++pos) {
+            std::size_t term = variable_linear_terms_[pos];
+            derivative += constraint_dual_values[model.constraint_linear_constraint_ids[term]]
+                * model.constraint_linear_coefficients[term];
+        }
+        for (std::size_t pos = variable_quadratic_starts_[variable_id];
+                pos < variable_quadratic_starts_[variable_id + 1];
+                ++pos) {
+            std::size_t term = variable_quadratic_terms_[pos];
+            derivative += constraint_dual_values[model.constraint_quadratic_constraint_ids[term]]
+                * quadratic_derivative(
+                        model.constraint_quadratic_variable_ids_1[term],
+                        model.constraint_quadratic_variable_ids_2[term],
+                        model.constraint_quadratic_coefficients[term]);
+        }
+        return derivative;
+    }
+
+};
+
+}
@@ -0,0 +1,293 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace knitrocpp
+{
+
+/**
+ * Structure for an evaluation of a trace file (see TraceRecorder).
+ */
+struct TraceRecord
+{
+    /** Callback type (0: function, 1: gradient, 2: Hessian, 3: Hessian-vector). */
+    std::uint8_t callback_type = 0;
+
+    /** Index of the evaluation callback. */
+    std::uint32_t callback_index = 0;
+
+    /** Request type (KN_RC_EVALFC, KN_RC_EVALGA...). */
+    std::int32_t request_type = 0;
+
+    /** Return code of the callback. */
+    std::int32_t return_code = 0;
+
+    /** Weight of the objective in the Lagrangian. */
+    double sigma = 0.0;
+
+    /** Inputs. */
+    std::vector<double> x;
+    std::vector<double> lambda;
+    std::vector<double> vec;
+
+    /** Outputs (obj and c, objGrad and jac, hess, or hessVec). */
+    std::vector<double> output_1;
+    std::vector<double> output_2;
+};
+
+/**
+ * Structure for the output of a replay.
+ */
+struct TraceReplayOutput
+{
+    /** Timings of the callbacks during the replay. */
+    CallbackTimings timings;
+
+    /** Number of evaluations replayed. */
+    std::uint64_t number_of_evaluations = 0;
+
+    /** Number of evaluations whose outputs differ from the trace. */
+    std::uint64_t number_of_mismatches = 0;
+
+    /** Largest difference between a replayed and a recorded output. */
+    double maximum_difference = 0.0;
+
+    /** Position in the trace of the first mismatch, -1 if none. */
+    std::int64_t first_mismatch = -1;
+};
+
+/**
+ * Class for replaying a trace file recorded with Context::start_trace.
+ *
+ * The callbacks of the traced model are registered in the order in which
+ * they were added to the context, then each recorded evaluation request is
+ * sent again to the user callbacks, without Knitro. The callbacks receive
+ * a context without underlying Knitro context and a null callback context,
+ * so they must not query Knitro. It can be used to profile the callbacks or
+ * to check that they are deterministic.
+ */
+class TraceReplay
+{
+
+public:
+
+    /** Constructor. */
+    TraceReplay(const std::string& filename)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file)
+            throw std::runtime_error("KnitroCpp error: unable to open trace file '" + filename + "'.");
+        char magic[4];
+        std::int64_t header[2];
+        file.read(magic, 4);
+        file.read((char*)header, sizeof(header));
+        if (!file || std::memcmp(magic, "KNTR", 4) != 0)
+            throw std::runtime_error("KnitroCpp error: invalid trace file '" + filename + "'.");
+        number_of_variables_ = header[0];
+        number_of_constraints_ = header[1];
+        for (;;) {
+            TraceRecord record;
+            file.read((char*)&record.callback_type, sizeof(record.callback_type));
+            if (file.gcount() == 0)
+                break;
+            file.read((char*)&record.callback_index, sizeof(record.callback_index));
+            file.read((char*)&record.request_type, sizeof(record.request_type));
+            file.read((char*)&record.return_code, sizeof(record.return_code));
+            file.read((char*)&record.sigma, sizeof(record.sigma));
+            for (std::vector<double>* array: {
+                    &record.x,
+                    &record.lambda,
+                    &record.vec,
+                    &record.output_1,
+                    &record.output_2}) {
+                std::uint64_t size = 0;
+                file.read((char*)&size, sizeof(size));
+                array->resize(size);
+                file.read((char*)array->data(), size * sizeof(double));
+            }
+            if (!file)
+                throw std::runtime_error("KnitroCpp error: truncated trace file '" + filename + "'.");
+            records_.push_back(std::move(record));
+        }
+    }
+
+    /** Get the number of variables. */
+    VariableId number_of_variables() const { return number_of_variables_; }
+
+    /** Get the number of constraints. */
+    ConstraintId number_of_constraints() const { return number_of_constraints_; }
+
+    /** Get the records. */
+    const std::vector<TraceRecord>& records() const { return records_; }
+
+    /**
+     * Add the callbacks of an evaluation callback of the traced model.
+     *
+     * They must be added in the same order as the evaluation callbacks of
+     * the traced context, least squares callbacks excluded.
+     */
+    void add_eval_callback(
+            Context::EvalCallback eval_callback,
+            Context::EvalCallback gradient_callback = nullptr,
+            Context::EvalCallback hessian_callback = nullptr,
+            Context::HessianVectorCallback hessian_vector_callback = nullptr)
+    {
+        callbacks_.push_back({
+                eval_callback,
+                gradient_callback,
+                hessian_callback,
+                hessian_vector_callback});
+    }
+
+    /**
+     * Replay the trace.
+     *
+     * An evaluation is a mismatch if its return code differs from the
+     * recorded one or if one of its outputs differs from the recorded value
+     * by more than tolerance * max(1, |recorded value|).
+     */
+    TraceReplayOutput run(
+            double tolerance = 0.0,
+            int number_of_repetitions = 1)
+    {
+        TraceReplayOutput output;
+        Context knitro_context(nullptr);
+        CallbackTiming* timings[4] = {
+            &output.timings.function,
+            &output.timings.gradient,
+            &output.timings.hessian,
+            &output.timings.hessian_vector};
+        std::vector<double> output_1;
+        std::vector<double> output_2;
+        for (int repetition = 0; repetition < number_of_repetitions; ++repetition) {
+            for (std::size_t pos = 0; pos < records_.size(); ++pos) {
+                const TraceRecord& record = records_[pos];
+                if (record.callback_index >= callbacks_.size() || record.callback_type > 3) {
+                    throw std::runtime_error(
+                            "KnitroCpp error: no callback registered for record "
+                            + std::to_string(pos) + " of the trace.");
+                }
+                const Callbacks& callbacks = callbacks_[record.callback_index];
+                output_1.assign(record.output_1.size(), 0.0);
+                output_2.assign(record.output_2.size(), 0.0);
+                KN_eval_request eval_request = {};
+                eval_request.type = record.request_type;
+                eval_request.x = record.x.data();
+                eval_request.lambda = record.lambda.data();
+                eval_request.sigma = &record.sigma;
+                eval_request.vec = record.vec.data();
+                KN_eval_result eval_result = {};
+                if (!function_is_set(callbacks, record.callback_type)) {
+                    throw std::runtime_error(
+                            "KnitroCpp error: missing callback for record "
+                            + std::to_string(pos) + " of the trace.");
+                }
+
+                // Knitro always passes an objective value, even to a
+                // callback that only evaluates constraints.
+                double objective = 0.0;
+                int return_code = 0;
+                auto start = std::chrono::steady_clock::now();
+                switch (record.callback_type) {
+                case 0: {
+                    eval_result.obj = (output_1.empty())? &objective: output_1.data();
+                    eval_result.c = output_2.data();
+                    return_code = callbacks.eval_callback(
+                            knitro_context, nullptr, &eval_request, &eval_result);
+                    break;
+                } case 1: {
+                    eval_result.objGrad = output_1.data();
+                    eval_result.jac = output_2.data();
+                    return_code = callbacks.gradient_callback(
+                            knitro_context, nullptr, &eval_request, &eval_result);
+                    break;
+                } case 2: {
+                    eval_result.hess = output_1.data();
+                    return_code = callbacks.hessian_callback(
+                            knitro_context, nullptr, &eval_request, &eval_result);
+                    break;
+                } case 3: {
+                    return_code = callbacks.hessian_vector_callback(
+                            knitro_context, nullptr,
+                            record.x.data(), record.lambda.data(), record.sigma,
+                            record.vec.data(), output_1.data());
+                    break;
+                }
+                }
+                double time = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+                timings[record.callback_type]->number_of_evaluations++;
+                timings[record.callback_type]->time += time;
+                output.number_of_evaluations++;
+
+                bool mismatch = (return_code != record.return_code);
+                if (return_code == 0) {
+                    for (int array = 0; array < 2; ++array) {
+                        const std::vector<double>& values = (array == 0)? output_1: output_2;
+                        const std::vector<double>& recorded = (array == 0)? record.output_1: record.output_2;
+                        for (std::size_t value_pos = 0; value_pos < values.size(); ++value_pos) {
+                            double difference = std::abs(values[value_pos] - recorded[value_pos]);
+                            if (std::isnan(values[value_pos]) != std::isnan(recorded[value_pos]))
+                                difference = std::numeric_limits<double>::infinity();
+                            else if (std::isnan(difference))
+                                difference = 0.0;
+                            output.maximum_difference = std::max(output.maximum_difference, difference);
+                            if (difference > tolerance * std::max(1.0, std::abs(recorded[value_pos])))
+                                mismatch = true;
+                        }
+                    }
+                }
+                if (mismatch) {
+                    output.number_of_mismatches++;
+                    if (output.first_mismatch == -1)
+                        output.first_mismatch = pos;
+                }
+            }
+        }
+        return output;
+    }
+
+private:
+
+    /** Structure for the callbacks of an evaluation callback. */
+    struct Callbacks
+    {
+        Context::EvalCallback eval_callback;
+        Context::EvalCallback gradient_callback;
+        Context::EvalCallback hessian_callback;
+        Context::HessianVectorCallback hessian_vector_callback;
+    };
+
+    /** Check if the callback of a type is set. */
+    static bool function_is_set(
+            const Callbacks& callbacks,
+            std::uint8_t callback_type)
+    {
+        switch (callback_type) {
+        case 0: return (bool)callbacks.eval_callback;
+        case 1: return (bool)callbacks.gradient_callback;
+        case 2: return (bool)callbacks.hessian_callback;
+        default: return (bool)callbacks.hessian_vector_callback;
+        }
+    }
+
+    /** Number of variables. */
+    VariableId number_of_variables_ = 0;
+
+    /** Number of constraints. */
+    ConstraintId number_of_constraints_ = 0;
+
+    /** Records. */
+    std::vector<TraceRecord> records_;
+
+    /** Callbacks. */
+    std::vector<Callbacks> callbacks_;
+
+};
+
+}
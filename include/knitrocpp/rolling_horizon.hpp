@@ -0,0 +1,265 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace knitrocpp
+{
+
+/**
+ * Class for re-solving a time-indexed model in a rolling-horizon (model
+ * predictive control) loop.
+ *
+ * The context is kept alive between cycles; before each cycle, the data of
+ * the new horizon is passed to the update methods, which compare it to the
+ * values pushed during the previous cycles and only send the entries that
+ * changed to Knitro. After each solve that returned a feasible point, the
+ * primal and dual solution is shifted by one period and set as initial
+ * point of the next solve: the values of period t + 1 become the initial
+ * values of period t, and the last period keeps its values. After a solve
+ * without feasible point, the initial point is left unchanged.
+ *
+ * Each period must have the same number of variables and the same number
+ * of constraints, listed in the same order.
+ */
+class RollingHorizon
+{
+
+public:
+
+    /** Constructor. */
+    RollingHorizon(
+            Context& knitro_context,
+            const std::vector<std::vector<VariableId>>& variable_ids_by_period,
+            const std::vector<std::vector<ConstraintId>>& constraint_ids_by_period = {},
+            std::size_t latency_window_size = 1024):
+        knitro_context_(knitro_context),
+        variable_ids_by_period_(variable_ids_by_period),
+        constraint_ids_by_period_(constraint_ids_by_period),
+        latencies_((std::max)(latency_window_size, (std::size_t)1)) { }
+
+    /** Get the context. */
+    Context& context() { return knitro_context_; }
+
+    /**
+     * Update the bounds of a subset of variables.
+     *
+     * Only the bounds that differ from the ones set through this method
+     * during the previous cycles are sent to Knitro.
+     *
+     * Return the number of bounds sent.
+     */
+    std::size_t update_var_bounds(
+            const std::vector<VariableId>& variable_ids,
+            const std::vector<double>& lower_bounds,
+            const std::vector<double>& upper_bounds)
+    {
+        std::size_t number_of_changes = 0;
+        diff(variable_ids, lower_bounds, variable_lower_bounds_, changed_ids_, changed_values_);
+        if (!changed_ids_.empty())
+            knitro_context_.set_var_lobnds(changed_ids_, changed_values_);
+        number_of_changes += changed_ids_.size();
+        diff(variable_ids, upper_bounds, variable_upper_bounds_, changed_ids_, changed_values_);
+        if (!changed_ids_.empty())
+            knitro_context_.set_var_upbnds(changed_ids_, changed_values_);
+        number_of_changes += changed_ids_.size();
+        return number_of_changes;
+    }
+
+    /**
+     * Update the constant terms of a subset of constraints.
+     *
+     * Only the constants that differ from the ones set through this method
+     * during the previous cycles are sent to Knitro.
+     *
+     * Return the number of constants sent.
+     */
+    std::size_t update_con_constants(
+            const std::vector<ConstraintId>& constraint_ids,
+            const std::vector<double>& constants)
+    {
+        diff(constraint_ids, constants, constraint_constants_, changed_ids_, changed_values_);
+        if (!changed_ids_.empty())
+            knitro_context_.chg_con_constants(changed_ids_, changed_values_);
+        return changed_ids_.size();
+    }
+
+    /**
+     * Solve the model of the current horizon, and shift the solution into
+     * the initial point of the next cycle if it is feasible.
+     */
+    int solve()
+    {
+        auto start = std::chrono::steady_clock::now();
+        int status = knitro_context_.solve();
+        last_solve_shifted_ = is_feasible(status);
+        if (last_solve_shifted_)
+            shift();
+        latencies_[number_of_cycles_ % latencies_.size()] = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+        number_of_cycles_++;
+        return status;
+    }
+
+    /** Shift the last solution by one period into the initial point. */
+    void shift()
+    {
+        std::vector<double> primal_values = knitro_context_.get_var_primal_values();
+        std::vector<double> variable_dual_values = knitro_context_.get_var_dual_values();
+        std::vector<double> constraint_dual_values = knitro_context_.get_con_dual_values();
+        shift(variable_ids_by_period_, primal_values);
+        shift(variable_ids_by_period_, variable_dual_values);
+        shift(constraint_ids_by_period_, constraint_dual_values);
+        knitro_context_.set_var_primal_init_values(primal_values);
+        knitro_context_.set_var_dual_init_values(variable_dual_values);
+        knitro_context_.set_con_dual_init_values(constraint_dual_values);
+    }
+
+    /**
+     * Return true iff the solution of the last solve has been shifted into
+     * the initial point.
+     */
+    bool last_solve_shifted() const { return last_solve_shifted_; }
+
+    /** Get the number of cycles solved. */
+    std::size_t number_of_cycles() const { return number_of_cycles_; }
+
+    /**
+     * Get the latencies of the last cycles (solve and shift), in seconds,
+     * from the oldest to the most recent.
+     *
+     * Only the cycles of the latency window are kept.
+     */
+    std::vector<double> latencies() const
+    {
+        std::vector<double> latencies;
+        std::size_t number_of_latencies = (std::min)(number_of_cycles_, latencies_.size());
+        for (std::size_t cycle = number_of_cycles_ - number_of_latencies;
+                cycle < number_of_cycles_;
+                ++cycle) {
+            latencies.push_back(latencies_[cycle % latencies_.size()]);
+        }
+        return latencies;
+    }
+
+    /**
+     * Get a percentile (between 0 and 100) of the latencies of the cycles of
+     * the latency window, in seconds.
+     */
+    double latency_percentile(double percentile) const
+    {
+        if (number_of_cycles_ == 0)
+            return 0.0;
+        std::vector<double> latencies = this->latencies();
+        std::size_t position = (std::min)(
+                (std::size_t)(percentile / 100.0 * latencies.size()),
+                latencies.size() - 1);
+        std::nth_element(
+                latencies.begin(),
+                latencies.begin() + position,
+                latencies.end());
+        return latencies[position];
+    }
+
+private:
+
+    /** Context. */
+    Context& knitro_context_;
+
+    /** Variables of each period. */
+    std::vector<std::vector<VariableId>> variable_ids_by_period_;
+
+    /** Constraints of each period. */
+    std::vector<std::vector<ConstraintId>> constraint_ids_by_period_;
+
+    /** Ring buffer of the latencies of the last cycles. */
+    std::vector<double> latencies_;
+
+    /** Number of cycles solved. */
+    std::size_t number_of_cycles_ = 0;
+
+    /** Boolean indicating if the last solution has been shifted. */
+    bool last_solve_shifted_ = false;
+
+    /** Lower bounds of the variables sent to Knitro (NaN if never sent). */
+    std::vector<double> variable_lower_bounds_;
+
+    /** Upper bounds of the variables sent to Knitro (NaN if never sent). */
+    std::vector<double> variable_upper_bounds_;
+
+    /** Constants of the constraints sent to Knitro (NaN if never sent). */
+    std::vector<double> constraint_constants_;
+
+    /** Buffers for the entries that changed. */
+    std::vector<KNINT> changed_ids_;
+    std::vector<double> changed_values_;
+
+    /**
+     * Compare values to the cached ones, update the cache and collect the
+     * entries that changed.
+     */
+    template <typename Id>
+    static void diff(
+            const std::vector<Id>& ids,
+            const std::vector<double>& values,
+            std::vector<double>& cached_values,
+            std::vector<KNINT>& changed_ids,
+            std::vector<double>& changed_values)
+    {
+        if (ids.size() != values.size()) {
+            throw std::runtime_error(
+                    "KnitroCpp error: the number of values does not match the number of ids.");
+        }
+        changed_ids.clear();
+        changed_values.clear();
+        for (std::size_t pos = 0; pos < ids.size(); ++pos) {
+            Id id = ids[pos];
+            if ((std::size_t)id >= cached_values.size()) {
+                cached_values.resize(
+                        id + 1,
+                        std::numeric_limits<double>::quiet_NaN());
+            }
+            // A NaN cached value never compares equal, so it is always sent.
+            if (cached_values[id] == values[pos])
+                continue;
+            cached_values[id] = values[pos];
+            changed_ids.push_back(id);
+            changed_values.push_back(values[pos]);
+        }
+    }
+
+    /**
+     * Return true iff a return status of solve() comes with a feasible
+     * point: 0 (optimal), -100 to -199 (feasible) and -400 to -409 (limit
+     * reached with a feasible point).
+     */
+    static bool is_feasible(int status)
+    {
+        return (status == 0)
+            || (status <= -100 && status >= -199)
+            || (status <= -400 && status >= -409);
+    }
+
+    /** Shift values indexed by element ids by one period. */
+    template <typename Id>
+    static void shift(
+            const std::vector<std::vector<Id>>& ids_by_period,
+            std::vector<double>& values)
+    {
+        for (std::size_t period = 0; period + 1 < ids_by_period.size(); ++period) {
+            const std::vector<Id>& ids = ids_by_period[period];
+            const std::vector<Id>& next_ids = ids_by_period[period + 1];
+            for (std::size_t pos = 0; pos < ids.size(); ++pos)
+                values[ids[pos]] = values[next_ids[pos]];
+        }
+    }
+
+};
+
+}
@@ -0,0 +1,298 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace knitrocpp
+{
+
+/**
+ * Structure for the parameters of a scaling.
+ */
+struct ScalingParameters
+{
+    /** Number of alternating row/column passes. */
+    int number_of_iterations = 8;
+
+    /** Round the scaling factors to powers of 2 to avoid rounding errors. */
+    bool round_to_power_of_two = true;
+
+    /** Bounds on the scaling factors. */
+    double minimum_factor = 1e-8;
+    double maximum_factor = 1e8;
+
+    /** Scale the objective. */
+    bool scale_objective = true;
+};
+
+/**
+ * Structure for the range of the absolute values of a set of coefficients.
+ */
+struct CoefficientRange
+{
+    /** Smallest nonzero absolute value. */
+    double minimum = std::numeric_limits<double>::infinity();
+
+    /** Largest absolute value. */
+    double maximum = 0.0;
+
+    /** Add a coefficient. */
+    void add(double value)
+    {
+        value = std::abs(value);
+        if (value == 0.0)
+            return;
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
+
+    /** Get the ratio between the largest and the smallest value. */
+    double ratio() const { return (maximum == 0.0)? 1.0: maximum / minimum; }
+};
+
+/**
+ * Structure for the output of a scaling.
+ */
+struct ScalingOutput
+{
+    /** Scaling factors of the variables (x = factor * x_scaled). */
+    std::vector<double> variable_factors;
+
+    /** Scaling factors of the constraints (c_scaled = factor * c). */
+    std::vector<double> constraint_factors;
+
+    /** Scaling factor of the objective. */
+    double objective_factor = 1.0;
+
+    /** Range of the Jacobian coefficients before and after scaling. */
+    CoefficientRange jacobian_range_before;
+    CoefficientRange jacobian_range_after;
+
+    /** Range of the objective gradient coefficients before and after scaling. */
+    CoefficientRange objective_range_before;
+    CoefficientRange objective_range_after;
+};
+
+/**
+ * Compute geometric-mean scaling factors for a sparse matrix.
+ *
+ * Rows and columns are alternately scaled by the inverse of the geometric
+ * mean of their smallest and largest scaled entries, which reduces the
+ * spread of the magnitudes of the entries.
+ */
+inline void compute_geometric_mean_scaling(
+        std::size_t number_of_rows,
+        std::size_t number_of_columns,
+        const std::vector<std::size_t>& row_ids,
+        const std::vector<std::size_t>& column_ids,
+        const std::vector<double>& values,
+        const ScalingParameters& parameters,
+        std::vector<double>& row_factors,
+        std::vector<double>& column_factors)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    row_factors.assign(number_of_rows, 1.0);
+    column_factors.assign(number_of_columns, 1.0);
+    std::vector<double> minimums;
+    std::vector<double> maximums;
+    auto clamp = [&parameters](double factor)
+    {
+        return std::max(parameters.minimum_factor, std::min(parameters.maximum_factor, factor));
+    };
+    for (int iteration = 0; iteration < parameters.number_of_iterations; ++iteration) {
+        // Rows.
+        minimums.assign(number_of_rows, infinity);
+        maximums.assign(number_of_rows, 0.0);
+        for (std::size_t pos = 0; pos < values.size(); ++pos) {
+            double value = std::abs(values[pos]) * column_factors[column_ids[pos]];
+            if (value == 0.0)
+                continue;
+            minimums[row_ids[pos]] = std::min(minimums[row_ids[pos]], value);
+            maximums[row_ids[pos]] = std::max(maximums[row_ids[pos]], value);
+        }
+        for (std::size_t row_id = 0; row_id < number_of_rows; ++row_id) {
+            if (maximums[row_id] > 0.0)
+                row_factors[row_id] = clamp(1.0 / std::sqrt(minimums[row_id] * maximums[row_id]));
+        }
+
+        // Columns.
+        minimums.assign(number_of_columns, infinity);
+        maximums.assign(number_of_columns, 0.0);
+        for (std::size_t pos = 0; pos < values.size(); ++pos) {
+            double value = std::abs(values[pos]) * row_factors[row_ids[pos]];
+            if (value == 0.0)
+                continue;
+            minimums[column_ids[pos]] = std::min(minimums[column_ids[pos]], value);
+            maximums[column_ids[pos]] = std::max(maximums[column_ids[pos]], value);
+        }
+        for (std::size_t column_id = 0; column_id < number_of_columns; ++column_id) {
+            if (maximums[column_id] > 0.0)
+                column_factors[column_id] = clamp(1.0 / std::sqrt(minimums[column_id] * maximums[column_id]));
+        }
+    }
+    if (parameters.round_to_power_of_two) {
+        for (double& factor: row_factors)
+            factor = std::exp2(std::round(std::log2(factor)));
+        for (double& factor: column_factors)
+            factor = std::exp2(std::round(std::log2(factor)));
+    }
+}
+
+/**
+ * Compute and set scaling factors for the variables, the constraints and
+ * the objective of a context from its structure mirror (see
+ * Context::enable_structure_mirror), before solve().
+ *
+ * The Jacobian used to compute the factors contains the linear
+ * coefficients and the quadratic coefficients. If a point x is given (for
+ * example the initial point), the quadratic terms are evaluated at x and
+ * the gradient callbacks are sampled at x; otherwise, the parts of the
+ * model evaluated by callbacks are ignored.
+ */
+inline ScalingOutput apply_scaling(
+        Context& knitro_context,
+        const ScalingParameters& parameters = ScalingParameters(),
+        const std::vector<double>& x = {})
+{
+    const Model& model = knitro_context.structure_mirror();
+    VariableId number_of_variables = model.number_of_variables();
+    ConstraintId number_of_constraints = model.number_of_constraints();
+
+    // Collect the Jacobian and objective gradient entries.
+    std::vector<std::size_t> jacobian_row_ids;
+    std::vector<std::size_t> jacobian_column_ids;
+    std::vector<double> jacobian_values;
+    std::vector<std::size_t> objective_column_ids;
+    std::vector<double> objective_values;
+    auto magnitude = [&x](VariableId variable_id)
+    {
+        return (x.empty())? 1.0: std::max(1.0, std::abs(x[variable_id]));
+    };
+    for (std::size_t pos = 0; pos < model.constraint_linear_constraint_ids.size(); ++pos) {
+        jacobian_row_ids.push_back(model.constraint_linear_constraint_ids[pos]);
+        jacobian_column_ids.push_back(model.constraint_linear_variable_ids[pos]);
+        jacobian_values.push_back(model.constraint_linear_coefficients[pos]);
+    }
+    for (std::size_t pos = 0; pos < model.constraint_quadratic_constraint_ids.size(); ++pos) {
+        VariableId variable_id_1 = model.constraint_quadratic_variable_ids_1[pos];
+        VariableId variable_id_2 = model.constraint_quadratic_variable_ids_2[pos];
+        double coefficient = model.constraint_quadratic_coefficients[pos];
+        jacobian_row_ids.push_back(model.constraint_quadratic_constraint_ids[pos]);
+        jacobian_column_ids.push_back(variable_id_1);
+        if (variable_id_2 == variable_id_1) {
+            // d(q x^2) / dx = 2 q x.
+            jacobian_values.push_back(2 * coefficient * magnitude(variable_id_1));
+        } else {
+            jacobian_values.push_back(coefficient * magnitude(variable_id_2));
+            jacobian_row_ids.push_back(model.constraint_quadratic_constraint_ids[pos]);
+            jacobian_column_ids.push_back(variable_id_2);
+            jacobian_values.push_back(coefficient * magnitude(variable_id_1));
+        }
+    }
+    for (std::size_t pos = 0; pos < model.objective_linear_variable_ids.size(); ++pos) {
+        objective_column_ids.push_back(model.objective_linear_variable_ids[pos]);
+        objective_values.push_back(model.objective_linear_coefficients[pos]);
+    }
+    for (std::size_t pos = 0; pos < model.objective_quadratic_variable_ids_1.size(); ++pos) {
+        VariableId variable_id_1 = model.objective_quadratic_variable_ids_1[pos];
+        VariableId variable_id_2 = model.objective_quadratic_variable_ids_2[pos];
+        double coefficient = model.objective_quadratic_coefficients[pos];
+        objective_column_ids.push_back(variable_id_1);
+        if (variable_id_2 == variable_id_1) {
+            objective_values.push_back(2 * coefficient * magnitude(variable_id_1));
+        } else {
+            objective_values.push_back(coefficient * magnitude(variable_id_2));
+            objective_column_ids.push_back(variable_id_2);
+            objective_values.push_back(coefficient * magnitude(variable_id_1));
+        }
+    }
+    if (!x.empty()) {
+        std::vector<VariableId> objgrad_variable_ids;
+        std::vector<double> objgrad_values;
+        std::vector<ConstraintId> callback_constraint_ids;
+        std::vector<VariableId> callback_variable_ids;
+        std::vector<double> callback_values;
+        knitro_context.evaluate_callback_gradients(
+                x,
+                objgrad_variable_ids,
+                objgrad_values,
+                callback_constraint_ids,
+                callback_variable_ids,
+                callback_values);
+        objective_column_ids.insert(
+                objective_column_ids.end(),
+                objgrad_variable_ids.begin(),
+                objgrad_variable_ids.end());
+        objective_values.insert(
+                objective_values.end(),
+                objgrad_values.begin(),
+                objgrad_values.end());
+        jacobian_row_ids.insert(
+                jacobian_row_ids.end(),
+                callback_constraint_ids.begin(),
+                callback_constraint_ids.end());
+        jacobian_column_ids.insert(
+                jacobian_column_ids.end(),
+                callback_variable_ids.begin(),
+                callback_variable_ids.end());
+        jacobian_values.insert(
+                jacobian_values.end(),
+                callback_values.begin(),
+                callback_values.end());
+    }
+
+    ScalingOutput output;
+    compute_geometric_mean_scaling(
+            number_of_constraints,
+            number_of_variables,
+            jacobian_row_ids,
+            jacobian_column_ids,
+            jacobian_values,
+            parameters,
+            output.constraint_factors,
+            output.variable_factors);
+
+    // The objective is scaled by the inverse geometric mean of its scaled
+    // gradient entries.
+    for (std::size_t pos = 0; pos < objective_values.size(); ++pos) {
+        output.objective_range_before.add(objective_values[pos]);
+        output.objective_range_after.add(
+                objective_values[pos] * output.variable_factors[objective_column_ids[pos]]);
+    }
+    if (parameters.scale_objective && output.objective_range_after.maximum > 0.0) {
+        double factor = 1.0 / std::sqrt(
+                output.objective_range_after.minimum
+                * output.objective_range_after.maximum);
+        factor = std::max(parameters.minimum_factor, std::min(parameters.maximum_factor, factor));
+        if (parameters.round_to_power_of_two)
+            factor = std::exp2(std::round(std::log2(factor)));
+        output.objective_factor = factor;
+        CoefficientRange objective_range_after;
+        for (std::size_t pos = 0; pos < objective_values.size(); ++pos) {
+            objective_range_after.add(
+                    factor
+                    * objective_values[pos]
+                    * output.variable_factors[objective_column_ids[pos]]);
+        }
+        output.objective_range_after = objective_range_after;
+    }
+    for (std::size_t pos = 0; pos < jacobian_values.size(); ++pos) {
+        output.jacobian_range_before.add(jacobian_values[pos]);
+        output.jacobian_range_after.add(
+                output.constraint_factors[jacobian_row_ids[pos]]
+                * jacobian_values[pos]
+                * output.variable_factors[jacobian_column_ids[pos]]);
+    }
+
+    if (number_of_variables > 0)
+        knitro_context.set_var_scalings(output.variable_factors);
+    if (number_of_constraints > 0)
+        knitro_context.set_con_scalings(output.constraint_factors);
+    if (parameters.scale_objective)
+        knitro_context.set_obj_scaling(output.objective_factor);
+    return output;
+}
+
+}
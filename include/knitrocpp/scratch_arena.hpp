@@ -0,0 +1,186 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace knitrocpp
+{
+
+/**
+ * Class for a bump allocator handing out temporary memory to evaluation
+ * callbacks.
+ *
+ * All the memory is released at once by reset(). If an evaluation needed
+ * more than one chunk, reset() replaces them by a single chunk sized from
+ * the high-water mark, so that subsequent evaluations do not allocate.
+ */
+class ScratchArena
+{
+
+public:
+
+    /**
+     * Allocate an uninitialized array of number_of_elements elements of
+     * type T.
+     */
+    template <typename T>
+    T* allocate(std::size_t number_of_elements)
+    {
+        std::size_t size = number_of_elements * sizeof(T);
+        std::size_t offset = (offset_ + alignof(T) - 1) / alignof(T) * alignof(T);
+        if (chunks_.empty() || offset + size > chunks_.back().size) {
+            std::size_t chunk_size = (std::max)(
+                    (std::max)(size + alignof(T), (std::size_t)4096),
+                    (chunks_.empty())? 0: 2 * chunks_.back().size);
+            add_chunk(chunk_size);
+            offset = 0;
+        }
+        used_ = (used_ + alignof(T) - 1) / alignof(T) * alignof(T) + size;
+        high_water_mark_ = (std::max)(high_water_mark_, used_);
+        offset_ = offset + size;
+        return reinterpret_cast<T*>(chunks_.back().data.get() + offset);
+    }
+
+    /** Release all the memory allocated since the last reset. */
+    void reset()
+    {
+        if (chunks_.size() > 1) {
+            chunks_.clear();
+            add_chunk(high_water_mark_);
+        }
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    /** Get the largest number of bytes used between two resets. */
+    std::size_t high_water_mark() const { return high_water_mark_; }
+
+private:
+
+    struct Chunk
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    /** Chunks; allocations are made in the last one. */
+    std::vector<Chunk> chunks_;
+
+    /** Offset of the first free byte in the last chunk. */
+    std::size_t offset_ = 0;
+
+    /**
+     * Number of bytes that would have been used since the last reset if all
+     * allocations had been made in a single chunk.
+     */
+    std::size_t used_ = 0;
+
+    /** Largest number of bytes used between two resets. */
+    std::size_t high_water_mark_ = 0;
+
+    void add_chunk(std::size_t size)
+    {
+        Chunk chunk;
+        chunk.data = std::unique_ptr<char[]>(new char[size]);
+        chunk.size = size;
+        chunks_.push_back(std::move(chunk));
+    }
+
+};
+
+
+namespace detail
+{
+
+/**
+ * Scratch arenas of a callback, one per evaluating thread.
+ *
+ * The arenas are allocated once, when the callback is wrapped, and indexed
+ * by the thread identifier of the evaluation request, so that evaluating
+ * threads share nothing. Each arena is padded to its own cache lines.
+ * Threads with an identifier beyond the preallocated arenas get their own
+ * arena of this callback too, allocated on first use under a lock.
+ */
+struct ScratchArenas
+{
+    struct PaddedArena
+    {
+        ScratchArena arena;
+        char padding[64];
+    };
+
+    std::vector<PaddedArena> arenas = std::vector<PaddedArena>(
+            (std::max)(64u, std::thread::hardware_concurrency()));
+
+    /** Arenas of the other thread identifiers. */
+    std::unordered_map<int, std::unique_ptr<ScratchArena>> overflow_arenas;
+
+    /** Mutex protecting overflow_arenas. */
+    std::mutex overflow_mutex;
+
+    ScratchArena& get(int thread_id)
+    {
+        if (thread_id >= 0 && (std::size_t)thread_id < arenas.size())
+            return arenas[thread_id].arena;
+        std::lock_guard<std::mutex> lock(overflow_mutex);
+        std::unique_ptr<ScratchArena>& arena = overflow_arenas[thread_id];
+        if (arena == nullptr)
+            arena = std::unique_ptr<ScratchArena>(new ScratchArena());
+        return *arena;
+    }
+};
+
+/** Reset a scratch arena when leaving a scope, even by an exception. */
+struct ScratchArenaReset
+{
+    ScratchArena& arena;
+    ~ScratchArenaReset() { arena.reset(); }
+};
+
+}
+
+using ArenaEvalCallback = std::function<int(
+        const Context&,
+        CB_context_ptr,
+        KN_eval_request_ptr const,
+        KN_eval_result_ptr const,
+        ScratchArena&)>;
+
+/**
+ * Wrap an evaluation callback receiving a scratch arena into a regular
+ * evaluation callback.
+ *
+ * Each thread evaluating the callback gets its own arena, which is reset
+ * after each evaluation. The result can be passed to
+ * Context::add_eval_callback, Context::set_cb_grad or Context::set_cb_hess.
+ */
+inline Context::EvalCallback with_scratch_arenas(
+        ArenaEvalCallback callback_function)
+{
+    std::shared_ptr<detail::ScratchArenas> scratch_arenas(new detail::ScratchArenas());
+    return [scratch_arenas, callback_function](
+            const Context& knitro_context,
+            CB_context* callback_context,
+            KN_eval_request_ptr const eval_request,
+            KN_eval_result_ptr const eval_result)
+    {
+        ScratchArena& arena = scratch_arenas->get(eval_request->threadID);
+        detail::ScratchArenaReset reset{arena};
+        return callback_function(
+                knitro_context,
+                callback_context,
+                eval_request,
+                eval_result,
+                arena);
+    };
+}
+
+}
@@ -0,0 +1,549 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace knitrocpp
+{
+
+/** Append raw bytes to a buffer. */
+inline void serialize_bytes(
+        std::vector<char>& buffer,
+        const void* data,
+        std::size_t size)
+{
+    buffer.insert(buffer.end(), (const char*)data, (const char*)data + size);
+}
+
+/** Append a vector (its size, then its values) to a buffer. */
+template <typename T>
+void serialize_vector(
+        std::vector<char>& buffer,
+        const std::vector<T>& values)
+{
+    std::uint64_t size = values.size();
+    serialize_bytes(buffer, &size, sizeof(size));
+    serialize_bytes(buffer, values.data(), size * sizeof(T));
+}
+
+/** Read raw bytes from a buffer and advance the read position. */
+inline void deserialize_bytes(
+        const char*& data,
+        const char* end,
+        void* destination,
+        std::size_t size)
+{
+    if ((std::size_t)(end - data) < size)
+        throw std::runtime_error("KnitroCpp error: truncated serialized data.");
+    std::memcpy(destination, data, size);
+    data += size;
+}
+
+/** Read a vector written by serialize_vector and advance the read position. */
+template <typename T>
+void deserialize_vector(
+        const char*& data,
+        const char* end,
+        std::vector<T>& values)
+{
+    std::uint64_t size = 0;
+    deserialize_bytes(data, end, &size, sizeof(size));
+    if (size > (std::uint64_t)(end - data) / sizeof(T))
+        throw std::runtime_error("KnitroCpp error: truncated serialized data.");
+    values.resize(size);
+    deserialize_bytes(data, end, values.data(), size * sizeof(T));
+}
+
+/**
+ * Serialize a model into a contiguous buffer.
+ */
+inline std::vector<char> serialize_model(const Model& model)
+{
+    std::vector<char> buffer;
+    std::int32_t objective_goal = model.objective_goal;
+    serialize_bytes(buffer, "KNMD", 4);
+    serialize_bytes(buffer, &objective_goal, sizeof(objective_goal));
+    serialize_bytes(buffer, &model.objective_constant, sizeof(model.objective_constant));
+    serialize_vector(buffer, model.objective_linear_variable_ids);
+    serialize_vector(buffer, model.objective_linear_coefficients);
+    serialize_vector(buffer, model.objective_quadratic_variable_ids_1);
+    serialize_vector(buffer, model.objective_quadratic_variable_ids_2);
+    serialize_vector(buffer, model.objective_quadratic_coefficients);
+    serialize_vector(buffer, model.variable_lower_bounds);
+    serialize_vector(buffer, model.variable_upper_bounds);
+    serialize_vector(buffer, model.variable_types);
+    serialize_vector(buffer, model.constraint_lower_bounds);
+    serialize_vector(buffer, model.constraint_upper_bounds);
+    serialize_vector(buffer, model.constraint_constants);
+    serialize_vector(buffer, model.constraint_linear_constraint_ids);
+    serialize_vector(buffer, model.constraint_linear_variable_ids);
+    serialize_vector(buffer, model.constraint_linear_coefficients);
+    serialize_vector(buffer, model.constraint_quadratic_constraint_ids);
+    serialize_vector(buffer, model.constraint_quadratic_variable_ids_1);
+    serialize_vector(buffer, model.constraint_quadratic_variable_ids_2);
+    serialize_vector(buffer, model.constraint_quadratic_coefficients);
+    return buffer;
+}
+
+/**
+ * Deserialize a model written by serialize_model.
+ */
+inline Model deserialize_model(
+        const char* data,
+        std::size_t size)
+{
+    const char* end = data + size;
+    Model model;
+    char magic[4];
+    deserialize_bytes(data, end, magic, 4);
+    if (std::memcmp(magic, "KNMD", 4) != 0)
+        throw std::runtime_error("KnitroCpp error: invalid serialized model.");
+    std::int32_t objective_goal = 0;
+    deserialize_bytes(data, end, &objective_goal, sizeof(objective_goal));
+    model.objective_goal = objective_goal;
+    deserialize_bytes(data, end, &model.objective_constant, sizeof(model.objective_constant));
+    deserialize_vector(data, end, model.objective_linear_variable_ids);
+    deserialize_vector(data, end, model.objective_linear_coefficients);
+    deserialize_vector(data, end, model.objective_quadratic_variable_ids_1);
+    deserialize_vector(data, end, model.objective_quadratic_variable_ids_2);
+    deserialize_vector(data, end, model.objective_quadratic_coefficients);
+    deserialize_vector(data, end, model.variable_lower_bounds);
+    deserialize_vector(data, end, model.variable_upper_bounds);
+    deserialize_vector(data, end, model.variable_types);
+    deserialize_vector(data, end, model.constraint_lower_bounds);
+    deserialize_vector(data, end, model.constraint_upper_bounds);
+    deserialize_vector(data, end, model.constraint_constants);
+    deserialize_vector(data, end, model.constraint_linear_constraint_ids);
+    deserialize_vector(data, end, model.constraint_linear_variable_ids);
+    deserialize_vector(data, end, model.constraint_linear_coefficients);
+    deserialize_vector(data, end, model.constraint_quadratic_constraint_ids);
+    deserialize_vector(data, end, model.constraint_quadratic_variable_ids_1);
+    deserialize_vector(data, end, model.constraint_quadratic_variable_ids_2);
+    deserialize_vector(data, end, model.constraint_quadratic_coefficients);
+    return model;
+}
+
+/**
+ * Class for a POSIX shared memory segment.
+ *
+ * The creator owns the name of the segment and unlinks it on destruction;
+ * other processes attach to it from its name.
+ */
+class SharedMemorySegment
+{
+
+public:
+
+    /** Create a segment. */
+    SharedMemorySegment(
+            const std::string& name,
+            std::size_t size):
+        name_(name),
+        size_(size),
+        owner_(true)
+    {
+        int file_descriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (file_descriptor == -1)
+            throw std::runtime_error("KnitroCpp error: unable to create shared memory segment '" + name + "'.");
+        if (ftruncate(file_descriptor, size) != 0) {
+            close(file_descriptor);
+            shm_unlink(name.c_str());
+            throw std::runtime_error("KnitroCpp error: unable to resize shared memory segment '" + name + "'.");
+        }
+        map(file_descriptor, PROT_READ | PROT_WRITE);
+    }
+
+    /** Attach to an existing segment, read-only. */
+    explicit SharedMemorySegment(const std::string& name):
+        name_(name),
+        owner_(false)
+    {
+        int file_descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+        if (file_descriptor == -1)
+            throw std::runtime_error("KnitroCpp error: unable to open shared memory segment '" + name + "'.");
+        struct stat status;
+        if (fstat(file_descriptor, &status) != 0) {
+            close(file_descriptor);
+            throw std::runtime_error("KnitroCpp error: unable to open shared memory segment '" + name + "'.");
+        }
+        size_ = status.st_size;
+        map(file_descriptor, PROT_READ);
+    }
+
+    SharedMemorySegment(const SharedMemorySegment&) = delete;
+    SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+
+    /** Destructor. */
+    ~SharedMemorySegment()
+    {
+        if (data_ != nullptr)
+            munmap(data_, size_);
+        if (owner_)
+            shm_unlink(name_.c_str());
+    }
+
+    /** Get the name of the segment. */
+    const std::string& name() const { return name_; }
+
+    /** Get the size of the segment. */
+    std::size_t size() const { return size_; }
+
+    /** Get the data of the segment. */
+    char* data() const { return (char*)data_; }
+
+private:
+
+    void map(
+            int file_descriptor,
+            int protection)
+    {
+        data_ = (size_ == 0)? nullptr: mmap(nullptr, size_, protection, MAP_SHARED, file_descriptor, 0);
+        close(file_descriptor);
+        if (data_ == MAP_FAILED) {
+            data_ = nullptr;
+            if (owner_)
+                shm_unlink(name_.c_str());
+            throw std::runtime_error("KnitroCpp error: unable to map shared memory segment '" + name_ + "'.");
+        }
+    }
+
+    /** Name. */
+    std::string name_;
+
+    /** Size in bytes. */
+    std::size_t size_ = 0;
+
+    /** Boolean indicating if the segment has been created by this object. */
+    bool owner_;
+
+    /** Mapped data. */
+    void* data_ = nullptr;
+
+};
+
+/**
+ * Structure for a scenario of a solve farm, a patch of the bounds and of
+ * the initial point of the shared model.
+ */
+struct SolveFarmScenario
+{
+    /** Variable bounds of the scenario. */
+    std::vector<VariableId> variable_ids;
+    std::vector<double> variable_lower_bounds;
+    std::vector<double> variable_upper_bounds;
+
+    /** Constraint bounds of the scenario. */
+    std::vector<ConstraintId> constraint_ids;
+    std::vector<double> constraint_lower_bounds;
+    std::vector<double> constraint_upper_bounds;
+
+    /**
+     * Initial primal values of all variables.
+     *
+     * If empty, the initial point is not reset: the context of the worker
+     * keeps the initial values set for its previous scenario, and Knitro
+     * may warm start from its previous solve. Since the scenarios solved
+     * before by a worker are not deterministic, set the initial values of
+     * every scenario (or of none) for reproducible results.
+     */
+    std::vector<double> initial_primal_values;
+};
+
+/**
+ * Structure for the parameters of a solve farm.
+ */
+struct SolveFarmParameters
+{
+    /** Number of worker processes. */
+    unsigned number_of_processes = std::thread::hardware_concurrency();
+
+    /**
+     * Maximum number of replacements of the workers which terminate
+     * abnormally while scenarios remain.
+     */
+    unsigned maximum_number_of_restarts = 8;
+};
+
+/**
+ * Structure for the result of a scenario of a solve farm.
+ */
+struct SolveFarmResult
+{
+    /**
+     * Boolean indicating if the scenario has been processed; false if the
+     * worker processing it crashed.
+     */
+    bool completed = false;
+
+    /** Return status of the solve (KN_RC_CALLBACK_ERR if an exception was thrown). */
+    int status = 0;
+
+    /** Objective value. */
+    double objective_value = 0.0;
+
+    /** Primal values of the variables. */
+    std::vector<double> primal_values;
+
+    /** Solve time, in seconds (wall clock). */
+    double time = 0.0;
+
+    /** Identifier of the worker process which solved the scenario. */
+    int worker_id = -1;
+};
+
+using SolveFarmWorkerSetup = std::function<void(Context&)>;
+
+/**
+ * Solve a set of scenarios of a model with a farm of worker processes.
+ *
+ * The model and the scenarios are serialized once into a shared memory
+ * segment. Each worker is forked, attaches to the segment read-only, loads
+ * the model into its own context (and thus its own license) with
+ * Context::load_model, calls the setup function (to set parameters or add
+ * callbacks), then repeatedly takes the next scenario from a shared
+ * counter, applies its patch, solves it and writes the result into its
+ * slot of a shared result segment.
+ *
+ * The scenarios are not streamed to the workers: all patches are
+ * serialized up front, and the only shared queue is the counter of the
+ * next scenario to solve. Each result has a fixed-size slot (header and
+ * primal values) allocated before the workers are forked, so no result
+ * needs to be sent back through a queue.
+ *
+ * The workers are forked, so the setup function and the callbacks it adds
+ * are inherited; it should be called from a single-threaded process.
+ * Scenarios being solved by a worker which crashes are reported as not
+ * completed. The bounds of the model are restored after each scenario, but
+ * not the initial point (see SolveFarmScenario::initial_primal_values).
+ */
+inline std::vector<SolveFarmResult> solve_farm(
+        const Model& model,
+        const std::vector<SolveFarmScenario>& scenarios,
+        const SolveFarmWorkerSetup& setup = nullptr,
+        const SolveFarmParameters& parameters = {})
+{
+    VariableId number_of_variables = model.number_of_variables();
+    std::size_t number_of_scenarios = scenarios.size();
+
+    // Serialize the model and the scenarios.
+    std::vector<char> buffer = serialize_model(model);
+    std::vector<std::uint64_t> scenario_offsets;
+    for (const SolveFarmScenario& scenario: scenarios) {
+        scenario_offsets.push_back(buffer.size());
+        serialize_vector(buffer, scenario.variable_ids);
+        serialize_vector(buffer, scenario.variable_lower_bounds);
+        serialize_vector(buffer, scenario.variable_upper_bounds);
+        serialize_vector(buffer, scenario.constraint_ids);
+        serialize_vector(buffer, scenario.constraint_lower_bounds);
+        serialize_vector(buffer, scenario.constraint_upper_bounds);
+        serialize_vector(buffer, scenario.initial_primal_values);
+    }
+    std::size_t model_size = scenario_offsets.empty()? buffer.size(): scenario_offsets[0];
+    scenario_offsets.push_back(buffer.size());
+
+    static std::atomic<unsigned> segment_counter(0);
+    std::string name = "/knitrocpp_farm_"
+        + std::to_string(getpid()) + "_"
+        + std::to_string(segment_counter.fetch_add(1));
+    SharedMemorySegment model_segment(name, buffer.size());
+    std::memcpy(model_segment.data(), buffer.data(), buffer.size());
+    buffer = std::vector<char>();
+
+    // Result segment: the scenario counter, then one slot per scenario.
+    struct SlotHeader
+    {
+        std::atomic<std::int32_t> state;  // 0: pending, 1: running, 2: solved.
+        std::int32_t status;
+        std::int32_t worker_id;
+        double objective_value;
+        double time;
+    };
+    std::size_t slot_size = sizeof(SlotHeader) + number_of_variables * sizeof(double);
+    std::size_t results_size = sizeof(SlotHeader) + number_of_scenarios * slot_size;
+    void* results_data = mmap(
+            nullptr,
+            results_size,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_ANONYMOUS,
+            -1,
+            0);
+    if (results_data == MAP_FAILED)
+        throw std::runtime_error("KnitroCpp error: unable to map the result segment.");
+    std::unique_ptr<void, std::function<void(void*)>> results_guard(
+            results_data,
+            [results_size](void* data) { munmap(data, results_size); });
+    std::atomic<std::uint64_t>& next_scenario_id = *new (results_data) std::atomic<std::uint64_t>(0);
+    auto slot = [results_data, slot_size](std::size_t scenario_id)
+    {
+        return (SlotHeader*)((char*)results_data + sizeof(SlotHeader) + scenario_id * slot_size);
+    };
+    for (std::size_t scenario_id = 0; scenario_id < number_of_scenarios; ++scenario_id)
+        new (&slot(scenario_id)->state) std::atomic<std::int32_t>(0);
+
+    auto run_worker = [&](int worker_id)
+    {
+        SharedMemorySegment segment(name);
+        Model worker_model = deserialize_model(segment.data(), model_size);
+        Context knitro_context;
+        knitro_context.load_model(worker_model);
+        if (setup)
+            setup(knitro_context);
+        for (;;) {
+            std::uint64_t scenario_id = next_scenario_id.fetch_add(1);
+            if (scenario_id >= number_of_scenarios)
+                return;
+            SlotHeader& header = *slot(scenario_id);
+            header.worker_id = worker_id;
+            header.state.store(1);
+
+            const char* data = segment.data() + scenario_offsets[scenario_id];
+            const char* end = segment.data() + scenario_offsets[scenario_id + 1];
+            SolveFarmScenario scenario;
+            deserialize_vector(data, end, scenario.variable_ids);
+            deserialize_vector(data, end, scenario.variable_lower_bounds);
+            deserialize_vector(data, end, scenario.variable_upper_bounds);
+            deserialize_vector(data, end, scenario.constraint_ids);
+            deserialize_vector(data, end, scenario.constraint_lower_bounds);
+            deserialize_vector(data, end, scenario.constraint_upper_bounds);
+            deserialize_vector(data, end, scenario.initial_primal_values);
+
+            try {
+                if (!scenario.variable_ids.empty()) {
+                    knitro_context.set_var_lobnds(scenario.variable_ids, scenario.variable_lower_bounds);
+                    knitro_context.set_var_upbnds(scenario.variable_ids, scenario.variable_upper_bounds);
+                }
+                if (!scenario.constraint_ids.empty()) {
+                    knitro_context.set_con_lobnds(scenario.constraint_ids, scenario.constraint_lower_bounds);
+                    knitro_context.set_con_upbnds(scenario.constraint_ids, scenario.constraint_upper_bounds);
+                }
+                if (!scenario.initial_primal_values.empty())
+                    knitro_context.set_var_primal_init_values(scenario.initial_primal_values);
+                header.status = knitro_context.solve();
+                header.time = knitro_context.get_solve_time_real();
+                header.objective_value = knitro_context.get_obj_value();
+                std::vector<double> primal_values = knitro_context.get_var_primal_values();
+                std::memcpy(
+                        (char*)&header + sizeof(SlotHeader),
+                        primal_values.data(),
+                        number_of_variables * sizeof(double));
+            } catch (...) {
+                header.status = KN_RC_CALLBACK_ERR;
+            }
+            header.state.store(2);
+
+            // Restore the bounds of the model for the next scenario.
+            std::vector<double> lower_bounds;
+            std::vector<double> upper_bounds;
+            if (!scenario.variable_ids.empty()) {
+                for (VariableId variable_id: scenario.variable_ids) {
+                    lower_bounds.push_back(worker_model.variable_lower_bounds[variable_id]);
+                    upper_bounds.push_back(worker_model.variable_upper_bounds[variable_id]);
+                }
+                knitro_context.set_var_lobnds(scenario.variable_ids, lower_bounds);
+                knitro_context.set_var_upbnds(scenario.variable_ids, upper_bounds);
+            }
+            if (!scenario.constraint_ids.empty()) {
+                lower_bounds.clear();
+                upper_bounds.clear();
+                for (ConstraintId constraint_id: scenario.constraint_ids) {
+                    lower_bounds.push_back(worker_model.constraint_lower_bounds[constraint_id]);
+                    upper_bounds.push_back(worker_model.constraint_upper_bounds[constraint_id]);
+                }
+                knitro_context.set_con_lobnds(scenario.constraint_ids, lower_bounds);
+                knitro_context.set_con_upbnds(scenario.constraint_ids, upper_bounds);
+            }
+        }
+    };
+    auto spawn = [&](int worker_id)
+    {
+        pid_t pid = fork();
+        if (pid == -1)
+            throw std::runtime_error("KnitroCpp error: unable to fork a worker process.");
+        if (pid == 0) {
+            int exit_code = 0;
+            try {
+                run_worker(worker_id);
+            } catch (...) {
+                exit_code = 1;
+            }
+            // Skip the destructors and exit handlers of the parent process.
+            _exit(exit_code);
+        }
+        return pid;
+    };
+
+    unsigned number_of_processes = std::max(1u, parameters.number_of_processes);
+    number_of_processes = std::min<std::size_t>(number_of_processes, std::max<std::size_t>(1, number_of_scenarios));
+    std::vector<pid_t> pids;
+    try {
+        for (unsigned worker_id = 0; worker_id < number_of_processes; ++worker_id)
+            pids.push_back(spawn(worker_id));
+    } catch (...) {
+        for (pid_t pid: pids) {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+        }
+        throw;
+    }
+    // Only the workers are waited for, so that the other children of the
+    // calling process are left to their owner.
+    int next_worker_id = number_of_processes;
+    while (!pids.empty()) {
+        bool worker_exited = false;
+        for (std::size_t pos = 0; pos < pids.size();) {
+            int wait_status = 0;
+            pid_t pid = waitpid(pids[pos], &wait_status, WNOHANG);
+            if (pid == 0 || (pid == -1 && errno == EINTR)) {
+                ++pos;
+                continue;
+            }
+            worker_exited = true;
+            pids[pos] = pids.back();
+            pids.pop_back();
+            bool crashed = (pid == -1)
+                || !WIFEXITED(wait_status)
+                || WEXITSTATUS(wait_status) != 0;
+            if (crashed
+                    && (unsigned)next_worker_id < number_of_processes + parameters.maximum_number_of_restarts
+                    && next_scenario_id.load() < number_of_scenarios) {
+                pids.push_back(spawn(next_worker_id++));
+            }
+        }
+        if (!worker_exited)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::vector<SolveFarmResult> results(number_of_scenarios);
+    for (std::size_t scenario_id = 0; scenario_id < number_of_scenarios; ++scenario_id) {
+        const SlotHeader& header = *slot(scenario_id);
+        SolveFarmResult& result = results[scenario_id];
+        if (header.state.load() == 0)
+            continue;
+        result.worker_id = header.worker_id;
+        if (header.state.load() != 2)
+            continue;
+        result.completed = true;
+        result.status = header.status;
+        result.objective_value = header.objective_value;
+        result.time = header.time;
+        const double* primal_values = (const double*)((const char*)&header + sizeof(SlotHeader));
+        result.primal_values.assign(primal_values, primal_values + number_of_variables);
+    }
+    return results;
+}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace knitrocpp
+{
+
+namespace detail
+{
+
+/**
+ * Class for a bounded lock-free single-producer single-consumer queue.
+ *
+ * Slots are preallocated and reused: the producer writes into
+ * producer_slot() and publishes it with push(); the consumer reads
+ * consumer_slot() and releases it with pop().
+ */
+template <typename T>
+class SpscQueue
+{
+
+public:
+
+    /** Constructor; the slots are initialized to value. */
+    explicit SpscQueue(
+            std::size_t capacity,
+            const T& value = T()):
+        slots_(capacity + 1, value) { }
+
+    /** Get the slot to write the next element into; nullptr if the queue is full. */
+    T* producer_slot()
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (next(head) == tail_.load(std::memory_order_acquire))
+            return nullptr;
+        return &slots_[head];
+    }
+
+    /** Publish the element written into the producer slot. */
+    void push()
+    {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        head_.store(next(head), std::memory_order_release);
+    }
+
+    /** Get the oldest element; nullptr if the queue is empty. */
+    T* consumer_slot()
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire))
+            return nullptr;
+        return &slots_[tail];
+    }
+
+    /** Release the oldest element. */
+    void pop()
+    {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        tail_.store(next(tail), std::memory_order_release);
+    }
+
+private:
+
+    /*
+     * head_ and tail_ are separated by explicit padding rather than
+     * alignas(64), which plain new does not honor in C++11: they are at
+     * least a cache line apart from each other and from the neighbouring
+     * members wherever the queue is allocated.
+     */
+
+    /** Slots. */
+    std::vector<T> slots_;
+
+    char padding_0_[64];
+
+    /** Position of the next element to write. */
+    std::atomic<std::size_t> head_ {0};
+
+    char padding_1_[64];
+
+    /** Position of the next element to read. */
+    std::atomic<std::size_t> tail_ {0};
+
+    char padding_2_[64];
+
+    std::size_t next(std::size_t position) const
+    {
+        return (position + 1 == slots_.size())? 0: position + 1;
+    }
+
+};
+
+}
+
+}
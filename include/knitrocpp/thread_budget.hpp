@@ -0,0 +1,317 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace knitrocpp
+{
+
+/**
+ * Class for sharing the cores of the machine between concurrent solves.
+ *
+ * Each solve acquires a lease on a set of cores before calling solve().
+ * The share of a new lease is the number of cores divided by the number of
+ * leases (or by the expected number of concurrent solves if it is larger),
+ * bounded by the number of free cores; if no core is free, the lease gets
+ * one core shared with another lease. Since the parallel parameters of a
+ * context cannot change during its solve, the shares of existing leases
+ * are not rebalanced: the expected number of concurrent solves must be
+ * set (in the constructor or with set_expected_number_of_concurrent_solves)
+ * before the first lease, so that the first solves do not take all the
+ * cores. The cores of a lease are split
+ * between Knitro's threads and the threads used by the user callbacks, and
+ * Knitro's parallel parameters are set accordingly.
+ *
+ * Cores are handed out as contiguous ranges of core indices when possible,
+ * which keeps a lease on one NUMA node when the cores of a node are
+ * numbered contiguously.
+ */
+class ThreadBudget
+{
+
+public:
+
+    /** Class for a lease on a set of cores. */
+    class Lease
+    {
+
+    public:
+
+        Lease(Lease&& lease):
+            thread_budget_(lease.thread_budget_),
+            cores_(std::move(lease.cores_)),
+            number_of_solver_threads_(lease.number_of_solver_threads_),
+            number_of_callback_threads_(lease.number_of_callback_threads_)
+        {
+            lease.thread_budget_ = nullptr;
+        }
+
+        /** Destructor; return the cores to the budget. */
+        ~Lease()
+        {
+            if (thread_budget_ != nullptr)
+                thread_budget_->release(cores_);
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        /** Get the cores of the lease. */
+        const std::vector<unsigned>& cores() const { return cores_; }
+
+        /** Get the number of threads given to Knitro. */
+        unsigned number_of_solver_threads() const { return number_of_solver_threads_; }
+
+        /** Get the number of threads available to the user callbacks. */
+        unsigned number_of_callback_threads() const { return number_of_callback_threads_; }
+
+        /**
+         * Pin the calling thread to a core of the lease; return false if
+         * pinning is not supported on this platform.
+         *
+         * Only the calling thread is pinned; the threads created by Knitro
+         * are not.
+         */
+        bool pin_current_thread(std::size_t core_position = 0) const
+        {
+#if defined(__linux__)
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(cores_[core_position % cores_.size()], &cpu_set);
+            return pthread_setaffinity_np(
+                    pthread_self(),
+                    sizeof(cpu_set),
+                    &cpu_set) == 0;
+#else
+            (void)core_position;
+            return false;
+#endif
+        }
+
+        /**
+         * Pin the calling thread, the callback_thread_id-th thread used by
+         * the user callbacks, to one of the cores reserved for the callback
+         * threads; return false if pinning is not supported on this
+         * platform.
+         *
+         * It is meant to be called once by each worker thread of the user
+         * callbacks.
+         */
+        bool pin_callback_thread(std::size_t callback_thread_id) const
+        {
+            std::size_t number_of_callback_cores = cores_.size() - (std::min)(
+                    cores_.size(),
+                    (std::size_t)number_of_solver_threads_);
+            if (number_of_callback_cores == 0)
+                return pin_current_thread(callback_thread_id);
+            return pin_current_thread(
+                    number_of_solver_threads_
+                    + callback_thread_id % number_of_callback_cores);
+        }
+
+    private:
+
+        Lease(
+                ThreadBudget* thread_budget,
+                const std::vector<unsigned>& cores,
+                unsigned number_of_solver_threads,
+                unsigned number_of_callback_threads):
+            thread_budget_(thread_budget),
+            cores_(cores),
+            number_of_solver_threads_(number_of_solver_threads),
+            number_of_callback_threads_(number_of_callback_threads) { }
+
+        /** Budget the cores belong to. */
+        ThreadBudget* thread_budget_;
+
+        /** Cores. */
+        std::vector<unsigned> cores_;
+
+        /** Number of threads given to Knitro. */
+        unsigned number_of_solver_threads_;
+
+        /** Number of threads available to the user callbacks. */
+        unsigned number_of_callback_threads_;
+
+        friend class ThreadBudget;
+
+    };
+
+    /**
+     * Constructor.
+     *
+     * If expected_number_of_concurrent_solves is 0, it must be set with
+     * set_expected_number_of_concurrent_solves before the first lease.
+     */
+    explicit ThreadBudget(
+            unsigned number_of_cores = std::thread::hardware_concurrency(),
+            unsigned expected_number_of_concurrent_solves = 0):
+        core_usages_((std::max)(number_of_cores, 1u), 0),
+        expected_number_of_concurrent_solves_(expected_number_of_concurrent_solves) { }
+
+    ThreadBudget(const ThreadBudget&) = delete;
+    ThreadBudget& operator=(const ThreadBudget&) = delete;
+
+    /**
+     * Get the process-wide budget.
+     *
+     * set_expected_number_of_concurrent_solves must be called before its
+     * first lease.
+     */
+    static ThreadBudget& global()
+    {
+        static ThreadBudget thread_budget;
+        return thread_budget;
+    }
+
+    /**
+     * Acquire cores for the solve of a context and set its parallel
+     * parameters.
+     *
+     * number_of_callback_threads is the number of threads the user callbacks
+     * would like to use; they are taken from the share of the lease, Knitro
+     * keeping at least one thread.
+     */
+    Lease acquire(
+            Context& knitro_context,
+            unsigned number_of_callback_threads = 0)
+    {
+        std::vector<unsigned> cores;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (expected_number_of_concurrent_solves_ == 0) {
+                throw std::runtime_error(
+                        "KnitroCpp error: the expected number of concurrent "
+                        "solves of the thread budget must be set before "
+                        "acquiring a lease.");
+            }
+            unsigned number_of_cores = core_usages_.size();
+            number_of_leases_++;
+            unsigned number_of_free_cores = std::count(
+                    core_usages_.begin(),
+                    core_usages_.end(),
+                    0u);
+            unsigned share = (std::min)(
+                    (std::max)(
+                        number_of_cores / (std::max)(
+                            number_of_leases_,
+                            expected_number_of_concurrent_solves_),
+                        1u),
+                    number_of_free_cores);
+            cores = take_cores(share);
+        }
+        unsigned share = cores.size();
+        unsigned callback_threads = (std::min)(
+                number_of_callback_threads,
+                (share > 1)? share - 1: 0u);
+        if (number_of_callback_threads > 0 && callback_threads == 0)
+            callback_threads = 1;
+        unsigned solver_threads = (share > 1)? share - callback_threads: 1;
+        Lease lease(this, cores, solver_threads, callback_threads);
+        knitro_context.set(param::par_numthreads, solver_threads);
+        knitro_context.set(param::ms_numthreads, solver_threads);
+        knitro_context.set(param::mip_numthreads, solver_threads);
+        knitro_context.set(
+                param::par_blasnumthreads,
+                (std::min)(knitro_context.get(param::par_blasnumthreads), (int)solver_threads));
+        knitro_context.set(
+                param::par_lsnumthreads,
+                (std::min)(knitro_context.get(param::par_lsnumthreads), (int)solver_threads));
+        return lease;
+    }
+
+    /** Set the expected number of concurrent solves. */
+    void set_expected_number_of_concurrent_solves(unsigned expected_number_of_concurrent_solves)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        expected_number_of_concurrent_solves_ = expected_number_of_concurrent_solves;
+    }
+
+    /** Get the number of cores of the budget. */
+    unsigned number_of_cores() const { return core_usages_.size(); }
+
+    /** Get the number of active leases. */
+    unsigned number_of_leases() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return number_of_leases_;
+    }
+
+private:
+
+    /** Mutex protecting the members below. */
+    mutable std::mutex mutex_;
+
+    /** Number of leases using each core. */
+    std::vector<unsigned> core_usages_;
+
+    /** Expected number of concurrent solves. */
+    unsigned expected_number_of_concurrent_solves_;
+
+    /** Number of active leases. */
+    unsigned number_of_leases_ = 0;
+
+    /**
+     * Take number_of_cores free cores, preferably contiguous; if
+     * number_of_cores is 0, take the least used core.
+     */
+    std::vector<unsigned> take_cores(unsigned number_of_cores)
+    {
+        std::vector<unsigned> cores;
+        if (number_of_cores == 0) {
+            unsigned core = std::min_element(
+                    core_usages_.begin(),
+                    core_usages_.end()) - core_usages_.begin();
+            cores.push_back(core);
+        } else {
+            // Look for a contiguous range of free cores.
+            unsigned range_start = 0;
+            for (unsigned core = 0; core < core_usages_.size(); ++core) {
+                if (core_usages_[core] != 0) {
+                    range_start = core + 1;
+                    continue;
+                }
+                if (core + 1 - range_start == number_of_cores) {
+                    for (unsigned c = range_start; c <= core; ++c)
+                        cores.push_back(c);
+                    break;
+                }
+            }
+            // Otherwise, take the first free cores.
+            if (cores.empty()) {
+                for (unsigned core = 0;
+                        core < core_usages_.size()
+                        && cores.size() < number_of_cores;
+                        ++core) {
+                    if (core_usages_[core] == 0)
+                        cores.push_back(core);
+                }
+            }
+        }
+        for (unsigned core: cores)
+            core_usages_[core]++;
+        return cores;
+    }
+
+    /** Return the cores of a lease. */
+    void release(const std::vector<unsigned>& cores)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (unsigned core: cores)
+            core_usages_[core]--;
+        number_of_leases_--;
+    }
+
+};
+
+}
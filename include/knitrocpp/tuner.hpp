@@ -0,0 +1,306 @@
+#pragma once
+
+#include "knitrocpp/knitro.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace knitrocpp
+{
+
+using ModelBuilder = std::function<void(Context&)>;
+
+/**
+ * Structure for a set of parameter values.
+ */
+struct ParameterConfiguration
+{
+    /** Integer valued parameters (identifier, value). */
+    std::vector<std::pair<int, int>> int_params;
+
+    /** Double valued parameters (identifier, value). */
+    std::vector<std::pair<int, double>> double_params;
+
+    /** Set the parameters of a context. */
+    void apply(Context& knitro_context) const
+    {
+        for (const auto& param: int_params)
+            knitro_context.set_int_param(param.first, param.second);
+        for (const auto& param: double_params)
+            knitro_context.set_double_param(param.first, param.second);
+    }
+};
+
+/**
+ * Class for a parameter search space, the Cartesian product of candidate
+ * values for each parameter.
+ */
+class ParameterSearchSpace
+{
+
+public:
+
+    /** Add an integer valued parameter and its candidate values. */
+    void add_int_param(
+            int param_id,
+            const std::vector<int>& values)
+    {
+        int_params_.push_back({param_id, values});
+    }
+
+    /** Add a double valued parameter and its candidate values. */
+    void add_double_param(
+            int param_id,
+            const std::vector<double>& values)
+    {
+        double_params_.push_back({param_id, values});
+    }
+
+    /** Get the number of configurations of the search space. */
+    std::size_t number_of_configurations() const
+    {
+        std::size_t number_of_configurations = 1;
+        for (const auto& param: int_params_)
+            number_of_configurations *= param.second.size();
+        for (const auto& param: double_params_)
+            number_of_configurations *= param.second.size();
+        return number_of_configurations;
+    }
+
+    /** Get a configuration of the search space from its index. */
+    ParameterConfiguration configuration(std::size_t configuration_id) const
+    {
+        ParameterConfiguration configuration;
+        for (const auto& param: int_params_) {
+            configuration.int_params.push_back({
+                    param.first,
+                    param.second[configuration_id % param.second.size()]});
+            configuration_id /= param.second.size();
+        }
+        for (const auto& param: double_params_) {
+            configuration.double_params.push_back({
+                    param.first,
+                    param.second[configuration_id % param.second.size()]});
+            configuration_id /= param.second.size();
+        }
+        return configuration;
+    }
+
+private:
+
+    /** Integer valued parameters and their candidate values. */
+    std::vector<std::pair<int, std::vector<int>>> int_params_;
+
+    /** Double valued parameters and their candidate values. */
+    std::vector<std::pair<int, std::vector<double>>> double_params_;
+
+};
+
+/**
+ * Structure for the parameters of the tuner.
+ */
+struct TunerParameters
+{
+    /** Time limit of each solve, in seconds (wall clock). */
+    double time_limit = 60.0;
+
+    /** Number of solves run concurrently. */
+    unsigned number_of_threads = std::thread::hardware_concurrency();
+
+    /**
+     * Weight of the solution quality in the score of a configuration: a
+     * relative objective gap of 1 on a model costs quality_weight times the
+     * time limit.
+     */
+    double quality_weight = 1.0;
+};
+
+/**
+ * Structure for the results of a configuration on the benchmark.
+ */
+struct TuningResult
+{
+    /** Configuration. */
+    ParameterConfiguration configuration;
+
+    /**
+     * Number of solves that did not find a feasible solution within the
+     * time limit; solves that failed are counted with the full time limit.
+     */
+    int number_of_failures = 0;
+
+    /** Total solve time, in seconds. */
+    double total_time = 0.0;
+
+    /**
+     * Sum over the models of the relative gap between the objective value
+     * of the configuration and the best objective value found by any
+     * configuration; failed solves count as a gap of 1.
+     */
+    double total_gap = 0.0;
+
+    /** Score: total_time + quality_weight * time_limit * total_gap. */
+    double score = 0.0;
+
+    /** Return status of each solve. */
+    std::vector<int> statuses;
+
+    /** Objective value of each solve. */
+    std::vector<double> objective_values;
+
+    /** Solve time of each solve, in seconds. */
+    std::vector<double> times;
+};
+
+/**
+ * Solve each model with each configuration of a search space and rank the
+ * configurations.
+ *
+ * Configurations are ranked by number of failures, then by score, which
+ * combines the total solve time and the objective gaps to the best
+ * configuration of each model. The first result is the best configuration.
+ * All contexts are created from a single license.
+ */
+inline std::vector<TuningResult> tune(
+        const std::vector<ModelBuilder>& model_builders,
+        const ParameterSearchSpace& search_space,
+        const TunerParameters& parameters = {})
+{
+    std::size_t number_of_configurations = search_space.number_of_configurations();
+    std::size_t number_of_models = model_builders.size();
+    std::vector<TuningResult> results(number_of_configurations);
+    for (std::size_t configuration_id = 0;
+            configuration_id < number_of_configurations;
+            ++configuration_id) {
+        TuningResult& result = results[configuration_id];
+        result.configuration = search_space.configuration(configuration_id);
+        result.statuses.resize(number_of_models, 0);
+        result.objective_values.resize(number_of_models, 0.0);
+        result.times.resize(number_of_models, 0.0);
+    }
+
+    // Objective goal of each task, to compare the objective values.
+    std::vector<int> objective_goals(number_of_configurations * number_of_models, KN_OBJGOAL_MINIMIZE);
+
+    License license;
+    std::mutex license_mutex;
+    std::atomic<std::size_t> next_task_id(0);
+    std::size_t number_of_tasks = number_of_configurations * number_of_models;
+    auto run_tasks = [&]()
+    {
+        for (;;) {
+            std::size_t task_id = next_task_id.fetch_add(1);
+            if (task_id >= number_of_tasks)
+                return;
+            std::size_t configuration_id = task_id / number_of_models;
+            std::size_t model_id = task_id % number_of_models;
+            TuningResult& result = results[configuration_id];
+            try {
+                std::unique_ptr<Context> knitro_context;
+                {
+                    std::lock_guard<std::mutex> lock(license_mutex);
+                    knitro_context = std::unique_ptr<Context>(new Context(license));
+                }
+                model_builders[model_id](*knitro_context);
+                knitro_context->set_int_param(KN_PARAM_OUTLEV, 0);
+                result.configuration.apply(*knitro_context);
+                knitro_context->set_double_param(KN_PARAM_MAXTIMEREAL, parameters.time_limit);
+                int status = knitro_context->solve();
+                result.statuses[model_id] = status;
+                result.times[model_id] = knitro_context->get_solve_time_real();
+                result.objective_values[model_id] = knitro_context->get_obj_value();
+                objective_goals[task_id] = knitro_context->get_obj_goal();
+            } catch (...) {
+                result.statuses[model_id] = KN_RC_CALLBACK_ERR;
+                result.times[model_id] = parameters.time_limit;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned thread_id = 1; thread_id < parameters.number_of_threads; ++thread_id)
+        threads.push_back(std::thread(run_tasks));
+    run_tasks();
+    for (std::thread& thread: threads)
+        thread.join();
+
+    auto is_feasible = [](int status)
+    {
+        // 0: optimal; -100 to -199: feasible; -400 to -409: limit reached
+        // with a feasible point.
+        return (status == 0)
+            || (status <= -100 && status >= -199)
+            || (status <= -400 && status >= -409);
+    };
+
+    // Best objective value of each model over the configurations; the
+    // objective values are negated for maximization problems.
+    std::vector<double> best_objective_values(number_of_models, std::numeric_limits<double>::infinity());
+    auto signed_objective_value = [&](std::size_t configuration_id, std::size_t model_id)
+    {
+        double objective_value = results[configuration_id].objective_values[model_id];
+        return (objective_goals[configuration_id * number_of_models + model_id] == KN_OBJGOAL_MAXIMIZE)?
+            -objective_value: objective_value;
+    };
+    for (std::size_t configuration_id = 0;
+            configuration_id < number_of_configurations;
+            ++configuration_id) {
+        for (std::size_t model_id = 0; model_id < number_of_models; ++model_id) {
+            if (is_feasible(results[configuration_id].statuses[model_id])) {
+                best_objective_values[model_id] = (std::min)(
+                        best_objective_values[model_id],
+                        signed_objective_value(configuration_id, model_id));
+            }
+        }
+    }
+
+    for (std::size_t configuration_id = 0;
+            configuration_id < number_of_configurations;
+            ++configuration_id) {
+        TuningResult& result = results[configuration_id];
+        for (std::size_t model_id = 0; model_id < number_of_models; ++model_id) {
+            bool feasible = is_feasible(result.statuses[model_id]);
+            if (!feasible) {
+                result.number_of_failures++;
+                result.total_time += parameters.time_limit;
+                result.total_gap += 1.0;
+                continue;
+            }
+            result.total_time += result.times[model_id];
+            double best_objective_value = best_objective_values[model_id];
+            double gap = (signed_objective_value(configuration_id, model_id) - best_objective_value)
+                / (std::max)(1.0, std::abs(best_objective_value));
+            result.total_gap += (std::min)(1.0, gap);
+        }
+        result.score = result.total_time
+            + parameters.quality_weight * parameters.time_limit * result.total_gap;
+    }
+    std::stable_sort(
+            results.begin(),
+            results.end(),
+            [](const TuningResult& result_1, const TuningResult& result_2)
+            {
+                if (result_1.number_of_failures != result_2.number_of_failures)
+                    return result_1.number_of_failures < result_2.number_of_failures;
+                return result_1.score < result_2.score;
+            });
+    return results;
+}
+
+/**
+ * Write a configuration to a parameter file, to be read with
+ * Context::load_param_file.
+ */
+inline void save_param_file(
+        const ParameterConfiguration& configuration,
+        const std::string& filename)
+{
+    Context knitro_context;
+    configuration.apply(knitro_context);
+    knitro_context.save_param_file(filename);
+}
+
+}
@@ -0,0 +1,91 @@
+#include "knitrocpp/async_log.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace knitrocpp;
+
+TEST(AsyncLog, ConcurrentProducers)
+{
+    std::size_t number_of_threads = 4;
+    std::size_t number_of_messages = 2000;
+    std::vector<std::size_t> counts(number_of_threads, 0);
+    std::size_t number_of_received_messages = 0;
+    {
+        AsyncLog log(
+                [&counts, &number_of_received_messages](const std::string& message)
+                {
+                    counts[message[0] - 'a']++;
+                    number_of_received_messages++;
+                },
+                8);
+        std::vector<std::thread> threads;
+        for (std::size_t thread_id = 0; thread_id < number_of_threads; ++thread_id) {
+            threads.push_back(std::thread(
+                        [&log, thread_id, number_of_messages]()
+                        {
+                            std::string message(1, (char)('a' + thread_id));
+                            message += " message\n";
+                            for (std::size_t pos = 0; pos < number_of_messages; ++pos)
+                                log.write(message.c_str());
+                        }));
+        }
+        for (std::thread& thread: threads)
+            thread.join();
+        EXPECT_EQ(log.number_of_dropped_messages(), (std::size_t)0);
+    }
+    EXPECT_EQ(number_of_received_messages, number_of_threads * number_of_messages);
+    for (std::size_t thread_id = 0; thread_id < number_of_threads; ++thread_id)
+        EXPECT_EQ(counts[thread_id], number_of_messages);
+}
+
+TEST(AsyncLog, DropOnBackpressure)
+{
+    std::size_t number_of_messages = 1000;
+    std::size_t number_of_received_messages = 0;
+    std::size_t number_of_dropped_messages = 0;
+    {
+        AsyncLog log(
+                [&number_of_received_messages](const std::string&)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(10));
+                    number_of_received_messages++;
+                },
+                4,
+                true);
+        std::vector<std::thread> threads;
+        for (int thread_id = 0; thread_id < 2; ++thread_id) {
+            threads.push_back(std::thread(
+                        [&log, number_of_messages]()
+                        {
+                            for (std::size_t pos = 0; pos < number_of_messages / 2; ++pos)
+                                log.write("message\n");
+                        }));
+        }
+        for (std::thread& thread: threads)
+            thread.join();
+        number_of_dropped_messages = log.number_of_dropped_messages();
+    }
+    EXPECT_GT(number_of_dropped_messages, (std::size_t)0);
+    EXPECT_EQ(number_of_received_messages + number_of_dropped_messages, number_of_messages);
+}
+
+TEST(AsyncLog, SleepingConsumerIsWoken)
+{
+    std::vector<std::string> messages;
+    {
+        AsyncLog log(
+                [&messages](const std::string& message) { messages.push_back(message); },
+                2);
+        for (int pos = 0; pos < 20; ++pos) {
+            // Let the background thread fall asleep between messages.
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            log.write(std::to_string(pos).c_str());
+        }
+    }
+    ASSERT_EQ(messages.size(), (std::size_t)20);
+    for (int pos = 0; pos < 20; ++pos)
+        EXPECT_EQ(messages[pos], std::to_string(pos));
+}
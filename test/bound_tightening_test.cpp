@@ -0,0 +1,260 @@
+#include "knitrocpp/bound_tightening.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace knitrocpp;
+
+TEST(BoundTightening, Linear)
+{
+    // x + y <= 10, x, y >= 0.
+    Model model;
+    model.add_var();
+    model.add_var();
+    model.variable_lower_bounds = {0.0, 0.0};
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 0, 1.0);
+    model.add_con_linear_term(constraint_id, 1, 1.0);
+    model.constraint_upper_bounds[constraint_id] = 10.0;
+
+    BoundTighteningOutput output = BoundTightener(model).run();
+    EXPECT_FALSE(output.infeasible);
+    EXPECT_DOUBLE_EQ(output.variable_lower_bounds[0], 0.0);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[0], 10.0);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[1], 10.0);
+    EXPECT_EQ(output.number_of_tightened_lower_bounds, 0);
+    EXPECT_EQ(output.number_of_tightened_upper_bounds, 2);
+}
+
+TEST(BoundTightening, Square)
+{
+    // w^2 - 5 <= 4, w free.
+    Model model;
+    model.add_var();
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_quadratic_term(constraint_id, 0, 0, 1.0);
+    model.constraint_constants[constraint_id] = -5.0;
+    model.constraint_upper_bounds[constraint_id] = 4.0;
+
+    BoundTighteningOutput output = BoundTightener(model).run();
+    EXPECT_FALSE(output.infeasible);
+    EXPECT_DOUBLE_EQ(output.variable_lower_bounds[0], -3.0);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[0], 3.0);
+}
+
+TEST(BoundTightening, Bilinear)
+{
+    // x * y <= 2, x in [1, 4], y in [0, 10].
+    Model model;
+    model.add_var();
+    model.add_var();
+    model.variable_lower_bounds = {1.0, 0.0};
+    model.variable_upper_bounds = {4.0, 10.0};
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_quadratic_term(constraint_id, 0, 1, 1.0);
+    model.constraint_upper_bounds[constraint_id] = 2.0;
+
+    BoundTighteningOutput output = BoundTightener(model).run();
+    EXPECT_FALSE(output.infeasible);
+    EXPECT_DOUBLE_EQ(output.variable_lower_bounds[1], 0.0);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[1], 2.0);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[0], 4.0);
+}
+
+TEST(BoundTightening, IntegerRounding)
+{
+    // 2 z - x <= 7, x in [0, 10], z integer >= -2.
+    Model model;
+    model.add_var();
+    model.add_var();
+    model.variable_lower_bounds = {0.0, -2.0};
+    model.variable_upper_bounds = {10.0, KN_INFINITY};
+    model.variable_types = {KN_VARTYPE_CONTINUOUS, KN_VARTYPE_INTEGER};
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 1, 2.0);
+    model.add_con_linear_term(constraint_id, 0, -1.0);
+    model.constraint_upper_bounds[constraint_id] = 7.0;
+
+    BoundTighteningOutput output = BoundTightener(model).run();
+    EXPECT_FALSE(output.infeasible);
+    EXPECT_DOUBLE_EQ(output.variable_lower_bounds[1], -2.0);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[1], 8.0);
+}
+
+TEST(BoundTightening, Chain)
+{
+    // x_{i + 1} - x_i <= 1, x_0 in [0, 1], x_i >= 0.
+    VariableId number_of_variables = 10;
+    Model model;
+    for (VariableId variable_id = 0; variable_id < number_of_variables; ++variable_id)
+        model.add_var();
+    for (VariableId variable_id = 0; variable_id < number_of_variables; ++variable_id)
+        model.variable_lower_bounds[variable_id] = 0.0;
+    model.variable_upper_bounds[0] = 1.0;
+    for (VariableId variable_id = 0; variable_id + 1 < number_of_variables; ++variable_id) {
+        ConstraintId constraint_id = model.add_con();
+        model.add_con_linear_term(constraint_id, variable_id + 1, 1.0);
+        model.add_con_linear_term(constraint_id, variable_id, -1.0);
+        model.constraint_upper_bounds[constraint_id] = 1.0;
+    }
+
+    BoundTighteningOutput output = BoundTightener(model).run();
+    EXPECT_FALSE(output.infeasible);
+    for (VariableId variable_id = 0; variable_id < number_of_variables; ++variable_id)
+        EXPECT_DOUBLE_EQ(output.variable_upper_bounds[variable_id], variable_id + 1.0);
+}
+
+TEST(BoundTightening, SkippedConstraints)
+{
+    Model model;
+    model.add_var();
+    model.variable_lower_bounds = {0.0};
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 0, 1.0);
+    model.constraint_upper_bounds[constraint_id] = 1.0;
+
+    BoundTighteningOutput output = BoundTightener(model, {1}).run();
+    EXPECT_GE(output.variable_upper_bounds[0], KN_INFINITY);
+}
+
+TEST(BoundTightening, Infeasible)
+{
+    // x + y >= 3, x, y in [0, 1].
+    Model model;
+    model.add_var();
+    model.add_var();
+    model.variable_lower_bounds = {0.0, 0.0};
+    model.variable_upper_bounds = {1.0, 1.0};
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 0, 1.0);
+    model.add_con_linear_term(constraint_id, 1, 1.0);
+    model.constraint_lower_bounds[constraint_id] = 3.0;
+
+    BoundTighteningOutput output = BoundTightener(model).run();
+    EXPECT_TRUE(output.infeasible);
+}
+
+TEST(BoundTightening, InfeasibleInteger)
+{
+    // 2 z = 1, z integer.
+    Model model;
+    model.add_var();
+    model.variable_types = {KN_VARTYPE_INTEGER};
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 0, 2.0);
+    model.constraint_lower_bounds[constraint_id] = 1.0;
+    model.constraint_upper_bounds[constraint_id] = 1.0;
+
+    BoundTighteningOutput output = BoundTightener(model).run();
+    EXPECT_TRUE(output.infeasible);
+}
+
+TEST(BoundTightening, SquareRoundingError)
+{
+    // x^2 + y <= 0.3, y >= 0.1 + 0.2: the implied upper bound of x^2 is
+    // slightly negative because of rounding; x is fixed to 0.
+    Model model;
+    model.add_var();
+    model.add_var();
+    model.variable_lower_bounds[1] = 0.1 + 0.2;
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_quadratic_term(constraint_id, 0, 0, 1.0);
+    model.add_con_linear_term(constraint_id, 1, 1.0);
+    model.constraint_upper_bounds[constraint_id] = 0.3;
+
+    BoundTighteningOutput output = BoundTightener(model).run();
+    EXPECT_FALSE(output.infeasible);
+    EXPECT_DOUBLE_EQ(output.variable_lower_bounds[0], 0.0);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[0], 0.0);
+}
+
+TEST(BoundTightening, SquareInfeasible)
+{
+    // x^2 + y <= 0, y >= 1.
+    Model model;
+    model.add_var();
+    model.add_var();
+    model.variable_lower_bounds[1] = 1.0;
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_quadratic_term(constraint_id, 0, 0, 1.0);
+    model.add_con_linear_term(constraint_id, 1, 1.0);
+    model.constraint_upper_bounds[constraint_id] = 0.0;
+
+    BoundTighteningOutput output = BoundTightener(model).run();
+    EXPECT_TRUE(output.infeasible);
+}
+
+TEST(BoundTightening, StructureMirror)
+{
+    Context knitro_context;
+    knitro_context.enable_structure_mirror();
+    knitro_context.add_vars(3);
+    knitro_context.add_cons(3);
+    knitro_context.set_var_lobnds({0, 1, 2}, {0.0, 0.0, -1.0});
+    knitro_context.set_var_upbnds({2}, {1.0});
+    knitro_context.set_var_types({1}, {KN_VARTYPE_INTEGER});
+    knitro_context.add_con_linear_struct({0, 0}, {0, 1}, {1.0, 2.0});
+    knitro_context.add_con_constants({0}, {1.0});
+    knitro_context.set_con_upbnds({0}, {8.0});
+    knitro_context.add_con_quadratic_struct({1}, {2}, {2}, {1.0});
+    knitro_context.set_con_upbnds({1}, {4.0});
+    knitro_context.add_eval_callback(
+            false,
+            {2},
+            [](const Context&,
+                CB_context_ptr,
+                KN_eval_request_ptr const,
+                KN_eval_result_ptr const)
+            {
+                return 0;
+            });
+
+    const Model& model = knitro_context.structure_mirror();
+    ASSERT_EQ(model.number_of_variables(), 3);
+    ASSERT_EQ(model.number_of_constraints(), 3);
+    EXPECT_EQ(model.variable_lower_bounds, (std::vector<double>{0.0, 0.0, -1.0}));
+    EXPECT_EQ(model.variable_upper_bounds[2], 1.0);
+    EXPECT_EQ(model.variable_types[1], KN_VARTYPE_INTEGER);
+    EXPECT_EQ(model.constraint_linear_constraint_ids, (std::vector<ConstraintId>{0, 0}));
+    EXPECT_EQ(model.constraint_linear_variable_ids, (std::vector<VariableId>{0, 1}));
+    EXPECT_EQ(model.constraint_linear_coefficients, (std::vector<double>{1.0, 2.0}));
+    EXPECT_EQ(model.constraint_constants[0], 1.0);
+    EXPECT_EQ(model.constraint_upper_bounds[0], 8.0);
+    EXPECT_EQ(model.constraint_quadratic_constraint_ids, (std::vector<ConstraintId>{1}));
+    EXPECT_FALSE(knitro_context.is_con_mirror_nonlinear(0));
+    EXPECT_FALSE(knitro_context.is_con_mirror_nonlinear(1));
+    EXPECT_TRUE(knitro_context.is_con_mirror_nonlinear(2));
+    EXPECT_FALSE(knitro_context.is_obj_mirror_nonlinear());
+
+    // x0 + 2 x1 + 1 <= 8 (x1 integer): x0 <= 7, x1 <= 3.
+    BoundTighteningOutput output = tighten_bounds(knitro_context);
+    EXPECT_FALSE(output.infeasible);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[0], 7.0);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[1], 3.0);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[2], 1.0);
+
+    // The tightened bounds are set in the context and its mirror.
+    EXPECT_DOUBLE_EQ(model.variable_upper_bounds[0], 7.0);
+    EXPECT_DOUBLE_EQ(model.variable_upper_bounds[1], 3.0);
+    EXPECT_DOUBLE_EQ(model.variable_lower_bounds[2], -1.0);
+}
+
+TEST(BoundTightening, StructureMirrorSkipsL2Norm)
+{
+    // ||x0|| - x1 <= 0 is an L2 norm constraint and is not propagated.
+    Context knitro_context;
+    knitro_context.enable_structure_mirror();
+    knitro_context.add_vars(2);
+    knitro_context.set_var_lobnds({0, 1}, {-5.0, 0.0});
+    knitro_context.set_var_upbnds({0, 1}, {5.0, 1.0});
+    ConstraintId constraint_id = knitro_context.add_con();
+    knitro_context.add_con_L2norm(constraint_id, 1, {0}, {0}, {1.0});
+    knitro_context.add_con_linear_struct({constraint_id}, {1}, {-1.0});
+    knitro_context.set_con_upbnds({constraint_id}, {0.0});
+    EXPECT_TRUE(knitro_context.is_con_mirror_l2norm(constraint_id));
+    EXPECT_TRUE(knitro_context.is_con_mirror_nonlinear(constraint_id));
+
+    BoundTighteningOutput output = tighten_bounds(knitro_context);
+    EXPECT_FALSE(output.infeasible);
+    EXPECT_DOUBLE_EQ(output.variable_lower_bounds[0], -5.0);
+    EXPECT_DOUBLE_EQ(output.variable_upper_bounds[0], 5.0);
+}
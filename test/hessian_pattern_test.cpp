@@ -0,0 +1,138 @@
+#include "knitrocpp/knitro.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace knitrocpp;
+
+TEST(HessianPattern, Deduplication)
+{
+    HessianPattern hessian_pattern;
+    EXPECT_EQ(hessian_pattern.add(0, 0), 0);
+    EXPECT_EQ(hessian_pattern.add(1, 0), 1);
+    EXPECT_EQ(hessian_pattern.add(0, 1), 1);
+    EXPECT_EQ(hessian_pattern.add(1, 1), 2);
+    EXPECT_EQ(hessian_pattern.add(0, 0), 0);
+    EXPECT_EQ(hessian_pattern.number_of_entries(), 3);
+}
+
+TEST(HessianPattern, UpperTriangular)
+{
+    HessianPattern hessian_pattern;
+    hessian_pattern.add(3, 1);
+    hessian_pattern.add(2, 2);
+    hessian_pattern.add(0, 4);
+    for (KNLONG position = 0; position < hessian_pattern.number_of_entries(); ++position) {
+        EXPECT_LE(
+                hessian_pattern.variable_ids_1()[position],
+                hessian_pattern.variable_ids_2()[position]);
+    }
+    EXPECT_EQ(hessian_pattern.variable_ids_1()[0], 1);
+    EXPECT_EQ(hessian_pattern.variable_ids_2()[0], 3);
+}
+
+TEST(HessianPattern, Position)
+{
+    HessianPattern hessian_pattern;
+    hessian_pattern.add(3, 1);
+    hessian_pattern.add(0, 0);
+    EXPECT_EQ(hessian_pattern.position(1, 3), 0);
+    EXPECT_EQ(hessian_pattern.position(3, 1), 0);
+    EXPECT_EQ(hessian_pattern.position(0, 0), 1);
+    EXPECT_EQ(hessian_pattern.position(5, 5), -1);
+}
+
+TEST(HessianPattern, Accumulator)
+{
+    HessianPattern hessian_pattern;
+    hessian_pattern.add(3, 1);
+    hessian_pattern.add(0, 0);
+    hessian_pattern.add(1, 3);
+    hessian_pattern.add(1, 2);
+    hessian_pattern.add(5, 5);
+    hessian_pattern.add(2, 1);
+    ASSERT_EQ(hessian_pattern.number_of_entries(), 4);
+
+    // The accumulator resets the array.
+    std::vector<double> hess(hessian_pattern.number_of_entries(), 9.0);
+    HessianPattern::Accumulator accumulator = hessian_pattern.accumulator(hess.data());
+    accumulator.add(1, 3, 1.0);
+    accumulator.add(3, 1, 2.0);
+    accumulator.add(2, 1, 5.0);
+    accumulator.add(5, 5, 7.0);
+    accumulator.add((KNLONG)1, 1.5);
+    EXPECT_EQ(hess, (std::vector<double>{3.0, 1.5, 5.0, 7.0}));
+}
+
+TEST(HessianPattern, AccumulatorAfterUpdate)
+{
+    HessianPattern hessian_pattern;
+    hessian_pattern.add(0, 0);
+    hessian_pattern.add(1, 1);
+    std::vector<double> hess(hessian_pattern.number_of_entries());
+    hessian_pattern.accumulator(hess.data());
+
+    // Entries added after an accumulator has been built are indexed.
+    KNLONG position = hessian_pattern.add(4, 0);
+    hess.resize(hessian_pattern.number_of_entries());
+    HessianPattern::Accumulator accumulator = hessian_pattern.accumulator(hess.data());
+    accumulator.add(0, 4, 9.0);
+    EXPECT_EQ(hess[position], 9.0);
+}
+
+TEST(HessianPattern, Copy)
+{
+    HessianPattern hessian_pattern;
+    hessian_pattern.add(0, 1);
+    hessian_pattern.add(2, 2);
+    HessianPattern hessian_pattern_copy = hessian_pattern;
+    hessian_pattern.add(3, 3);
+    EXPECT_EQ(hessian_pattern_copy.number_of_entries(), 2);
+
+    std::vector<double> hess(hessian_pattern_copy.number_of_entries());
+    HessianPattern::Accumulator accumulator = hessian_pattern_copy.accumulator(hess.data());
+    accumulator.add(2, 2, 4.0);
+    accumulator.add(1, 0, 3.0);
+    EXPECT_EQ(hess, (std::vector<double>{3.0, 4.0}));
+}
+
+TEST(HessianPattern, AccumulatorMissingEntry)
+{
+    HessianPattern hessian_pattern;
+    hessian_pattern.add(0, 0);
+    hessian_pattern.add(1, 2);
+    std::vector<double> hess(hessian_pattern.number_of_entries());
+    HessianPattern::Accumulator accumulator = hessian_pattern.accumulator(hess.data());
+    EXPECT_THROW(accumulator.add(1, 1, 1.0), std::runtime_error);
+    EXPECT_THROW(accumulator.add(0, 2, 1.0), std::runtime_error);
+    EXPECT_THROW(accumulator.add(7, 9, 1.0), std::runtime_error);
+    EXPECT_EQ(hess, (std::vector<double>{0.0, 0.0}));
+}
+
+TEST(HessianPattern, ManyEntries)
+{
+    // Enough entries to resize the hash table several times.
+    HessianPattern hessian_pattern;
+    VariableId number_of_variables = 100;
+    for (VariableId variable_id_1 = 0; variable_id_1 < number_of_variables; ++variable_id_1)
+        for (VariableId variable_id_2 = variable_id_1; variable_id_2 < number_of_variables; variable_id_2 += 3)
+            hessian_pattern.add(variable_id_2, variable_id_1);
+    for (KNLONG position = 0; position < hessian_pattern.number_of_entries(); ++position) {
+        VariableId variable_id_1 = hessian_pattern.variable_ids_1()[position];
+        VariableId variable_id_2 = hessian_pattern.variable_ids_2()[position];
+        EXPECT_EQ(hessian_pattern.position(variable_id_1, variable_id_2), position);
+        EXPECT_EQ(hessian_pattern.position(variable_id_2, variable_id_1), position);
+        EXPECT_EQ(hessian_pattern.add(variable_id_1, variable_id_2), position);
+    }
+    EXPECT_EQ(hessian_pattern.position(0, 1), -1);
+
+    std::vector<double> hess(hessian_pattern.number_of_entries());
+    HessianPattern::Accumulator accumulator = hessian_pattern.accumulator(hess.data());
+    for (KNLONG position = 0; position < hessian_pattern.number_of_entries(); ++position) {
+        accumulator.add(
+                hessian_pattern.variable_ids_2()[position],
+                hessian_pattern.variable_ids_1()[position],
+                (double)position);
+    }
+    for (KNLONG position = 0; position < hessian_pattern.number_of_entries(); ++position)
+        EXPECT_EQ(hess[position], (double)position);
+}
@@ -0,0 +1,145 @@
+#include "knitrocpp/incumbent_stream.hpp"
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+
+using namespace knitrocpp;
+
+/**
+ * Consumer recording the incumbents it receives; it blocks on the first
+ * one until release() is called.
+ */
+struct BlockingConsumer
+{
+    std::mutex mutex;
+    std::condition_variable condition_variable;
+    bool started = false;
+    bool released = false;
+    std::vector<double> objectives;
+    std::vector<double> first_values;
+
+    void operator()(const Incumbent& incumbent)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        objectives.push_back(incumbent.objective);
+        first_values.push_back(incumbent.x[0]);
+        started = true;
+        condition_variable.notify_all();
+        condition_variable.wait(lock, [this]() { return released; });
+    }
+
+    void wait_started()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition_variable.wait(lock, [this]() { return started; });
+    }
+
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        condition_variable.notify_all();
+    }
+};
+
+bool offer(
+        IncumbentStream& incumbent_stream,
+        double objective,
+        bool read_x_succeeds = true)
+{
+    return incumbent_stream.offer(
+            [objective](double& value) { value = objective; return true; },
+            [objective, read_x_succeeds](double* const x)
+            {
+                x[0] = objective;
+                x[1] = -objective;
+                return read_x_succeeds;
+            });
+}
+
+TEST(IncumbentStream, PendingIncumbentWhenPoolIsFull)
+{
+    BlockingConsumer consumer;
+    {
+        IncumbentStream incumbent_stream(
+                [&consumer](const Incumbent& incumbent) { consumer(incumbent); },
+                KN_OBJGOAL_MINIMIZE,
+                2,
+                1);
+        EXPECT_TRUE(offer(incumbent_stream, 10.0));
+        consumer.wait_started();
+        // The only slot is held by the consumer.
+        EXPECT_TRUE(offer(incumbent_stream, 9.0));
+        EXPECT_TRUE(offer(incumbent_stream, 8.0));
+        EXPECT_FALSE(offer(incumbent_stream, 8.5));
+        consumer.release();
+    }
+    ASSERT_EQ(consumer.objectives.size(), (std::size_t)2);
+    EXPECT_EQ(consumer.objectives[0], 10.0);
+    EXPECT_EQ(consumer.objectives[1], 8.0);
+    EXPECT_EQ(consumer.first_values[1], 8.0);
+}
+
+TEST(IncumbentStream, DroppedIncumbentsAreCounted)
+{
+    BlockingConsumer consumer;
+    std::size_t number_of_dropped_incumbents = 0;
+    {
+        IncumbentStream incumbent_stream(
+                [&consumer](const Incumbent& incumbent) { consumer(incumbent); },
+                KN_OBJGOAL_MAXIMIZE,
+                2,
+                1);
+        EXPECT_TRUE(offer(incumbent_stream, 1.0));
+        consumer.wait_started();
+        EXPECT_TRUE(offer(incumbent_stream, 2.0));
+        EXPECT_TRUE(offer(incumbent_stream, 3.0));
+        EXPECT_TRUE(offer(incumbent_stream, 4.0));
+        number_of_dropped_incumbents = incumbent_stream.number_of_dropped_incumbents();
+        consumer.release();
+    }
+    EXPECT_EQ(number_of_dropped_incumbents, (std::size_t)2);
+    ASSERT_EQ(consumer.objectives.size(), (std::size_t)2);
+    EXPECT_EQ(consumer.objectives[1], 4.0);
+}
+
+TEST(IncumbentStream, FailedReadKeepsBestObjective)
+{
+    BlockingConsumer consumer;
+    consumer.release();
+    {
+        IncumbentStream incumbent_stream(
+                [&consumer](const Incumbent& incumbent) { consumer(incumbent); },
+                KN_OBJGOAL_MINIMIZE,
+                2,
+                4);
+        EXPECT_FALSE(offer(incumbent_stream, 5.0, false));
+        EXPECT_TRUE(incumbent_stream.improves(5.0));
+        EXPECT_TRUE(offer(incumbent_stream, 5.0));
+        EXPECT_FALSE(incumbent_stream.improves(5.0));
+    }
+    ASSERT_EQ(consumer.objectives.size(), (std::size_t)1);
+    EXPECT_EQ(consumer.objectives[0], 5.0);
+}
+
+TEST(IncumbentStream, FailedReadKeepsPendingIncumbent)
+{
+    BlockingConsumer consumer;
+    {
+        IncumbentStream incumbent_stream(
+                [&consumer](const Incumbent& incumbent) { consumer(incumbent); },
+                KN_OBJGOAL_MINIMIZE,
+                2,
+                1);
+        EXPECT_TRUE(offer(incumbent_stream, 10.0));
+        consumer.wait_started();
+        EXPECT_TRUE(offer(incumbent_stream, 9.0));
+        EXPECT_FALSE(offer(incumbent_stream, 8.0, false));
+        consumer.release();
+    }
+    ASSERT_EQ(consumer.objectives.size(), (std::size_t)2);
+    EXPECT_EQ(consumer.objectives[1], 9.0);
+    EXPECT_EQ(consumer.first_values[1], 9.0);
+}
@@ -0,0 +1,87 @@
+#include "knitrocpp/multistart.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace knitrocpp;
+
+namespace
+{
+
+/** Radical inverse of index in a given base. */
+double halton(std::uint64_t index, std::uint64_t base)
+{
+    double value = 0.0;
+    double factor = 1.0 / base;
+    for (; index > 0; index /= base, factor /= base)
+        value += (index % base) * factor;
+    return value;
+}
+
+}
+
+TEST(MultistartPointGenerator, HaltonSequence)
+{
+    // Batches of 3 points generated by 2 threads, so that both the batch
+    // boundaries and the thread boundaries are crossed.
+    MultistartPointGenerator generator({0.0, -1.0}, {1.0, 1.0}, 1000.0, 3, 2);
+    generator.set_exclusion_radius(0.0);
+    EXPECT_DOUBLE_EQ(halton(20, 2), 0.15625);
+    for (std::uint64_t point_id = 0; point_id < 10; ++point_id) {
+        double x[2];
+        generator.generate(x);
+        EXPECT_DOUBLE_EQ(x[0], halton(point_id + 20, 2));
+        EXPECT_DOUBLE_EQ(x[1], -1.0 + 2.0 * halton(point_id + 20, 3));
+    }
+    EXPECT_EQ(generator.number_of_discarded_points(), (std::size_t)0);
+}
+
+TEST(MultistartPointGenerator, InfiniteBounds)
+{
+    MultistartPointGenerator generator(
+            {-KN_INFINITY, -KN_INFINITY, 5.0},
+            {KN_INFINITY, 5.0, KN_INFINITY},
+            100.0, 4, 1);
+    double x[3];
+    generator.generate(x);
+    EXPECT_DOUBLE_EQ(x[0], -50.0 + 100.0 * halton(20, 2));
+    EXPECT_DOUBLE_EQ(x[1], -95.0 + 100.0 * halton(20, 3));
+    EXPECT_DOUBLE_EQ(x[2], 5.0 + 100.0 * halton(20, 5));
+}
+
+TEST(MultistartPointGenerator, ExclusionRadius)
+{
+    MultistartPointGenerator generator({0.0}, {10.0}, 1000.0, 4, 2);
+    generator.set_exclusion_radius(0.01);
+
+    // The second point is within the radius of an explored point and is
+    // skipped.
+    double explored_point = 10.0 * halton(21, 2) + 0.05;
+    generator.add_explored_point(&explored_point);
+    double x;
+    generator.generate(&x);
+    EXPECT_DOUBLE_EQ(x, 10.0 * halton(20, 2));
+    generator.generate(&x);
+    EXPECT_DOUBLE_EQ(x, 10.0 * halton(22, 2));
+    EXPECT_EQ(generator.number_of_discarded_points(), (std::size_t)1);
+
+    // A point just outside of the radius is kept.
+    explored_point = 10.0 * halton(23, 2) + 0.11;
+    generator.add_explored_point(&explored_point);
+    generator.generate(&x);
+    EXPECT_DOUBLE_EQ(x, 10.0 * halton(23, 2));
+    EXPECT_EQ(generator.number_of_discarded_points(), (std::size_t)1);
+}
+
+TEST(MultistartPointGenerator, AllPointsExplored)
+{
+    // With a radius covering the whole box, every point is discarded and
+    // the last point generated is returned.
+    MultistartPointGenerator generator({0.0}, {1.0}, 1000.0, 4, 2);
+    generator.set_exclusion_radius(2.0);
+    double explored_point = 0.5;
+    generator.add_explored_point(&explored_point);
+    double x;
+    generator.generate(&x, 3);
+    EXPECT_DOUBLE_EQ(x, halton(20 + 3 * 4 - 1, 2));
+    EXPECT_EQ(generator.number_of_discarded_points(), (std::size_t)12);
+}
@@ -0,0 +1,80 @@
+#include "knitrocpp/point_evaluator.hpp"
+#include "knitrocpp/scratch_arena.hpp"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace knitrocpp;
+
+TEST(PointEvaluator, ArenaCallbackInParallelBatch)
+{
+    // min x0^2 + x1^2 + x2^2, s.t. x0 * x1 * x2 (callback), with a scratch
+    // arena used as the buffer of the callback.
+    Context knitro_context;
+    knitro_context.enable_structure_mirror();
+    knitro_context.add_vars(3);
+    knitro_context.add_cons(1);
+    std::mutex mutex;
+    std::map<int, std::thread::id> threads;
+    bool shared_thread_id = false;
+    knitro_context.add_eval_callback(
+            true,
+            {0},
+            with_scratch_arenas(
+                [&mutex, &threads, &shared_thread_id](
+                    const Context&,
+                    CB_context_ptr,
+                    KN_eval_request_ptr const eval_request,
+                    KN_eval_result_ptr const eval_result,
+                    ScratchArena& arena)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        auto it = threads.find(eval_request->threadID);
+                        if (it == threads.end()) {
+                            threads[eval_request->threadID] = std::this_thread::get_id();
+                        } else if (it->second != std::this_thread::get_id()) {
+                            shared_thread_id = true;
+                        }
+                    }
+                    const double* x = eval_request->x;
+                    double* squares = arena.allocate<double>(3);
+                    for (int pos = 0; pos < 3; ++pos)
+                        squares[pos] = x[pos] * x[pos];
+                    std::this_thread::yield();
+                    *eval_result->obj = squares[0] + squares[1] + squares[2];
+                    eval_result->c[0] = x[0] * x[1] * x[2];
+                    return 0;
+                }));
+
+    PointEvaluatorParameters parameters;
+    parameters.number_of_threads = 4;
+    parameters.chunk_size = 1;
+    PointEvaluator point_evaluator(knitro_context, parameters);
+
+    std::size_t number_of_points = 2000;
+    std::vector<double> points(3 * number_of_points);
+    for (std::size_t pos = 0; pos < points.size(); ++pos)
+        points[pos] = (double)(pos % 7) - 3.0;
+    std::vector<PointEvaluation> evaluations(number_of_points);
+    std::vector<double> constraint_values(number_of_points);
+    point_evaluator.evaluate(
+            number_of_points,
+            points.data(),
+            evaluations.data(),
+            constraint_values.data());
+
+    EXPECT_FALSE(shared_thread_id);
+    EXPECT_GE(threads.size(), (std::size_t)1);
+    for (std::size_t point_id = 0; point_id < number_of_points; ++point_id) {
+        const double* x = points.data() + 3 * point_id;
+        EXPECT_EQ(evaluations[point_id].status, 0);
+        EXPECT_DOUBLE_EQ(
+                evaluations[point_id].objective_value,
+                x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+        EXPECT_DOUBLE_EQ(constraint_values[point_id], x[0] * x[1] * x[2]);
+    }
+}
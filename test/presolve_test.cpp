@@ -0,0 +1,199 @@
+#include "knitrocpp/presolve.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace knitrocpp;
+
+/**
+ * Compute the gradient of the Lagrangian of a model with respect to a
+ * variable (Knitro's convention: objective gradient plus the constraint
+ * and variable multipliers times the gradients of the constraints and of
+ * the bounds).
+ */
+double lagrangian_gradient(
+        const Model& model,
+        VariableId variable_id,
+        const std::vector<double>& x,
+        const std::vector<double>& constraint_dual_values,
+        const std::vector<double>& variable_dual_values)
+{
+    double gradient = variable_dual_values[variable_id];
+    for (std::size_t pos = 0; pos < model.objective_linear_variable_ids.size(); ++pos)
+        if (model.objective_linear_variable_ids[pos] == variable_id)
+            gradient += model.objective_linear_coefficients[pos];
+    for (std::size_t pos = 0; pos < model.objective_quadratic_variable_ids_1.size(); ++pos) {
+        VariableId variable_id_1 = model.objective_quadratic_variable_ids_1[pos];
+        VariableId variable_id_2 = model.objective_quadratic_variable_ids_2[pos];
+        double coefficient = model.objective_quadratic_coefficients[pos];
+        if (variable_id_1 == variable_id)
+            gradient += coefficient * x[variable_id_2];
+        if (variable_id_2 == variable_id)
+            gradient += coefficient * x[variable_id_1];
+    }
+    for (std::size_t pos = 0; pos < model.constraint_linear_variable_ids.size(); ++pos) {
+        if (model.constraint_linear_variable_ids[pos] == variable_id) {
+            gradient += constraint_dual_values[model.constraint_linear_constraint_ids[pos]]
+                * model.constraint_linear_coefficients[pos];
+        }
+    }
+    return gradient;
+}
+
+/**
+ * min x0 + 2 x1 + x2 x3
+ * s.t. 2 x3 >= 3            (singleton row)
+ *      x0 + x1 + x2 >= 5
+ *      2 x0 + 2 x1 >= 8     (duplicate row, tighter once x2 is fixed)
+ *      x2 = 2               (empty row once x2 is fixed)
+ *      x0, x1, x3 in [0, 10], x2 = 2, x3 integer
+ */
+Model build_model()
+{
+    Model model;
+    for (VariableId variable_id = 0; variable_id < 4; ++variable_id)
+        model.add_var();
+    model.variable_lower_bounds = {0.0, 0.0, 2.0, 0.0};
+    model.variable_upper_bounds = {10.0, 10.0, 2.0, 10.0};
+    model.variable_types = {
+        KN_VARTYPE_CONTINUOUS,
+        KN_VARTYPE_CONTINUOUS,
+        KN_VARTYPE_CONTINUOUS,
+        KN_VARTYPE_INTEGER};
+    model.add_obj_linear_term(0, 1.0);
+    model.add_obj_linear_term(1, 2.0);
+    model.add_obj_quadratic_term(2, 3, 1.0);
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 3, 2.0);
+    model.constraint_lower_bounds[constraint_id] = 3.0;
+    constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 0, 1.0);
+    model.add_con_linear_term(constraint_id, 1, 1.0);
+    model.add_con_linear_term(constraint_id, 2, 1.0);
+    model.constraint_lower_bounds[constraint_id] = 5.0;
+    constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 0, 2.0);
+    model.add_con_linear_term(constraint_id, 1, 2.0);
+    model.constraint_lower_bounds[constraint_id] = 8.0;
+    constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 2, 1.0);
+    model.constraint_lower_bounds[constraint_id] = 2.0;
+    model.constraint_upper_bounds[constraint_id] = 2.0;
+    return model;
+}
+
+TEST(Presolve, Reductions)
+{
+    Model model = build_model();
+    Presolve presolve(model);
+    EXPECT_FALSE(presolve.infeasible());
+    EXPECT_EQ(presolve.number_of_removed_variables(), 1);
+    EXPECT_EQ(presolve.number_of_singleton_rows(), 1);
+    EXPECT_EQ(presolve.number_of_empty_rows(), 1);
+    EXPECT_EQ(presolve.number_of_duplicate_rows(), 1);
+
+    const Model& reduced_model = presolve.reduced_model();
+    ASSERT_EQ(reduced_model.number_of_variables(), 3);
+    ASSERT_EQ(reduced_model.number_of_constraints(), 1);
+    EXPECT_EQ(presolve.reduced_variable_id(2), -1);
+    EXPECT_EQ(presolve.reduced_constraint_id(0), -1);
+    EXPECT_EQ(presolve.reduced_constraint_id(3), -1);
+    // 1.5 rounded up for the integer variable.
+    VariableId reduced_variable_id = presolve.reduced_variable_id(3);
+    EXPECT_DOUBLE_EQ(reduced_model.variable_lower_bounds[reduced_variable_id], 2.0);
+    // x0 + x1 + 2 >= 8.
+    EXPECT_DOUBLE_EQ(
+            reduced_model.constraint_lower_bounds[0] - reduced_model.constraint_constants[0],
+            4.0);
+}
+
+TEST(Presolve, PostsolvePrimalValues)
+{
+    Model model = build_model();
+    Presolve presolve(model);
+    std::vector<double> x = presolve.postsolve_primal_values({4.0, 0.0, 2.0});
+    EXPECT_EQ(x, (std::vector<double>{4.0, 0.0, 2.0, 2.0}));
+}
+
+TEST(Presolve, PostsolveDualValues)
+{
+    // Reduced optimum: x0 = 4, x1 = 0, x3 = 2, with the row x0 + x1 >= 4 and
+    // the bounds x1 >= 0 and x3 >= 2 active.
+    Model model = build_model();
+    Presolve presolve(model);
+    std::vector<double> x = presolve.postsolve_primal_values({4.0, 0.0, 2.0});
+    std::vector<double> constraint_dual_values;
+    std::vector<double> variable_dual_values;
+    presolve.postsolve_dual_values(
+            x,
+            {-1.0},
+            {0.0, -1.0, -2.0},
+            constraint_dual_values,
+            variable_dual_values);
+
+    // The bound implied by the singleton row gets its multiplier back.
+    EXPECT_DOUBLE_EQ(constraint_dual_values[0], -1.0);
+    EXPECT_DOUBLE_EQ(variable_dual_values[3], 0.0);
+    // The tighter duplicate row is the active one.
+    EXPECT_DOUBLE_EQ(constraint_dual_values[1], 0.0);
+    EXPECT_DOUBLE_EQ(constraint_dual_values[2], -0.5);
+    EXPECT_DOUBLE_EQ(constraint_dual_values[3], 0.0);
+    // The multiplier of the fixed variable is its reduced cost.
+    EXPECT_DOUBLE_EQ(variable_dual_values[2], -2.0);
+    for (VariableId variable_id = 0; variable_id < model.number_of_variables(); ++variable_id) {
+        EXPECT_NEAR(lagrangian_gradient(
+                    model,
+                    variable_id,
+                    x,
+                    constraint_dual_values,
+                    variable_dual_values), 0.0, 1e-12);
+    }
+}
+
+TEST(Presolve, PostsolveDualValuesNegativeCoefficient)
+{
+    // min x s.t. -2 x <= -4, x in [0, 10]: the row implies x >= 2.
+    Model model;
+    model.add_var();
+    model.variable_lower_bounds = {0.0};
+    model.variable_upper_bounds = {10.0};
+    model.add_obj_linear_term(0, 1.0);
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 0, -2.0);
+    model.constraint_upper_bounds[constraint_id] = -4.0;
+
+    Presolve presolve(model);
+    ASSERT_EQ(presolve.number_of_singleton_rows(), 1);
+    EXPECT_DOUBLE_EQ(presolve.reduced_model().variable_lower_bounds[0], 2.0);
+    std::vector<double> x = presolve.postsolve_primal_values({2.0});
+    std::vector<double> constraint_dual_values;
+    std::vector<double> variable_dual_values;
+    presolve.postsolve_dual_values(
+            x,
+            {},
+            {-1.0},
+            constraint_dual_values,
+            variable_dual_values);
+    EXPECT_DOUBLE_EQ(constraint_dual_values[0], 0.5);
+    EXPECT_DOUBLE_EQ(variable_dual_values[0], 0.0);
+    EXPECT_NEAR(lagrangian_gradient(
+                model,
+                0,
+                x,
+                constraint_dual_values,
+                variable_dual_values), 0.0, 1e-12);
+}
+
+TEST(Presolve, Infeasible)
+{
+    // x >= 2 with x in [0, 1].
+    Model model;
+    model.add_var();
+    model.variable_lower_bounds = {0.0};
+    model.variable_upper_bounds = {1.0};
+    ConstraintId constraint_id = model.add_con();
+    model.add_con_linear_term(constraint_id, 0, 1.0);
+    model.constraint_lower_bounds[constraint_id] = 2.0;
+
+    Presolve presolve(model);
+    EXPECT_TRUE(presolve.infeasible());
+}
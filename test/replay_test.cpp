@@ -0,0 +1,179 @@
+#include "knitrocpp/replay.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+using namespace knitrocpp;
+
+/** Offset added to the constraint value, to make the callback change. */
+double constraint_offset = 0.0;
+
+/** obj = x0^2 + x1, c0 = x0 x1 + offset. */
+void evaluate_function(
+        const double* x,
+        double* obj,
+        double* c)
+{
+    *obj = x[0] * x[0] + x[1];
+    c[0] = x[0] * x[1] + constraint_offset;
+}
+
+void evaluate_gradient(
+        const double* x,
+        double* obj_grad,
+        double* jac)
+{
+    obj_grad[0] = 2 * x[0];
+    obj_grad[1] = 1;
+    jac[0] = x[1];
+    jac[1] = x[0];
+}
+
+int eval_callback(
+        const Context&,
+        CB_context_ptr,
+        KN_eval_request_ptr const eval_request,
+        KN_eval_result_ptr const eval_result)
+{
+    evaluate_function(eval_request->x, eval_result->obj, eval_result->c);
+    return 0;
+}
+
+int gradient_callback(
+        const Context&,
+        CB_context_ptr,
+        KN_eval_request_ptr const eval_request,
+        KN_eval_result_ptr const eval_result)
+{
+    evaluate_gradient(eval_request->x, eval_result->objGrad, eval_result->jac);
+    return 0;
+}
+
+/** Write a trace of the evaluations of the callbacks at a few points. */
+std::size_t write_trace(const std::string& filename)
+{
+    TraceRecorder trace_recorder(filename, 2, 1);
+    for (int point_id = 0; point_id < 3; ++point_id) {
+        double x[2] = {1.0 + point_id, 2.0 - point_id};
+        double obj = 0.0;
+        double c[1] = {0.0};
+        double obj_grad[2] = {0.0, 0.0};
+        double jac[2] = {0.0, 0.0};
+
+        evaluate_function(x, &obj, c);
+        TraceRecorder::Array function_arrays[5] = {
+            {x, 2}, {nullptr, 0}, {nullptr, 0}, {&obj, 1}, {c, 1}};
+        trace_recorder.record(0, 0, KN_RC_EVALFC, 0, 1.0, function_arrays);
+
+        evaluate_gradient(x, obj_grad, jac);
+        TraceRecorder::Array gradient_arrays[5] = {
+            {x, 2}, {nullptr, 0}, {nullptr, 0}, {obj_grad, 2}, {jac, 2}};
+        trace_recorder.record(1, 0, KN_RC_EVALGA, 0, 1.0, gradient_arrays);
+    }
+    return trace_recorder.number_of_records();
+}
+
+TEST(TraceReplay, RoundTrip)
+{
+    std::string filename = "replay_test_round_trip.trace";
+    constraint_offset = 0.0;
+    ASSERT_EQ(write_trace(filename), 6);
+
+    TraceReplay trace_replay(filename);
+    EXPECT_EQ(trace_replay.number_of_variables(), 2);
+    EXPECT_EQ(trace_replay.number_of_constraints(), 1);
+    ASSERT_EQ(trace_replay.records().size(), 6);
+    const TraceRecord& record = trace_replay.records()[3];
+    EXPECT_EQ(record.callback_type, 1);
+    EXPECT_EQ(record.callback_index, 0);
+    EXPECT_EQ(record.request_type, KN_RC_EVALGA);
+    EXPECT_EQ(record.x, (std::vector<double>{2.0, 1.0}));
+    EXPECT_TRUE(record.lambda.empty());
+    EXPECT_EQ(record.output_1, (std::vector<double>{4.0, 1.0}));
+    EXPECT_EQ(record.output_2, (std::vector<double>{1.0, 2.0}));
+
+    trace_replay.add_eval_callback(eval_callback, gradient_callback);
+    TraceReplayOutput output = trace_replay.run(0.0, 2);
+    EXPECT_EQ(output.number_of_evaluations, 12);
+    EXPECT_EQ(output.number_of_mismatches, 0);
+    EXPECT_EQ(output.first_mismatch, -1);
+    EXPECT_EQ(output.timings.function.number_of_evaluations, 6);
+    EXPECT_EQ(output.timings.gradient.number_of_evaluations, 6);
+    std::remove(filename.c_str());
+}
+
+int constraint_callback(
+        const Context&,
+        CB_context_ptr,
+        KN_eval_request_ptr const eval_request,
+        KN_eval_result_ptr const eval_result)
+{
+    *eval_result->obj = 0.0;
+    eval_result->c[0] = eval_request->x[0] * eval_request->x[1];
+    return 0;
+}
+
+TEST(TraceReplay, ConstraintOnlyCallback)
+{
+    // The objective is not evaluated by the callback, so no objective value
+    // is recorded.
+    std::string filename = "replay_test_constraint_only.trace";
+    {
+        TraceRecorder trace_recorder(filename, 2, 1);
+        double x[2] = {2.0, 3.0};
+        double c[1] = {6.0};
+        TraceRecorder::Array function_arrays[5] = {
+            {x, 2}, {nullptr, 0}, {nullptr, 0}, {nullptr, 0}, {c, 1}};
+        trace_recorder.record(0, 0, KN_RC_EVALFC, 0, 1.0, function_arrays);
+    }
+
+    TraceReplay trace_replay(filename);
+    ASSERT_TRUE(trace_replay.records()[0].output_1.empty());
+    trace_replay.add_eval_callback(constraint_callback);
+    TraceReplayOutput output = trace_replay.run();
+    EXPECT_EQ(output.number_of_evaluations, 1);
+    EXPECT_EQ(output.number_of_mismatches, 0);
+    std::remove(filename.c_str());
+}
+
+TEST(TraceReplay, Mismatch)
+{
+    std::string filename = "replay_test_mismatch.trace";
+    constraint_offset = 0.0;
+    write_trace(filename);
+
+    TraceReplay trace_replay(filename);
+    trace_replay.add_eval_callback(eval_callback, gradient_callback);
+    constraint_offset = 0.5;
+    TraceReplayOutput output = trace_replay.run();
+    EXPECT_EQ(output.number_of_mismatches, 3);
+    EXPECT_EQ(output.first_mismatch, 0);
+    EXPECT_DOUBLE_EQ(output.maximum_difference, 0.5);
+    EXPECT_EQ(trace_replay.run(1.0).number_of_mismatches, 0);
+    constraint_offset = 0.0;
+    std::remove(filename.c_str());
+}
+
+TEST(TraceReplay, MissingCallback)
+{
+    std::string filename = "replay_test_missing_callback.trace";
+    write_trace(filename);
+
+    TraceReplay trace_replay(filename);
+    trace_replay.add_eval_callback(eval_callback);
+    EXPECT_THROW(trace_replay.run(), std::runtime_error);
+    std::remove(filename.c_str());
+}
+
+TEST(TraceReplay, InvalidFile)
+{
+    std::string filename = "replay_test_invalid.trace";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "not a trace";
+    }
+    EXPECT_THROW(TraceReplay trace_replay(filename), std::runtime_error);
+    std::remove(filename.c_str());
+    EXPECT_THROW(TraceReplay trace_replay(filename), std::runtime_error);
+}
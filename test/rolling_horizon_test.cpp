@@ -0,0 +1,53 @@
+#include "knitrocpp/rolling_horizon.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace knitrocpp;
+
+TEST(RollingHorizon, OnlyChangedEntriesAreSent)
+{
+    Context knitro_context;
+    knitro_context.enable_structure_mirror();
+    std::vector<VariableId> variable_ids = knitro_context.add_vars(3);
+    std::vector<ConstraintId> constraint_ids = knitro_context.add_cons(3);
+    RollingHorizon rolling_horizon(
+            knitro_context,
+            {{variable_ids[0]}, {variable_ids[1]}, {variable_ids[2]}},
+            {{constraint_ids[0]}, {constraint_ids[1]}, {constraint_ids[2]}});
+
+    // First cycle: everything is sent.
+    EXPECT_EQ(rolling_horizon.update_var_bounds(
+                variable_ids,
+                {0.0, 0.0, 0.0},
+                {1.0, 2.0, 3.0}), (std::size_t)6);
+    EXPECT_EQ(rolling_horizon.update_con_constants(
+                constraint_ids,
+                {1.0, 2.0, 3.0}), (std::size_t)3);
+
+    // Next cycle: only the changes are sent.
+    EXPECT_EQ(rolling_horizon.update_var_bounds(
+                variable_ids,
+                {0.0, 0.5, 0.0},
+                {1.0, 2.0, 4.0}), (std::size_t)2);
+    EXPECT_EQ(rolling_horizon.update_con_constants(
+                constraint_ids,
+                {2.0, 3.0, 3.0}), (std::size_t)2);
+    EXPECT_EQ(rolling_horizon.update_con_constants(
+                constraint_ids,
+                {2.0, 3.0, 3.0}), (std::size_t)0);
+
+    const Model& model = knitro_context.structure_mirror();
+    EXPECT_EQ(model.variable_lower_bounds, (std::vector<double>{0.0, 0.5, 0.0}));
+    EXPECT_EQ(model.variable_upper_bounds, (std::vector<double>{1.0, 2.0, 4.0}));
+    EXPECT_EQ(model.constraint_constants, (std::vector<double>{2.0, 3.0, 3.0}));
+}
+
+TEST(RollingHorizon, MismatchedSizes)
+{
+    Context knitro_context;
+    std::vector<ConstraintId> constraint_ids = knitro_context.add_cons(2);
+    RollingHorizon rolling_horizon(knitro_context, {});
+    EXPECT_THROW(
+            rolling_horizon.update_con_constants(constraint_ids, {1.0}),
+            std::runtime_error);
+}
@@ -0,0 +1,96 @@
+#include "knitrocpp/scaling.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace knitrocpp;
+
+namespace
+{
+
+CoefficientRange scaled_range(
+        const std::vector<std::size_t>& row_ids,
+        const std::vector<std::size_t>& column_ids,
+        const std::vector<double>& values,
+        const std::vector<double>& row_factors,
+        const std::vector<double>& column_factors)
+{
+    CoefficientRange range;
+    for (std::size_t pos = 0; pos < values.size(); ++pos)
+        range.add(row_factors[row_ids[pos]] * values[pos] * column_factors[column_ids[pos]]);
+    return range;
+}
+
+}
+
+TEST(Scaling, GeometricMeanRankOne)
+{
+    // a_ij = r_i * c_j with r = (1e3, 1e-3) and c = (1e2, 1e-4): the
+    // coefficients span 12 orders of magnitude but the matrix can be scaled
+    // to all ones.
+    std::vector<std::size_t> row_ids = {0, 0, 1, 1};
+    std::vector<std::size_t> column_ids = {0, 1, 0, 1};
+    std::vector<double> values = {1e5, -1e-1, 1e-1, 1e-7};
+    CoefficientRange range_before;
+    for (double value: values)
+        range_before.add(value);
+    EXPECT_DOUBLE_EQ(range_before.ratio(), 1e12);
+
+    ScalingParameters parameters;
+    parameters.round_to_power_of_two = false;
+    std::vector<double> row_factors;
+    std::vector<double> column_factors;
+    compute_geometric_mean_scaling(
+            2, 2, row_ids, column_ids, values, parameters,
+            row_factors, column_factors);
+    ASSERT_EQ(row_factors.size(), (std::size_t)2);
+    ASSERT_EQ(column_factors.size(), (std::size_t)2);
+    EXPECT_NEAR(scaled_range(row_ids, column_ids, values, row_factors, column_factors).ratio(), 1.0, 1e-9);
+
+    // Rounding each factor to a power of 2 changes it by at most a factor
+    // sqrt(2).
+    parameters.round_to_power_of_two = true;
+    compute_geometric_mean_scaling(
+            2, 2, row_ids, column_ids, values, parameters,
+            row_factors, column_factors);
+    for (double factor: row_factors)
+        EXPECT_DOUBLE_EQ(std::exp2(std::round(std::log2(factor))), factor);
+    for (double factor: column_factors)
+        EXPECT_DOUBLE_EQ(std::exp2(std::round(std::log2(factor))), factor);
+    EXPECT_LE(scaled_range(row_ids, column_ids, values, row_factors, column_factors).ratio(), 4.0);
+}
+
+TEST(Scaling, GeometricMeanFactorBounds)
+{
+    std::vector<std::size_t> row_ids = {0};
+    std::vector<std::size_t> column_ids = {0};
+    std::vector<double> values = {1e12};
+    ScalingParameters parameters;
+    parameters.round_to_power_of_two = false;
+    parameters.minimum_factor = 1e-2;
+    std::vector<double> row_factors;
+    std::vector<double> column_factors;
+    compute_geometric_mean_scaling(
+            1, 1, row_ids, column_ids, values, parameters,
+            row_factors, column_factors);
+    EXPECT_GE(row_factors[0], 1e-2);
+    EXPECT_GE(column_factors[0], 1e-2);
+}
+
+TEST(Scaling, ApplyScalingSquareTerm)
+{
+    // c0 = 3 x0^2 + x1 and f = 2 x0^2: at x0 = 5, dc0/dx0 = 30 and
+    // df/dx0 = 20.
+    Context knitro_context;
+    knitro_context.enable_structure_mirror();
+    std::vector<VariableId> variable_ids = knitro_context.add_vars(2);
+    ConstraintId constraint_id = knitro_context.add_con();
+    knitro_context.add_con_quadratic_term(constraint_id, variable_ids[0], variable_ids[0], 3.0);
+    knitro_context.add_con_linear_term(constraint_id, variable_ids[1], 1.0);
+    knitro_context.add_obj_quadratic_term(variable_ids[0], variable_ids[0], 2.0);
+
+    ScalingOutput output = apply_scaling(knitro_context, ScalingParameters(), {5.0, 0.0});
+    EXPECT_DOUBLE_EQ(output.jacobian_range_before.maximum, 30.0);
+    EXPECT_DOUBLE_EQ(output.jacobian_range_before.minimum, 1.0);
+    EXPECT_DOUBLE_EQ(output.objective_range_before.maximum, 20.0);
+    EXPECT_DOUBLE_EQ(output.objective_range_before.minimum, 20.0);
+}
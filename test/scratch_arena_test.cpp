@@ -0,0 +1,83 @@
+#include "knitrocpp/scratch_arena.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+using namespace knitrocpp;
+
+TEST(ScratchArena, Allocate)
+{
+    ScratchArena arena;
+    double* values = arena.allocate<double>(10);
+    char* characters = arena.allocate<char>(3);
+    int* integers = arena.allocate<int>(5);
+    EXPECT_EQ((std::uintptr_t)values % alignof(double), (std::uintptr_t)0);
+    EXPECT_EQ((std::uintptr_t)integers % alignof(int), (std::uintptr_t)0);
+    EXPECT_GE((char*)integers, characters + 3);
+    arena.reset();
+    EXPECT_EQ(arena.allocate<double>(10), values);
+}
+
+TEST(ScratchArena, ResetAfterSeveralChunks)
+{
+    ScratchArena arena;
+    arena.allocate<char>(3000);
+    arena.allocate<char>(3000);
+    std::size_t high_water_mark = arena.high_water_mark();
+    EXPECT_GE(high_water_mark, (std::size_t)6000);
+    arena.reset();
+    // A single chunk now holds the same allocations.
+    char* first = arena.allocate<char>(3000);
+    char* second = arena.allocate<char>(3000);
+    EXPECT_EQ(second, first + 3000);
+    EXPECT_EQ(arena.high_water_mark(), high_water_mark);
+}
+
+/** Call a wrapped callback for a thread identifier. */
+void call(
+        const Context& knitro_context,
+        const Context::EvalCallback& callback,
+        int thread_id)
+{
+    KN_eval_request eval_request = {};
+    eval_request.threadID = thread_id;
+    KN_eval_result eval_result = {};
+    callback(knitro_context, nullptr, &eval_request, &eval_result);
+}
+
+TEST(ScratchArena, ArenasOfCallbacksAreNotShared)
+{
+    Context knitro_context;
+    ScratchArena* received_arena = nullptr;
+    auto callback_function = [&received_arena](
+            const Context&,
+            CB_context_ptr,
+            KN_eval_request_ptr const,
+            KN_eval_result_ptr const,
+            ScratchArena& arena)
+    {
+        received_arena = &arena;
+        return 0;
+    };
+    Context::EvalCallback callback_1 = with_scratch_arenas(callback_function);
+    Context::EvalCallback callback_2 = with_scratch_arenas(callback_function);
+    auto arena = [&](const Context::EvalCallback& callback, int thread_id)
+    {
+        call(knitro_context, callback, thread_id);
+        return received_arena;
+    };
+
+    // Preallocated arenas.
+    EXPECT_NE(arena(callback_1, 0), arena(callback_1, 1));
+    EXPECT_NE(arena(callback_1, 0), arena(callback_2, 0));
+    EXPECT_EQ(arena(callback_1, 0), arena(callback_1, 0));
+
+    // Arenas of thread identifiers beyond the preallocated arenas.
+    int thread_id = 1 << 20;
+    ScratchArena* arena_1 = arena(callback_1, thread_id);
+    ScratchArena* arena_2 = arena(callback_2, thread_id);
+    EXPECT_NE(arena_1, arena_2);
+    EXPECT_EQ(arena(callback_1, thread_id), arena_1);
+    EXPECT_NE(arena(callback_1, thread_id + 1), arena_1);
+}
@@ -0,0 +1,106 @@
+#include "knitrocpp/solve_farm.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace knitrocpp;
+
+TEST(SolveFarm, SerializeModelRoundTrip)
+{
+    Model model;
+    model.objective_goal = KN_OBJGOAL_MAXIMIZE;
+    model.objective_constant = 1.5;
+    for (int variable_id = 0; variable_id < 3; ++variable_id)
+        model.add_var();
+    model.variable_lower_bounds = {0.0, -1.0, -KN_INFINITY};
+    model.variable_upper_bounds = {1.0, 2.0, KN_INFINITY};
+    model.variable_types[1] = KN_VARTYPE_INTEGER;
+    model.add_con();
+    model.add_con();
+    model.constraint_lower_bounds = {-KN_INFINITY, 1.0};
+    model.constraint_upper_bounds = {4.0, 1.0};
+    model.constraint_constants = {0.5, -0.5};
+    model.add_obj_linear_term(0, 2.0);
+    model.add_obj_quadratic_term(1, 2, -3.0);
+    model.add_con_linear_term(0, 1, 4.0);
+    model.add_con_linear_term(1, 2, 5.0);
+    model.add_con_quadratic_term(1, 0, 0, 6.0);
+
+    std::vector<char> buffer = serialize_model(model);
+    Model model_copy = deserialize_model(buffer.data(), buffer.size());
+    EXPECT_EQ(model_copy.objective_goal, model.objective_goal);
+    EXPECT_EQ(model_copy.objective_constant, model.objective_constant);
+    EXPECT_EQ(model_copy.objective_linear_variable_ids, model.objective_linear_variable_ids);
+    EXPECT_EQ(model_copy.objective_linear_coefficients, model.objective_linear_coefficients);
+    EXPECT_EQ(model_copy.objective_quadratic_variable_ids_1, model.objective_quadratic_variable_ids_1);
+    EXPECT_EQ(model_copy.objective_quadratic_variable_ids_2, model.objective_quadratic_variable_ids_2);
+    EXPECT_EQ(model_copy.objective_quadratic_coefficients, model.objective_quadratic_coefficients);
+    EXPECT_EQ(model_copy.variable_lower_bounds, model.variable_lower_bounds);
+    EXPECT_EQ(model_copy.variable_upper_bounds, model.variable_upper_bounds);
+    EXPECT_EQ(model_copy.variable_types, model.variable_types);
+    EXPECT_EQ(model_copy.constraint_lower_bounds, model.constraint_lower_bounds);
+    EXPECT_EQ(model_copy.constraint_upper_bounds, model.constraint_upper_bounds);
+    EXPECT_EQ(model_copy.constraint_constants, model.constraint_constants);
+    EXPECT_EQ(model_copy.constraint_linear_constraint_ids, model.constraint_linear_constraint_ids);
+    EXPECT_EQ(model_copy.constraint_linear_variable_ids, model.constraint_linear_variable_ids);
+    EXPECT_EQ(model_copy.constraint_linear_coefficients, model.constraint_linear_coefficients);
+    EXPECT_EQ(model_copy.constraint_quadratic_constraint_ids, model.constraint_quadratic_constraint_ids);
+    EXPECT_EQ(model_copy.constraint_quadratic_variable_ids_1, model.constraint_quadratic_variable_ids_1);
+    EXPECT_EQ(model_copy.constraint_quadratic_variable_ids_2, model.constraint_quadratic_variable_ids_2);
+    EXPECT_EQ(model_copy.constraint_quadratic_coefficients, model.constraint_quadratic_coefficients);
+}
+
+TEST(SolveFarm, DeserializeInvalidModel)
+{
+    Model model;
+    model.add_var();
+    model.add_obj_linear_term(0, 1.0);
+    std::vector<char> buffer = serialize_model(model);
+    EXPECT_THROW(deserialize_model(buffer.data(), buffer.size() - 1), std::runtime_error);
+    buffer[0] = 'X';
+    EXPECT_THROW(deserialize_model(buffer.data(), buffer.size()), std::runtime_error);
+}
+
+TEST(SolveFarm, Scenarios)
+{
+    // min x0 + x1, 0 <= x0, x1 <= 10; scenario k sets the lower bound of
+    // x0 to k.
+    Model model;
+    model.add_var();
+    model.add_var();
+    model.variable_lower_bounds = {0.0, 0.0};
+    model.variable_upper_bounds = {10.0, 10.0};
+    model.add_obj_linear_term(0, 1.0);
+    model.add_obj_linear_term(1, 1.0);
+
+    std::vector<SolveFarmScenario> scenarios(6);
+    for (std::size_t scenario_id = 0; scenario_id < scenarios.size(); ++scenario_id) {
+        SolveFarmScenario& scenario = scenarios[scenario_id];
+        if (scenario_id % 2 == 1)
+            continue;
+        scenario.variable_ids = {0};
+        scenario.variable_lower_bounds = {(double)scenario_id};
+        scenario.variable_upper_bounds = {10.0};
+    }
+    SolveFarmParameters parameters;
+    parameters.number_of_processes = 2;
+    std::vector<SolveFarmResult> results = solve_farm(
+            model,
+            scenarios,
+            [](Context& knitro_context)
+            {
+                knitro_context.set_int_param(KN_PARAM_OUTLEV, KN_OUTLEV_NONE);
+            },
+            parameters);
+
+    ASSERT_EQ(results.size(), scenarios.size());
+    for (std::size_t scenario_id = 0; scenario_id < scenarios.size(); ++scenario_id) {
+        const SolveFarmResult& result = results[scenario_id];
+        ASSERT_TRUE(result.completed);
+        EXPECT_EQ(result.status, 0);
+        // The bounds of the previous scenario of the worker are restored.
+        double expected = (scenario_id % 2 == 0)? (double)scenario_id: 0.0;
+        EXPECT_NEAR(result.objective_value, expected, 1e-6);
+        ASSERT_EQ(result.primal_values.size(), (std::size_t)2);
+        EXPECT_NEAR(result.primal_values[0], expected, 1e-6);
+    }
+}